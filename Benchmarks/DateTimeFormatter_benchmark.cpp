@@ -0,0 +1,77 @@
+/*
+ *  DateTimeFormatter_benchmark.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/Log/LogFormatStream.hpp>
+#include <Misc/DateTimeFormatter.hpp>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+constexpr int iterationsCount = 2'000'000;
+
+// the default log prefix rendered like DateTimeFormatter did before the cache: localtime and iostreams for every line
+void printTimeStreams(std::ostream& stream, const std::chrono::system_clock::time_point& timePoint)
+{
+    using Ms = std::chrono::milliseconds;
+
+    const auto timeValue    = std::chrono::system_clock::to_time_t(timePoint);
+    const auto milliseconds = std::chrono::duration_cast<Ms>(timePoint.time_since_epoch()) % 1000;
+    std::tm parsedTime;
+#if defined(ENGINE_OS_WINDOWS)
+    localtime_s(&parsedTime, &timeValue);
+#else
+    localtime_r(&timeValue, &parsedTime);
+#endif
+
+    const char previousCharacter = stream.fill('0');
+    stream << parsedTime.tm_year + 1900 << '.' << std::setw(2) << parsedTime.tm_mon + 1 << '.' << std::setw(2) << parsedTime.tm_mday << ' '
+           << std::setw(2) << parsedTime.tm_hour << ':' << std::setw(2) << parsedTime.tm_min << ':' << std::setw(2) << parsedTime.tm_sec << '.'
+           << std::setw(3) << milliseconds.count();
+    stream.fill(previousCharacter);
+}
+
+template<typename Function>
+void run(const char* name, Function&& function)
+{
+    LogFormatStream stream;
+    std::size_t printedSize = 0;
+
+    // about 100 log lines per millisecond, so the second changes every 100000 lines
+    const auto start     = std::chrono::system_clock::now();
+    const auto timeBegin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterationsCount; ++i)
+    {
+        stream.clear();
+        function(stream, start + std::chrono::microseconds(i * 10));
+        printedSize += stream.size();
+    }
+    const auto timeEnd = std::chrono::steady_clock::now();
+
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeEnd - timeBegin).count();
+    std::cout << std::left << std::setw(20) << name << std::right << std::setw(8) << std::fixed << std::setprecision(1)
+              << static_cast<double>(nanoseconds) / iterationsCount << " ns per timestamp (" << printedSize << " bytes)" << std::endl;
+}
+
+} // namespace
+
+int main()
+{
+    // the same specifiers interpreted at runtime
+    Kompot::DateTimeFormat runtimeFormat = Kompot::DefaultDateTimeFormat{};
+    runtimeFormat.compiledRender         = nullptr;
+
+    Kompot::DateTimeFormatter formatter;
+    formatter.setFormat(runtimeFormat);
+
+    Kompot::DateTimeFormatter compiledFormatter;
+
+    run("iostreams", [](LogFormatStream& stream, auto timePoint) { printTimeStreams(stream, timePoint); });
+    run("printTimeUncached", [&formatter](LogFormatStream& stream, auto timePoint) { formatter.printTimeUncached(stream, timePoint); });
+    run("printTime", [&formatter](LogFormatStream& stream, auto timePoint) { formatter.printTime(stream, timePoint); });
+    run("printTime compiled", [&compiledFormatter](LogFormatStream& stream, auto timePoint) { compiledFormatter.printTime(stream, timePoint); });
+    return 0;
+}
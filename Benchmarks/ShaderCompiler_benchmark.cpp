@@ -0,0 +1,101 @@
+/*
+ *  ShaderCompiler_benchmark.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderCompiler.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+namespace fs = std::filesystem;
+
+// every shader of the directory is compiled this many times, so a batch is big enough to load all cores
+constexpr int copiesCount = 32;
+
+std::vector<fs::path> makeJobs(const fs::path& shadersDirectory)
+{
+    std::vector<fs::path> jobs;
+    for (const auto& entry : fs::directory_iterator(shadersDirectory))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+        jobs.insert(jobs.end(), copiesCount, entry.path());
+    }
+    return jobs;
+}
+
+void run(uint32_t threadsCount, const std::vector<fs::path>& jobs, double singleThreadSeconds)
+{
+    auto& compiler = Kompot::Rendering::ShaderCompiler::get();
+    compiler.setThreadsCount(threadsCount);
+
+    const auto timeBegin    = std::chrono::steady_clock::now();
+    auto results            = compiler.compileAll(jobs);
+    std::size_t failedCount = 0;
+    for (auto& result : results)
+    {
+        failedCount += result.get().code.empty() ? 1 : 0;
+    }
+    const auto timeEnd = std::chrono::steady_clock::now();
+
+    const double seconds = std::chrono::duration<double>(timeEnd - timeBegin).count();
+    std::cout << std::setw(3) << threadsCount << " threads " << std::setw(8) << std::fixed << std::setprecision(1) << jobs.size() / seconds
+              << " shaders/s, speedup " << std::setprecision(2) << (singleThreadSeconds > 0.0 ? singleThreadSeconds / seconds : 1.0);
+    if (failedCount > 0)
+    {
+        std::cout << " (" << failedCount << " failed)";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+// usage: ShaderCompilerBenchmark [shaders directory], the default is Shaders/ of the working directory
+int main(int argc, char** argv)
+{
+    const fs::path shadersDirectory = argc > 1 ? argv[1] : "Shaders";
+    if (!fs::is_directory(shadersDirectory))
+    {
+        std::cerr << shadersDirectory << " is not a directory" << std::endl;
+        return 1;
+    }
+
+    const auto jobs = makeJobs(shadersDirectory);
+    if (jobs.empty())
+    {
+        std::cerr << "No shaders in " << shadersDirectory << std::endl;
+        return 1;
+    }
+    std::cout << jobs.size() << " shaders per batch" << std::endl;
+
+    auto& compiler = Kompot::Rendering::ShaderCompiler::get();
+
+    // warm-up, glslang builds its symbol tables on the first parse
+    compiler.setThreadsCount(1);
+    for (auto& result : compiler.compileAll({jobs.front()}))
+    {
+        result.wait();
+    }
+
+    const auto timeBegin = std::chrono::steady_clock::now();
+    for (const auto& job : jobs)
+    {
+        compiler.compile(job);
+    }
+    const double singleThreadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeBegin).count();
+    std::cout << "compile() " << std::fixed << std::setprecision(1) << jobs.size() / singleThreadSeconds << " shaders/s" << std::endl;
+
+    const uint32_t coresCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threadsCount = 1; threadsCount < coresCount; threadsCount *= 2)
+    {
+        run(threadsCount, jobs, singleThreadSeconds);
+    }
+    run(coresCount, jobs, singleThreadSeconds);
+    return 0;
+}
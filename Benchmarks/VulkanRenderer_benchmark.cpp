@@ -0,0 +1,108 @@
+/*
+ *  VulkanRenderer_benchmark.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/ClientSubsystem/Renderer/Vulkan/VulkanRenderer.hpp>
+#include <Engine/Log/Log.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+namespace
+{
+using Kompot::Rendering::Vulkan::VulkanFrameReadback;
+
+constexpr uint32_t width         = 1280;
+constexpr uint32_t height        = 720;
+constexpr int defaultFramesCount = 1000;
+
+// binary PPM, viewable almost everywhere and easy to compare with a reference frame
+bool writePpm(const char* path, const VulkanFrameReadback& readback)
+{
+    if (readback.format != vk::Format::eB8G8R8A8Srgb && readback.format != vk::Format::eB8G8R8A8Unorm)
+    {
+        std::cerr << "Unsupported readback format " << vk::to_string(readback.format) << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << readback.width << " " << readback.height << "\n255\n";
+    for (std::size_t i = 0; i + 3 < readback.pixels.size(); i += 4)
+    {
+        const char rgb[] = {
+                static_cast<char>(readback.pixels[i + 2]), static_cast<char>(readback.pixels[i + 1]), static_cast<char>(readback.pixels[i])};
+        file.write(rgb, sizeof(rgb));
+    }
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+/*
+ * Draws frames with a headless renderer, so it runs without a display, e.g. on lavapipe:
+ *     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json VulkanRendererBenchmark
+ * usage: VulkanRendererBenchmark [frames count] [last frame.ppm] [gpu trace.json], started from the directory with Shaders/
+ */
+int main(int argc, char** argv)
+{
+    const int framesCount = argc > 1 ? std::atoi(argv[1]) : defaultFramesCount;
+    if (framesCount <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [frames count] [last frame.ppm] [gpu trace.json]" << std::endl;
+        return 1;
+    }
+
+    Log::getInstance().configure(LogConfig{});
+
+    using namespace Kompot::Rendering::Vulkan;
+    VulkanRenderer renderer(VulkanRendererConfig{.offscreenExtent = vk::Extent2D{width, height}});
+
+    // warm-up, the first frames wait for the driver to finish the pipeline
+    for (int i = 0; i < 10; ++i)
+    {
+        renderer.drawOffscreen();
+    }
+    renderer.readbackFrame();
+
+    const auto timeBegin = std::chrono::steady_clock::now();
+    for (int i = 0; i < framesCount; ++i)
+    {
+        renderer.drawOffscreen();
+    }
+    // waits for the last frame, so the time includes the GPU work
+    const auto readback  = renderer.readbackFrame();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeBegin).count();
+
+    std::cout << framesCount << " frames " << width << "x" << height << ": " << std::fixed << std::setprecision(1) << framesCount / seconds
+              << " frames/s, " << std::setprecision(3) << seconds * 1000.0 / framesCount << " ms/frame" << std::endl;
+
+    // the profiler keeps the last frames only, they're measured without the warm-up
+    const auto& gpuProfiler = renderer.getGpuProfiler();
+    if (gpuProfiler.isSupported())
+    {
+        std::cout << "GPU: " << gpuProfiler.getAverageFrameMs() << " ms/frame of the last " << gpuProfiler.getFrames().size() << " frames"
+                  << std::endl;
+    }
+
+    if (readback.pixels.empty())
+    {
+        std::cerr << "Failed to read the last frame back" << std::endl;
+        return 1;
+    }
+    if (argc > 2 && !writePpm(argv[2], readback))
+    {
+        std::cerr << "Failed to write " << argv[2] << std::endl;
+        return 1;
+    }
+    if (argc > 3 && !gpuProfiler.writeTrace(argv[3]))
+    {
+        std::cerr << "Failed to write " << argv[3] << std::endl;
+        return 1;
+    }
+    return 0;
+}
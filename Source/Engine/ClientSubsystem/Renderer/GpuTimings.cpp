@@ -0,0 +1,110 @@
+/*
+ *  GpuTimings.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "GpuTimings.hpp"
+#include <algorithm>
+#include <iomanip>
+
+using namespace Kompot::Rendering;
+
+namespace
+{
+uint64_t getTimestampMask(uint32_t timestampValidBits)
+{
+    return timestampValidBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << timestampValidBits) - 1;
+}
+
+// the names are engine literals, but a quote would still break the whole file
+void writeJsonString(std::ostream& output, std::string_view string)
+{
+    output << '"';
+    for (const char character : string)
+    {
+        if (character == '"' || character == '\\')
+        {
+            output << '\\' << character;
+        }
+        else if (static_cast<unsigned char>(character) < 0x20)
+        {
+            output << ' ';
+        }
+        else
+        {
+            output << character;
+        }
+    }
+    output << '"';
+}
+
+} // namespace
+
+GpuFrameTimings Kompot::Rendering::getGpuFrameTimings(
+        std::size_t frameNumber,
+        std::span<const GpuTimestampScope> scopes,
+        std::span<const uint64_t> timestamps,
+        double timestampPeriod,
+        uint32_t timestampValidBits)
+{
+    GpuFrameTimings frame;
+    frame.frameNumber = frameNumber;
+    if (scopes.empty() || scopes.front().beginQuery >= timestamps.size() || timestampValidBits == 0)
+    {
+        return frame;
+    }
+
+    const uint64_t mask       = getTimestampMask(timestampValidBits);
+    const double msPerTick    = timestampPeriod / 1'000'000.0;
+    const uint64_t frameBegin = timestamps[scopes.front().beginQuery] & mask;
+
+    frame.beginUs = static_cast<double>(frameBegin) * timestampPeriod / 1'000.0;
+    frame.scopes.reserve(scopes.size());
+    for (const GpuTimestampScope& scope : scopes)
+    {
+        if (scope.beginQuery >= timestamps.size() || scope.endQuery >= timestamps.size())
+        {
+            continue;
+        }
+
+        // the subtraction modulo 2^validBits stays correct if the counter wraps once between the timestamps
+        const uint64_t begin = timestamps[scope.beginQuery] & mask;
+        const uint64_t end   = timestamps[scope.endQuery] & mask;
+
+        GpuScopeTiming& timing = frame.scopes.emplace_back();
+        timing.name            = scope.name;
+        timing.depth           = scope.depth;
+        timing.beginMs         = static_cast<double>((begin - frameBegin) & mask) * msPerTick;
+        timing.durationMs      = static_cast<double>((end - begin) & mask) * msPerTick;
+        frame.durationMs       = std::max(frame.durationMs, timing.beginMs + timing.durationMs);
+    }
+    return frame;
+}
+
+void Kompot::Rendering::writeChromeTrace(std::ostream& output, std::span<const GpuFrameTimings> frames)
+{
+    const auto flags     = output.flags();
+    const auto precision = output.precision();
+    output << std::fixed << std::setprecision(3);
+
+    output << "{\"traceEvents\":[";
+    bool isFirst = true;
+    for (const GpuFrameTimings& frame : frames)
+    {
+        for (const GpuScopeTiming& scope : frame.scopes)
+        {
+            output << (isFirst ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(output, scope.name);
+            // the format counts in microseconds
+            output << ",\"cat\":\"GPU\",\"ph\":\"X\",\"ts\":" << frame.beginUs + scope.beginMs * 1'000.0
+                   << ",\"dur\":" << scope.durationMs * 1'000.0 << ",\"pid\":0,\"tid\":1,\"args\":{\"frame\":" << frame.frameNumber
+                   << ",\"depth\":" << scope.depth << "}}";
+            isFirst = false;
+        }
+    }
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    output.flags(flags);
+    output.precision(precision);
+}
@@ -0,0 +1,59 @@
+/*
+ *  GpuTimings.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Kompot::Rendering
+{
+// a measured part of a frame, it's written to the command buffer as two timestamp queries
+struct GpuTimestampScope
+{
+    std::string_view name; // must outlive the frame, e.g. a literal
+    uint32_t depth      = 0; // the number of the scopes it's nested in
+    uint32_t beginQuery = 0;
+    uint32_t endQuery   = 0;
+};
+
+struct GpuScopeTiming
+{
+    std::string name;
+    uint32_t depth    = 0;
+    double beginMs    = 0.0; // since the beginning of the frame
+    double durationMs = 0.0;
+};
+
+struct GpuFrameTimings
+{
+    std::size_t frameNumber = 0;
+    double beginUs          = 0.0; // GPU clock, comparable between the frames of one device only
+    double durationMs       = 0.0; // from the first scope begin to the last scope end
+    std::vector<GpuScopeTiming> scopes;
+};
+
+/*
+ * Converts the timestamps of the scopes of a frame, the first scope begins the frame.
+ * timestampPeriod is nanoseconds per tick (VkPhysicalDeviceLimits::timestampPeriod), only timestampValidBits
+ * of a timestamp are meaningful (VkQueueFamilyProperties::timestampValidBits), so the counter may wrap within a frame.
+ */
+GpuFrameTimings getGpuFrameTimings(
+        std::size_t frameNumber,
+        std::span<const GpuTimestampScope> scopes,
+        std::span<const uint64_t> timestamps,
+        double timestampPeriod,
+        uint32_t timestampValidBits);
+
+// Trace Event Format, opens in chrome://tracing and Perfetto. Each scope is a complete event of the GPU thread
+void writeChromeTrace(std::ostream& output, std::span<const GpuFrameTimings> frames);
+
+} // namespace Kompot::Rendering
@@ -42,6 +42,10 @@ class IRenderer
 public:
     virtual ~IRenderer(){};
 
+    // blocks until the next frame can be recorded if the renderer waits for it there, call right before sampling the input
+    virtual void waitForNextFrame()
+    {
+    }
     virtual void draw(Window* window) = 0;
 
     virtual void notifyWindowResized(Window* window)                         = 0;
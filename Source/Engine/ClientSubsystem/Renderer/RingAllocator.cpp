@@ -0,0 +1,84 @@
+/*
+ *  RingAllocator.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "RingAllocator.hpp"
+
+using namespace Kompot::Rendering;
+
+namespace
+{
+std::size_t alignUp(std::size_t offset, std::size_t alignment)
+{
+    return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+}
+} // namespace
+
+RingAllocator::RingAllocator(std::size_t capacity)
+{
+    reset(capacity);
+}
+
+void RingAllocator::reset(std::size_t capacity)
+{
+    mCapacity         = capacity;
+    mHead             = 0;
+    mTail             = 0;
+    mAllocationsCount = 0;
+    mReleasedCount    = 0;
+}
+
+std::optional<std::size_t> RingAllocator::allocate(std::size_t size, std::size_t alignment)
+{
+    if (size == 0 || size > mCapacity)
+    {
+        return std::nullopt;
+    }
+
+    if (isEmpty())
+    {
+        // nothing is in use, so the whole capacity is contiguous again
+        mHead = 0;
+        mTail = 0;
+    }
+
+    std::optional<std::size_t> offset;
+    const std::size_t alignedHead = alignUp(mHead, alignment);
+    if (isEmpty() || mHead > mTail)
+    {
+        // [mTail, mHead) is in use, the free space is at the end and before mTail
+        if (alignedHead <= mCapacity && size <= mCapacity - alignedHead)
+        {
+            offset = alignedHead;
+        }
+        else if (size <= mTail)
+        {
+            offset = 0;
+        }
+    }
+    else if (mHead < mTail && alignedHead <= mTail && size <= mTail - alignedHead)
+    {
+        // wrapped, the free space is [mHead, mTail)
+        offset = alignedHead;
+    }
+
+    if (offset)
+    {
+        mHead = *offset + size;
+        ++mAllocationsCount;
+    }
+    return offset;
+}
+
+void RingAllocator::release(const Marker& marker)
+{
+    if (marker.allocationsCount <= mReleasedCount || marker.allocationsCount > mAllocationsCount)
+    {
+        return;
+    }
+
+    mTail          = marker.offset;
+    mReleasedCount = marker.allocationsCount;
+}
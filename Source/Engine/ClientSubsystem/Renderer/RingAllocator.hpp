@@ -0,0 +1,63 @@
+/*
+ *  RingAllocator.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+
+namespace Kompot::Rendering
+{
+/*
+ * Offsets in a buffer used as a ring: allocations are released in the order they were made,
+ * all at once up to a marker, e.g. when the GPU has finished the batch of copies reading them.
+ * It knows nothing about the buffer itself, so the staging memory can be mapped once and kept.
+ */
+class RingAllocator
+{
+public:
+    // the end of the allocations made so far
+    struct Marker
+    {
+        std::size_t offset           = 0;
+        std::size_t allocationsCount = 0;
+    };
+
+    explicit RingAllocator(std::size_t capacity = 0);
+
+    // releases everything
+    void reset(std::size_t capacity);
+
+    // the alignment doesn't have to be a power of two, e.g. a texel size of 12 bytes
+    std::optional<std::size_t> allocate(std::size_t size, std::size_t alignment);
+
+    Marker getMarker() const
+    {
+        return {mHead, mAllocationsCount};
+    }
+
+    // releases the allocations made before the marker was taken
+    void release(const Marker& marker);
+
+    bool isEmpty() const
+    {
+        return mReleasedCount == mAllocationsCount;
+    }
+
+    std::size_t getCapacity() const
+    {
+        return mCapacity;
+    }
+
+private:
+    std::size_t mCapacity         = 0;
+    std::size_t mHead             = 0; // the next allocation starts here or at 0 if it doesn't fit till the end
+    std::size_t mTail             = 0; // the oldest allocation in use starts here
+    std::size_t mAllocationsCount = 0;
+    std::size_t mReleasedCount    = 0;
+};
+
+} // namespace Kompot::Rendering
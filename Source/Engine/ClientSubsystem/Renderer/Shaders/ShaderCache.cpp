@@ -0,0 +1,199 @@
+/*
+ *  ShaderCache.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "ShaderCache.hpp"
+#include <Engine/Log/Log.hpp>
+#include <Misc/Hash.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace Kompot::Rendering;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool isEntryValid(const ShaderCacheEntry& entry, std::size_t fileSize)
+{
+    return entry.codeOffset % ShaderCacheArchive::codeAlignment == 0 && entry.codeSize % sizeof(uint32_t) == 0 &&
+           entry.codeOffset <= fileSize && entry.codeSize <= fileSize - entry.codeOffset && entry.nameOffset <= fileSize &&
+           entry.nameSize <= fileSize - entry.nameOffset && entry.dependenciesSize <= fileSize - entry.nameOffset - entry.nameSize;
+}
+
+bool isOrdered(const ShaderCacheEntry& left, const ShaderCacheEntry& right)
+{
+    return left.nameHash < right.nameHash || (left.nameHash == right.nameHash && left.definesKey <= right.definesKey);
+}
+} // namespace
+
+bool ShaderCacheArchive::open(const fs::path& path)
+{
+    close();
+    if (!mFile.openForReading(path))
+    {
+        return false;
+    }
+
+    ShaderCacheHeader header;
+    const ShaderCacheHeader expectedHeader;
+    if (mFile.size() < sizeof(header))
+    {
+        close();
+        return false;
+    }
+    std::memcpy(&header, mFile.data(), sizeof(header));
+    if (header.magic != expectedHeader.magic || header.version != expectedHeader.version ||
+        header.entriesCount > (mFile.size() - sizeof(header)) / sizeof(ShaderCacheEntry))
+    {
+        close();
+        return false;
+    }
+
+    mEntries = {reinterpret_cast<const ShaderCacheEntry*>(mFile.data() + sizeof(header)), header.entriesCount};
+    for (std::size_t i = 0; i < mEntries.size(); ++i)
+    {
+        if (!isEntryValid(mEntries[i], mFile.size()) || (i > 0 && !isOrdered(mEntries[i - 1], mEntries[i])))
+        {
+            ENGINE_LOG(Warning, Shader) << path << " is corrupted, the shaders will be compiled again";
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShaderCacheArchive::close()
+{
+    mEntries = {};
+    mFile.close();
+}
+
+std::optional<ShaderCacheArchive::Shader> ShaderCacheArchive::find(std::string_view name, uint64_t definesKey) const
+{
+    ShaderCacheEntry searchedEntry;
+    searchedEntry.nameHash   = Kompot::Hash::xxHash64(name);
+    searchedEntry.definesKey = definesKey;
+
+    auto entry = std::lower_bound(mEntries.begin(), mEntries.end(), searchedEntry, [](const ShaderCacheEntry& left, const ShaderCacheEntry& right) {
+        return !isOrdered(right, left);
+    });
+    for (; entry != mEntries.end() && entry->nameHash == searchedEntry.nameHash && entry->definesKey == definesKey; ++entry)
+    {
+        if (const auto shader = getShader(entry - mEntries.begin()); shader.name == name)
+        {
+            return shader;
+        }
+    }
+    return std::nullopt;
+}
+
+ShaderCacheArchive::Shader ShaderCacheArchive::getShader(std::size_t index) const
+{
+    const ShaderCacheEntry& entry = mEntries[index];
+
+    Shader shader;
+    shader.name         = {mFile.data() + entry.nameOffset, entry.nameSize};
+    shader.definesKey   = entry.definesKey;
+    shader.key          = entry.key;
+    shader.code         = {reinterpret_cast<const uint32_t*>(mFile.data() + entry.codeOffset), entry.codeSize / sizeof(uint32_t)};
+    shader.dependencies = {mFile.data() + entry.nameOffset + entry.nameSize, entry.dependenciesSize};
+    return shader;
+}
+
+std::vector<std::string_view> ShaderCacheArchive::splitDependencies(std::string_view dependencies)
+{
+    std::vector<std::string_view> paths;
+    while (!dependencies.empty())
+    {
+        const std::size_t end = dependencies.find('\0');
+        paths.push_back(dependencies.substr(0, end));
+        dependencies.remove_prefix(end == std::string_view::npos ? dependencies.size() : end + 1);
+    }
+    return paths;
+}
+
+std::string ShaderCacheArchive::joinDependencies(const std::vector<std::string>& dependencies)
+{
+    std::string joined;
+    for (const auto& dependency : dependencies)
+    {
+        joined += dependency;
+        joined += '\0';
+    }
+    return joined;
+}
+
+bool ShaderCacheArchive::write(const fs::path& path, const std::vector<Shader>& shaders)
+{
+    if (std::error_code error; !fs::create_directories(path.parent_path(), error) && error)
+    {
+        ENGINE_LOG(Error, Shader) << "Failed to create shaders cache directory: " << error.message();
+        return false;
+    }
+
+    std::vector<ShaderCacheEntry> entries(shaders.size());
+    for (std::size_t i = 0; i < shaders.size(); ++i)
+    {
+        entries[i].nameHash   = Kompot::Hash::xxHash64(shaders[i].name);
+        entries[i].definesKey = shaders[i].definesKey;
+    }
+    std::vector<std::size_t> order(shaders.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&entries](std::size_t left, std::size_t right) {
+        return !isOrdered(entries[right], entries[left]);
+    });
+
+    std::size_t fileSize = sizeof(ShaderCacheHeader) + entries.size() * sizeof(ShaderCacheEntry);
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i].key              = shaders[i].key;
+        entries[i].nameOffset       = static_cast<uint32_t>(fileSize);
+        entries[i].nameSize         = static_cast<uint32_t>(shaders[i].name.size());
+        entries[i].dependenciesSize = static_cast<uint32_t>(shaders[i].dependencies.size());
+        fileSize += shaders[i].name.size() + shaders[i].dependencies.size();
+    }
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        fileSize              = alignUp(fileSize, codeAlignment);
+        entries[i].codeOffset = fileSize;
+        entries[i].codeSize   = static_cast<uint32_t>(shaders[i].code.size_bytes());
+        fileSize += shaders[i].code.size_bytes();
+    }
+
+    Platform::MappedFile file;
+    if (!file.open(path, fileSize))
+    {
+        ENGINE_LOG(Error, Shader) << "Failed to create " << path;
+        return false;
+    }
+
+    ShaderCacheHeader header;
+    header.entriesCount = static_cast<uint32_t>(entries.size());
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    auto* sortedEntries = file.data() + sizeof(header);
+    for (const std::size_t index : order)
+    {
+        const auto& entry  = entries[index];
+        const auto& shader = shaders[index];
+        std::memcpy(sortedEntries, &entry, sizeof(entry));
+        sortedEntries += sizeof(entry);
+        std::memcpy(file.data() + entry.nameOffset, shader.name.data(), shader.name.size());
+        std::memcpy(file.data() + entry.nameOffset + entry.nameSize, shader.dependencies.data(), shader.dependencies.size());
+        std::memcpy(file.data() + entry.codeOffset, shader.code.data(), shader.code.size_bytes());
+    }
+
+    file.close(fileSize);
+    return true;
+}
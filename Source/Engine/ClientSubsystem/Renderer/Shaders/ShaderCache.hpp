@@ -0,0 +1,89 @@
+/*
+ *  ShaderCache.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <Engine/Platform/MappedFile.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Kompot::Rendering
+{
+struct ShaderCacheHeader
+{
+    uint32_t magic        = 0x4150534b; // "KSPA"
+    uint32_t version      = 4;
+    uint32_t entriesCount = 0;
+    uint32_t reserved     = 0;
+};
+static_assert(sizeof(ShaderCacheHeader) == 16, "ShaderCacheHeader is a part of the shader cache format");
+
+struct ShaderCacheEntry
+{
+    uint64_t nameHash         = 0; // entries are sorted by it, then by definesKey
+    uint64_t definesKey       = 0; // see ShaderVariant
+    uint64_t key              = 0; // see ShaderCompiler::getCacheKey
+    uint64_t codeOffset       = 0; // from the beginning of the file
+    uint32_t codeSize         = 0; // in bytes
+    uint32_t nameOffset       = 0;
+    uint32_t nameSize         = 0;
+    uint32_t dependenciesSize = 0; // the dependencies follow the name
+};
+static_assert(sizeof(ShaderCacheEntry) == 48, "ShaderCacheEntry is a part of the shader cache format");
+
+/*
+ * All compiled shaders in one file: a header, the index sorted by name hash, the names with
+ * the include dependencies and the SPIR-V blobs aligned to 16 bytes (see Docs/Shader cache format.md).
+ * The file is mapped once, lookups are a binary search in the index and return views
+ * into the mapping, so loading a shader takes neither syscalls nor copies.
+ */
+class ShaderCacheArchive
+{
+public:
+    struct Shader
+    {
+        std::string_view name;
+        uint64_t definesKey = 0;
+        uint64_t key        = 0;
+        std::span<const uint32_t> code;
+        std::string_view dependencies; // generic paths of the included files, each one terminated by '\0'
+    };
+
+    // maps the archive, returns false if it's missing or malformed, then the archive stays empty
+    bool open(const std::filesystem::path& path);
+
+    // invalidates every view returned so far
+    void close();
+
+    std::optional<Shader> find(std::string_view name, uint64_t definesKey = 0) const;
+
+    std::size_t getShadersCount() const
+    {
+        return mEntries.size();
+    }
+
+    Shader getShader(std::size_t index) const;
+
+    static std::vector<std::string_view> splitDependencies(std::string_view dependencies);
+
+    static std::string joinDependencies(const std::vector<std::string>& dependencies);
+
+    // the views may point into an open archive, the file at path must not be that archive
+    static bool write(const std::filesystem::path& path, const std::vector<Shader>& shaders);
+
+    static constexpr std::size_t codeAlignment = 16;
+
+private:
+    Platform::MappedFile mFile;
+    std::span<const ShaderCacheEntry> mEntries;
+};
+
+} // namespace Kompot::Rendering
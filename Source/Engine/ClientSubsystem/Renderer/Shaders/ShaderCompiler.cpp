@@ -6,6 +6,10 @@
 
 #include "ShaderCompiler.hpp"
 #include <glslang/SPIRV/GlslangToSpv.h>
+#include <EngineDefines.hpp>
+#include <Misc/Hash.hpp>
+#include <algorithm>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include "Engine/Log/Log.hpp"
@@ -13,13 +17,34 @@
 using namespace Kompot::Rendering;
 namespace fs = std::filesystem;
 
+// everything here is a part of the cache key
+constexpr int glslVersion      = 460;
+constexpr auto targetClient    = glslang::EShTargetVulkan_1_2;
+constexpr auto targetSpirv     = glslang::EShTargetSpv_1_4;
+constexpr auto compileMessages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+
+// glslang expands #include only with the extension enabled, shaderc enables it the same way
+constexpr auto includePreamble = "#extension GL_GOOGLE_include_directive : require\n";
+
+// deeper nesting is an include cycle, glslang itself never stops on one
+constexpr std::size_t maxInclusionDepth = 32;
+
 ShaderCompiler::ShaderCompiler()
+#ifdef ENGINE_DEBUG
+    : mOptimization(ShaderOptimization::None)
+#else
+    : mOptimization(ShaderOptimization::Performance)
+#endif
 {
     glslang::InitializeProcess();
 }
 
 ShaderCompiler::~ShaderCompiler()
 {
+    {
+        std::lock_guard<std::mutex> workersLock(mWorkersMutex);
+        stopWorkers();
+    }
     glslang::FinalizeProcess();
 }
 
@@ -161,32 +186,225 @@ inline void initResource(TBuiltInResource& resource)
     resource.limits.generalConstantMatrixVectorIndexing  = 1;
 }
 
-std::vector<uint32_t> ShaderCompiler::compile(const fs::path shaderCodePath, const std::filesystem::path cachePath)
+const TBuiltInResource& getResource()
+{
+    static const TBuiltInResource resource = [] {
+        TBuiltInResource defaultResource{};
+        initResource(defaultResource);
+        return defaultResource;
+    }();
+    return resource;
+}
+
+bool ShaderCompiler::isShaderSource(const fs::path& path)
+{
+    return detectShaderType(path) != EShLangCount;
+}
+
+bool ShaderCompiler::readSource(const fs::path& shaderCodePath, std::string& shaderText)
+{
+    std::ifstream shaderFile(shaderCodePath, std::ios::binary);
+    if (!shaderFile.is_open())
+    {
+        return false;
+    }
+    shaderText.assign(std::istreambuf_iterator<char>(shaderFile), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string ShaderCompiler::getDefinesText(std::span<const std::string> defines)
 {
-    std::ifstream shaderFile(shaderCodePath);
-    std::string shaderText((std::istreambuf_iterator<char>(shaderFile)), std::istreambuf_iterator<char>());
+    std::string definesText;
+    for (const auto& define : defines)
+    {
+        definesText += "#define ";
+        definesText += define;
+        definesText += " 1\n";
+    }
+    return definesText;
+}
+
+uint64_t ShaderCompiler::getDefinesKey(std::span<const std::string> defines)
+{
+    if (defines.empty())
+    {
+        return 0;
+    }
+    const std::string definesText = getDefinesText(defines);
+    return Kompot::Hash::xxHash64(definesText.data(), definesText.size(), 0);
+}
+
+uint64_t ShaderCompiler::getCacheKey(const fs::path& shaderCodePath, std::span<const std::string_view> sourceTexts, ShaderOptimization optimization)
+{
+    const glslang::Version glslangVersion = glslang::GetVersion();
+    const int32_t environment[] = {
+            detectShaderType(shaderCodePath),
+            glslVersion,
+            targetClient,
+            targetSpirv,
+            compileMessages,
+            glslangVersion.major,
+            glslangVersion.minor,
+            glslangVersion.patch,
+            static_cast<int32_t>(glslang::GetSpirvGeneratorVersion()),
+            static_cast<int32_t>(optimization)};
+
+    uint64_t sourcesHash = 0;
+    for (const auto sourceText : sourceTexts)
+    {
+        sourcesHash = Kompot::Hash::xxHash64(sourceText.data(), sourceText.size(), sourcesHash);
+    }
+    return Kompot::Hash::xxHash64(environment, sizeof(environment), sourcesHash);
+}
+
+void ShaderCompiler::setOptimization(ShaderOptimization optimization)
+{
+    mOptimization = optimization;
+}
+
+namespace
+{
+// the unoptimized size costs one more GlslangToSpv, so it's computed only when verbose shader logging is on
+void reportSize(
+        const fs::path& shaderCodePath,
+        const glslang::TIntermediate& intermediate,
+        ShaderOptimization optimization,
+        const ShaderCompiler::Bytecode& spirvBytecode)
+{
+    const std::size_t size = spirvBytecode.size() * sizeof(uint32_t);
+    ENGINE_LOG(Info, Shader) << shaderCodePath << " compiled, " << size << " bytes";
+
+    if (optimization == ShaderOptimization::None || !Log::isCompiledIn(LogLevel::Verbose) ||
+        !Log::getInstance().isEnabled(LogLevel::Verbose, LogCategory::Shader))
+    {
+        return;
+    }
+
+    ShaderCompiler::Bytecode unoptimizedBytecode;
+    glslang::GlslangToSpv(intermediate, unoptimizedBytecode);
+    const std::size_t unoptimizedSize = unoptimizedBytecode.size() * sizeof(uint32_t);
+    const auto percents               = unoptimizedSize > 0 ? static_cast<int64_t>(size * 100 / unoptimizedSize) - 100 : 0;
+
+    ENGINE_LOG(Verbose, Shader) << shaderCodePath << " is " << unoptimizedSize << " bytes before optimization (" << percents << "%)";
+}
+} // namespace
+
+// reads the included files and keeps their texts for the cache key until the compilation ends
+class ShaderIncluder final : public glslang::TShader::Includer
+{
+public:
+    ShaderIncluder(const fs::path& shaderCodePath, std::string shaderText) : mShaderDirectory(shaderCodePath.parent_path())
+    {
+        mSourceTexts.push_back(std::move(shaderText));
+    }
+
+    IncludeResult* includeLocal(const char* headerName, const char* includerName, std::size_t inclusionDepth) override
+    {
+        return include(fs::path(includerName).parent_path() / headerName, inclusionDepth);
+    }
+
+    IncludeResult* includeSystem(const char* headerName, const char* /*includerName*/, std::size_t inclusionDepth) override
+    {
+        return include(mShaderDirectory / headerName, inclusionDepth);
+    }
+
+    void releaseInclude(IncludeResult* result) override
+    {
+        delete result;
+    }
+
+    const std::string& getShaderText() const
+    {
+        return mSourceTexts.front();
+    }
+
+    // the shader text first, then the ones of the dependencies
+    std::vector<std::string_view> getSourceTexts() const
+    {
+        return {mSourceTexts.begin(), mSourceTexts.end()};
+    }
 
-    const EShLanguage shaderStage = detectShaderType(shaderCodePath);
+    std::vector<std::string> takeDependencies()
+    {
+        return std::move(mDependencies);
+    }
+
+private:
+    IncludeResult* include(const fs::path& headerPath, std::size_t inclusionDepth)
+    {
+        if (inclusionDepth > maxInclusionDepth)
+        {
+            return nullptr;
+        }
+
+        // a header included again, e.g. behind an include guard, is read once
+        std::string headerName = headerPath.lexically_normal().generic_string();
+        const auto dependency  = std::find(mDependencies.begin(), mDependencies.end(), headerName);
+        if (dependency != mDependencies.end())
+        {
+            const std::string& headerText = mSourceTexts[dependency - mDependencies.begin() + 1];
+            return new IncludeResult(headerName, headerText.data(), headerText.size(), nullptr);
+        }
+
+        std::string headerText;
+        if (!ShaderCompiler::readSource(headerName, headerText))
+        {
+            return nullptr;
+        }
+
+        // the deque never moves the texts, glslang reads them until the end of parse()
+        const std::string& storedText = mSourceTexts.emplace_back(std::move(headerText));
+        mDependencies.push_back(headerName);
+        return new IncludeResult(std::move(headerName), storedText.data(), storedText.size(), nullptr);
+    }
+
+    const fs::path mShaderDirectory;
+    std::deque<std::string> mSourceTexts;
+    std::vector<std::string> mDependencies;
+};
+
+ShaderCompiler::Result ShaderCompiler::compile(const fs::path shaderCodePath)
+{
+    return compile(ShaderVariant{shaderCodePath});
+}
+
+ShaderCompiler::Result ShaderCompiler::compile(const ShaderVariant& variant)
+{
+    const fs::path& shaderCodePath = variant.path;
+    std::string shaderText;
+    if (!readSource(shaderCodePath, shaderText))
+    {
+        ENGINE_LOG(Error, Shader) << "Failed to open " << shaderCodePath;
+        return {};
+    }
+    ShaderIncluder includer(shaderCodePath, std::move(shaderText));
+
+    const EShLanguage shaderStage         = detectShaderType(shaderCodePath);
+    const ShaderOptimization optimization = mOptimization;
     glslang::TShader shader(shaderStage);
-    shader.setEnvInput(glslang::EShSourceGlsl, shaderStage, glslang::EShClientVulkan, 460);
-    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
-    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_4);
+    shader.setEnvInput(glslang::EShSourceGlsl, shaderStage, glslang::EShClientVulkan, glslVersion);
+    shader.setEnvClient(glslang::EShClientVulkan, targetClient);
+    shader.setEnvTarget(glslang::EShTargetSpv, targetSpirv);
 
     glslang::TProgram program;
-    TBuiltInResource resource{};
-    initResource(resource);
+    const TBuiltInResource& resource = getResource();
 
     // Enable SPIR-V and Vulkan rules when parsing GLSL
-    auto messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+    const auto messages = compileMessages;
 
-    const char* shaderStrings[1];
-    shaderStrings[0] = shaderText.c_str();
-    shader.setStrings(shaderStrings, 1);
+    // the name is the includer of the top level #include "file" directives
+    const std::string shaderName = shaderCodePath.lexically_normal().generic_string();
+    const char* shaderStrings[1] = {includer.getShaderText().c_str()};
+    const int shaderLengths[1]   = {static_cast<int>(includer.getShaderText().size())};
+    const char* shaderNames[1]   = {shaderName.c_str()};
+    shader.setStringsWithLengthsAndNames(shaderStrings, shaderLengths, shaderNames, 1);
+    const std::string definesText = getDefinesText(variant.defines);
+    const std::string preamble    = includePreamble + definesText;
+    shader.setPreamble(preamble.c_str());
 
-    if (!shader.parse(&resource, 100, false, messages))
+    if (!shader.parse(&resource, 100, false, messages, includer))
     {
-        puts(shader.getInfoLog());
-        puts(shader.getInfoDebugLog());
+        ENGINE_LOG(Error, Shader) << "Failed to parse " << shaderCodePath << ":\n" << shader.getInfoLog() << shader.getInfoDebugLog();
         return {};
     }
 
@@ -194,23 +412,133 @@ std::vector<uint32_t> ShaderCompiler::compile(const fs::path shaderCodePath, con
 
     if (!program.link(messages))
     {
-        puts(shader.getInfoLog());
-        puts(shader.getInfoDebugLog());
-        fflush(stdout);
+        ENGINE_LOG(Error, Shader) << "Failed to link " << shaderCodePath << ":\n" << program.getInfoLog() << program.getInfoDebugLog();
         return {};
     }
 
-    std::vector<uint32_t> spirvBytecode;
-    glslang::GlslangToSpv(*program.getIntermediate(shaderStage), spirvBytecode);
+    // glslang runs the SPIRV-Tools optimizer itself unless disableOptimizer is set
+    glslang::SpvOptions spvOptions;
+    spvOptions.disableOptimizer = optimization == ShaderOptimization::None;
+    spvOptions.optimizeSize     = optimization == ShaderOptimization::Size;
+    spvOptions.stripDebugInfo   = optimization != ShaderOptimization::None;
+
+    Result result;
+    glslang::GlslangToSpv(*program.getIntermediate(shaderStage), result.code, &spvOptions);
+
+    if (Log::isCompiledIn(LogLevel::Info) && Log::getInstance().isEnabled(LogLevel::Info, LogCategory::Shader))
+    {
+        reportSize(shaderCodePath, *program.getIntermediate(shaderStage), optimization, result.code);
+    }
+
+    // the defines go last, ShaderManager hashes the archived shaders in the same order
+    auto sourceTexts = includer.getSourceTexts();
+    sourceTexts.push_back(definesText);
+    result.cacheKey     = getCacheKey(shaderCodePath, sourceTexts, optimization);
+    result.dependencies = includer.takeDependencies();
+    return result;
+}
+
+std::vector<std::future<ShaderCompiler::Result>> ShaderCompiler::compileAll(const std::vector<fs::path>& shaderCodePaths)
+{
+    std::vector<ShaderVariant> variants;
+    variants.reserve(shaderCodePaths.size());
+    for (const auto& shaderCodePath : shaderCodePaths)
+    {
+        variants.push_back({shaderCodePath});
+    }
+    return compileVariants(variants);
+}
+
+std::vector<std::future<ShaderCompiler::Result>> ShaderCompiler::compileVariants(const std::vector<ShaderVariant>& variants)
+{
+    std::vector<std::future<Result>> results;
+    results.reserve(variants.size());
+    {
+        std::lock_guard<std::mutex> workersLock(mWorkersMutex);
+        if (mWorkers.empty())
+        {
+            startWorkers();
+        }
+
+        std::lock_guard<std::mutex> jobsLock(mJobsMutex);
+        for (const auto& variant : variants)
+        {
+            std::packaged_task<Result()> task([this, variant] { return compile(variant); });
+            results.push_back(task.get_future());
+            mJobs.push_back(std::move(task));
+        }
+    }
+    mJobsCondition.notify_all();
+
+    return results;
+}
+
+void ShaderCompiler::setThreadsCount(uint32_t threadsCount)
+{
+    std::lock_guard<std::mutex> workersLock(mWorkersMutex);
+    stopWorkers();
+    mThreadsCount = threadsCount;
+}
+
+uint32_t ShaderCompiler::getThreadsCount()
+{
+    std::lock_guard<std::mutex> workersLock(mWorkersMutex);
+    if (mThreadsCount > 0)
+    {
+        return mThreadsCount;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void ShaderCompiler::startWorkers()
+{
+    const uint32_t threadsCount = mThreadsCount > 0 ? mThreadsCount : std::max(std::thread::hardware_concurrency(), 1u);
+    mWorkers.reserve(threadsCount);
+    for (uint32_t i = 0; i < threadsCount; ++i)
+    {
+        mWorkers.emplace_back(&ShaderCompiler::runWorker, this);
+    }
+}
 
-    if (std::error_code error; !fs::create_directories("Cache/Shaders", error) && error)
+void ShaderCompiler::stopWorkers()
+{
     {
-        Log::getInstance() << "Failed to create shaders cache directory: " << error.message()  << std::endl;
+        std::lock_guard<std::mutex> jobsLock(mJobsMutex);
+        mIsStopping = true;
     }
+    mJobsCondition.notify_all();
 
-    const std::string cachePathString(cachePath.native().begin(), cachePath.native().end());
-    glslang::OutputSpvBin(spirvBytecode, cachePathString.c_str());
+    // the workers finish the queued jobs before they exit
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+    mWorkers.clear();
 
-    return spirvBytecode;
+    std::lock_guard<std::mutex> jobsLock(mJobsMutex);
+    mIsStopping = false;
 }
 
+void ShaderCompiler::runWorker()
+{
+    // InitializeProcess is reference counted, the pool allocator glslang parses with is created per thread
+    glslang::InitializeProcess();
+
+    for (;;)
+    {
+        std::packaged_task<Result()> job;
+        {
+            std::unique_lock<std::mutex> jobsLock(mJobsMutex);
+            mJobsCondition.wait(jobsLock, [this] { return mIsStopping || !mJobs.empty(); });
+            if (mJobs.empty())
+            {
+                break;
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+        job();
+    }
+
+    glslang::FinalizeProcess();
+}
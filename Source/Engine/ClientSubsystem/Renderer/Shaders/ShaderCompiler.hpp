@@ -4,23 +4,115 @@
  *  Licensed under the MIT license.
  */
 
+#pragma once
+
 #include <Engine/ClientSubsystem/Renderer/RenderingCommon.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
-#include <filesystem>
 
 namespace Kompot::Rendering
 {
+enum class ShaderOptimization : uint8_t
+{
+    None,        // GlslangToSpv output as is, with the names for graphics debuggers
+    Performance, // SPIRV-Tools performance passes, dead code elimination, no debug info
+    Size         // SPIRV-Tools size passes, dead code elimination, no debug info
+};
+
+// the shader compiled with "#define <name> 1" for every define, see ShaderPermutations
+struct ShaderVariant
+{
+    std::filesystem::path path;
+    uint64_t definesKey = 0; // ShaderCompiler::getDefinesKey(defines), identifies the variant in the caches
+    std::vector<std::string> defines{};
+};
+
+/*
+ * GLSL to SPIR-V compiler. compile() works on the calling thread, compileAll() spreads the shaders
+ * over a pool of worker threads, every worker keeps its own glslang state, so parsing, linking
+ * and GlslangToSpv of different shaders run concurrently.
+ * #include "file" is resolved relative to the including file, #include <file> relative to
+ * the directory of the compiled shader.
+ */
 class ShaderCompiler
 {
 public:
+    using Bytecode = std::vector<uint32_t>;
+
+    struct Result
+    {
+        Bytecode code; // empty if the shader failed to compile, the errors are in the log
+        uint64_t cacheKey = 0;
+        std::vector<std::string> dependencies; // generic paths of the included files, nested ones too, in the order of inclusion
+    };
+
     static ShaderCompiler& get();
 
-    std::vector<uint32_t> compile(const std::filesystem::path shaderCodePath, const std::filesystem::path cachePath);
+    Result compile(const std::filesystem::path shaderCodePath);
+
+    Result compile(const ShaderVariant& variant);
+
+    // true for the extensions compile() knows the stage of
+    static bool isShaderSource(const std::filesystem::path& path);
+
+    static bool readSource(const std::filesystem::path& shaderCodePath, std::string& shaderText);
+
+    // the lines compile() puts in front of the source of a variant
+    static std::string getDefinesText(std::span<const std::string> defines);
+
+    // hash of the defines text, 0 without defines, so the same defines get the same key whatever options produced them
+    static uint64_t getDefinesKey(std::span<const std::string> defines);
+
+    // identifies the SPIR-V compile() makes of the source: hash of the texts of the shader, its dependencies
+    // and its defines, stage, target environment, optimization and glslang version
+    static uint64_t getCacheKey(
+            const std::filesystem::path& shaderCodePath, std::span<const std::string_view> sourceTexts, ShaderOptimization optimization);
+
+    // None in debug builds and Performance otherwise, affects the compilations started after the call
+    void setOptimization(ShaderOptimization optimization);
+
+    ShaderOptimization getOptimization() const
+    {
+        return mOptimization;
+    }
+
+    // the futures are in the order of the paths
+    std::vector<std::future<Result>> compileAll(const std::vector<std::filesystem::path>& shaderCodePaths);
+
+    std::vector<std::future<Result>> compileVariants(const std::vector<ShaderVariant>& variants);
+
+    // 0 means one worker per core, the workers are (re)started by the next compileAll()
+    void setThreadsCount(uint32_t threadsCount);
+
+    uint32_t getThreadsCount();
 
 private:
     ShaderCompiler();
     ~ShaderCompiler();
+
+    void startWorkers();
+    void stopWorkers();
+    void runWorker();
+
+    std::atomic<ShaderOptimization> mOptimization;
+
+    std::mutex mWorkersMutex; // guards mThreadsCount and mWorkers
+    uint32_t mThreadsCount = 0;
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mJobsMutex;
+    std::condition_variable mJobsCondition;
+    std::deque<std::packaged_task<Result()>> mJobs;
+    bool mIsStopping = false;
 };
 
 } // namespace Kompot::ClientSubsystem::Renderer
@@ -0,0 +1,104 @@
+/*
+ *  ShaderHotReloader.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "ShaderHotReloader.hpp"
+#include "ShaderManager.hpp"
+#include <Engine/Log/Log.hpp>
+#include <algorithm>
+
+using namespace Kompot::Rendering;
+
+namespace fs = std::filesystem;
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+    mWatcher.stop();
+}
+
+bool ShaderHotReloader::start(const fs::path& shadersDirectory)
+{
+    if (!mWatcher.start(shadersDirectory, [this](const fs::path& path) { onFileChanged(path); }))
+    {
+        return false;
+    }
+
+    ENGINE_LOG(Info, Shader) << "Watching " << shadersDirectory << " for shader changes";
+    return true;
+}
+
+void ShaderHotReloader::onFileChanged(const fs::path& path)
+{
+    // the watcher thread only queues the file, the dependents are known to ShaderManager on the render thread
+    std::lock_guard<std::mutex> lock(mChangedFilesMutex);
+    if (std::find(mChangedFiles.begin(), mChangedFiles.end(), path) == mChangedFiles.end())
+    {
+        mChangedFiles.push_back(path);
+    }
+    mHasChangedFiles = true;
+}
+
+void ShaderHotReloader::compileChanged()
+{
+    std::vector<fs::path> changedFiles;
+    {
+        std::lock_guard<std::mutex> lock(mChangedFilesMutex);
+        changedFiles.swap(mChangedFiles);
+        mHasChangedFiles = false;
+    }
+
+    std::vector<ShaderVariant> variants;
+    for (const auto& changedFile : changedFiles)
+    {
+        for (auto& variant : ShaderManager::get().getAffectedVariants(changedFile))
+        {
+            // a shader including several of the changed files is compiled once
+            const auto isSame = [&variant](const ShaderVariant& other) {
+                return other.definesKey == variant.definesKey && other.path == variant.path;
+            };
+            if (std::find_if(variants.begin(), variants.end(), isSame) == variants.end())
+            {
+                variants.push_back(std::move(variant));
+            }
+        }
+    }
+
+    auto results = ShaderCompiler::get().compileVariants(variants);
+    for (std::size_t i = 0; i < variants.size(); ++i)
+    {
+        // an editor may save a file several times in a row, only the latest compilation matters
+        std::erase_if(mPendingShaders, [&variant = variants[i]](const PendingShader& pendingShader) {
+            return pendingShader.variant.definesKey == variant.definesKey && pendingShader.variant.path == variant.path;
+        });
+        mPendingShaders.push_back({std::move(variants[i]), std::move(results[i])});
+    }
+}
+
+std::vector<ShaderHotReloader::ReloadedShader> ShaderHotReloader::takeReloaded()
+{
+    if (mHasChangedFiles)
+    {
+        compileChanged();
+    }
+
+    std::vector<ReloadedShader> reloadedShaders;
+    std::erase_if(mPendingShaders, [&reloadedShaders](PendingShader& pendingShader) {
+        if (pendingShader.compiled.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return false;
+        }
+
+        if (auto compiled = pendingShader.compiled.get(); !compiled.code.empty())
+        {
+            reloadedShaders.push_back({std::move(pendingShader.variant), std::move(compiled)});
+        }
+        else
+        {
+            ENGINE_LOG(Warning, Shader) << pendingShader.variant.path << " failed to compile, the previous version stays in use";
+        }
+        return true;
+    });
+    return reloadedShaders;
+}
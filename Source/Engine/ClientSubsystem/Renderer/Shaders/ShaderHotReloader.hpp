@@ -0,0 +1,65 @@
+/*
+ *  ShaderHotReloader.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ShaderCompiler.hpp"
+#include <Engine/Platform/FileWatcher.hpp>
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace Kompot::Rendering
+{
+/*
+ * Recompiles the shader variants loaded by ShaderManager whose sources or includes changed in the shaders
+ * directory on the ShaderCompiler workers, nothing else.
+ * The renderer picks the results up with takeReloaded() at a frame boundary, the call
+ * never waits for a compilation.
+ */
+class ShaderHotReloader
+{
+public:
+    struct ReloadedShader
+    {
+        ShaderVariant variant;
+        ShaderCompiler::Result compiled;
+    };
+
+    ShaderHotReloader() = default;
+    ~ShaderHotReloader();
+
+    // returns false if the directory can't be watched, e.g. on platforms without a FileWatcher
+    bool start(const std::filesystem::path& shadersDirectory);
+
+    // starts the compilation of the shaders affected by the files changed since the previous call and
+    // returns the shaders compiled so far, the ones failed to compile are skipped, their errors are in the log.
+    // Must be called on the thread using ShaderManager
+    std::vector<ReloadedShader> takeReloaded();
+
+private:
+    void onFileChanged(const std::filesystem::path& path);
+
+    void compileChanged();
+
+    struct PendingShader
+    {
+        ShaderVariant variant;
+        std::future<ShaderCompiler::Result> compiled;
+    };
+
+    Platform::FileWatcher mWatcher;
+
+    std::mutex mChangedFilesMutex;
+    std::vector<std::filesystem::path> mChangedFiles;
+    std::atomic<bool> mHasChangedFiles = false; // lets takeReloaded() skip the lock on most frames
+
+    std::vector<PendingShader> mPendingShaders;
+};
+
+} // namespace Kompot::Rendering
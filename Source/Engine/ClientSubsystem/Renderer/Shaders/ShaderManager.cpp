@@ -5,19 +5,37 @@
  */
 
 #include "ShaderManager.hpp"
+#include "ShaderCache.hpp"
 #include "ShaderCompiler.hpp"
 #include <Engine/Log/Log.hpp>
 #include <Engine/ErrorHandling.hpp>
-#include <fstream>
+#include <algorithm>
+#include <utility>
 
 using namespace Kompot;
 using namespace Kompot::Rendering;
 
 namespace fs = std::filesystem;
 
-const inline fs::path toCachePath(const fs::path& path)
+fs::path getArchivePath(ShaderOptimization optimization)
 {
-    return "Cache/" + path.string() + ".spv";
+    switch (optimization)
+    {
+    case ShaderOptimization::Performance:
+        return "Cache/Shaders.O.kspa";
+    case ShaderOptimization::Size:
+        return "Cache/Shaders.Os.kspa";
+    default:
+        return "Cache/Shaders.kspa";
+    }
+}
+
+ShaderManager::ShaderManager()
+    : mOptimization(ShaderCompiler::get().getOptimization()),
+      mArchivePath(getArchivePath(mOptimization)),
+      mArchive(std::make_shared<ShaderCacheArchive>())
+{
+    mArchive->open(mArchivePath);
 }
 
 ShaderManager& ShaderManager::get()
@@ -26,52 +44,271 @@ ShaderManager& ShaderManager::get()
     return shaderManagerSingnltone;
 }
 
-std::vector<uint32_t> loadCacheFile(const fs::path& path)
+const ShaderBinary* ShaderManager::findLoaded(const fs::path& path, uint64_t definesKey) const
+{
+    if (const auto loadedShader = mLoadedShaders.find(path.native()); loadedShader != mLoadedShaders.end())
+    {
+        if (const auto loadedVariant = loadedShader->second.find(definesKey); loadedVariant != loadedShader->second.end())
+        {
+            return &loadedVariant->second;
+        }
+    }
+    return nullptr;
+}
+
+const ShaderManager::CompiledShader* ShaderManager::findCompiled(const std::string& name, uint64_t definesKey) const
 {
-#if defined(__GNUC__)
-    std::ifstream file{path, std::ios::binary | std::ios::ate};
-    if (!file.is_open())
+    if (const auto compiledShader = mCompiledShaders.find(name); compiledShader != mCompiledShaders.end())
+    {
+        if (const auto compiledVariant = compiledShader->second.find(definesKey); compiledVariant != compiledShader->second.end())
+        {
+            return &compiledVariant->second;
+        }
+    }
+    return nullptr;
+}
+
+ShaderBinary ShaderManager::findArchived(const ShaderVariant& variant)
+{
+    const fs::path& path      = variant.path;
+    const auto archivedShader = mArchive->find(path.generic_string(), variant.definesKey);
+    if (!archivedShader)
     {
         return {};
     }
-    const auto size = file.tellg();
-    std::vector<uint32_t> buffer(size / 4);
-    file.seekg(0);
-    file.read(reinterpret_cast<char*>(buffer.data()), size);
-#else
-    std::basic_ifstream<uint32_t> file{path, std::ios::ate | std::ios::binary};
-    if (!file.is_open())
+
+    // without the sources (e.g. in a shipped build) the archive is trusted as is
+    if (std::string shaderText; ShaderCompiler::readSource(path, shaderText))
+    {
+        std::vector<std::string> dependencyTexts;
+        for (const auto dependency : ShaderCacheArchive::splitDependencies(archivedShader->dependencies))
+        {
+            // a missing header is an error the compiler reports
+            if (!ShaderCompiler::readSource(dependency, dependencyTexts.emplace_back()))
+            {
+                ENGINE_LOG(Info, Shader) << path << " depends on missing " << dependency << ", recompiling";
+                return {};
+            }
+        }
+
+        const std::string definesText             = ShaderCompiler::getDefinesText(variant.defines);
+        std::vector<std::string_view> sourceTexts = {shaderText};
+        sourceTexts.insert(sourceTexts.end(), dependencyTexts.begin(), dependencyTexts.end());
+        sourceTexts.push_back(definesText);
+        if (archivedShader->key != ShaderCompiler::getCacheKey(path, sourceTexts, mOptimization))
+        {
+            ENGINE_LOG(Info, Shader) << path << " has changed, recompiling";
+            return {};
+        }
+    }
+
+    ShaderBinary shaderBinary(mArchive, archivedShader->code);
+    mLoadedShaders[path.native()].emplace(variant.definesKey, shaderBinary);
+    return shaderBinary;
+}
+
+ShaderBinary ShaderManager::addCompiled(const ShaderVariant& variant, ShaderCompiler::Result compiled)
+{
+    if (compiled.code.empty())
     {
         return {};
     }
-    std::vector<uint32_t> buffer{std::istreambuf_iterator<uint32_t>(file), std::istreambuf_iterator<uint32_t>()};
-#endif
-    return buffer;
+    ++mStatistics.compiledCount;
+
+    auto& compiledShader        = mCompiledShaders[variant.path.generic_string()][variant.definesKey];
+    compiledShader.key          = compiled.cacheKey;
+    compiledShader.code         = std::make_shared<const std::vector<uint32_t>>(std::move(compiled.code));
+    compiledShader.dependencies = ShaderCacheArchive::joinDependencies(compiled.dependencies);
+
+    ShaderBinary shaderBinary(compiledShader.code, *compiledShader.code);
+    mLoadedShaders[variant.path.native()][variant.definesKey] = shaderBinary;
+    return shaderBinary;
+}
+
+ShaderBinary ShaderManager::load(const std::filesystem::path& path)
+{
+    // the variant is built only on a miss, its copy of the path would allocate on every load
+    if (const ShaderBinary* loadedShader = findLoaded(path, 0))
+    {
+        ++mStatistics.loadsCount;
+        return *loadedShader;
+    }
+    return loadVariant({path});
 }
 
-const std::vector<uint32_t> ShaderManager::load(const std::filesystem::path& path)
+ShaderBinary ShaderManager::loadVariant(const ShaderVariant& variant)
 {
-    if (path.is_absolute())
+    if (variant.path.is_absolute())
     {
-        Log::getInstance() << path << " - path must be relative!" << std::endl;
+        ENGINE_LOG(Error, Shader) << variant.path << " - path must be relative!";
         return {};
     }
 
-    const auto cachePath = toCachePath(path);
+    ++mStatistics.loadsCount;
+    if (const ShaderBinary* loadedShader = findLoaded(variant.path, variant.definesKey))
+    {
+        return *loadedShader;
+    }
+
+    mLoadedDefines[variant.path.generic_string()].emplace(variant.definesKey, variant.defines);
+    if (auto archivedShader = findArchived(variant); !archivedShader.empty())
+    {
+        return archivedShader;
+    }
+
+    return addCompiled(variant, ShaderCompiler::get().compile(variant));
+}
+
+ShaderBinary ShaderManager::update(const ShaderVariant& variant, ShaderCompiler::Result compiled)
+{
+    return addCompiled(variant, std::move(compiled));
+}
+
+std::vector<ShaderVariant> ShaderManager::getAffectedVariants(const fs::path& path) const
+{
+    const std::string changedName = path.lexically_normal().generic_string();
+
+    std::vector<ShaderVariant> affectedVariants;
+    for (const auto& [name, variants] : mLoadedDefines)
+    {
+        for (const auto& [definesKey, defines] : variants)
+        {
+            // the dependencies of the latest compilation, the compiled shaders replace the archived ones
+            std::string_view dependencies;
+            if (const CompiledShader* compiledShader = findCompiled(name, definesKey))
+            {
+                dependencies = compiledShader->dependencies;
+            }
+            else if (const auto archivedShader = mArchive->find(name, definesKey))
+            {
+                dependencies = archivedShader->dependencies;
+            }
+
+            const auto dependencyNames = ShaderCacheArchive::splitDependencies(dependencies);
+            if (name == changedName || std::find(dependencyNames.begin(), dependencyNames.end(), changedName) != dependencyNames.end())
+            {
+                affectedVariants.push_back({name, definesKey, defines});
+            }
+        }
+    }
+    return affectedVariants;
+}
+
+std::vector<ShaderBinary> ShaderManager::loadAll(const std::vector<std::filesystem::path>& paths)
+{
+    std::vector<ShaderVariant> variants;
+    variants.reserve(paths.size());
+    for (const auto& path : paths)
+    {
+        variants.push_back({path});
+    }
+    return loadVariants(variants);
+}
+
+std::vector<ShaderBinary> ShaderManager::loadVariants(const std::vector<ShaderVariant>& variants)
+{
+    std::vector<ShaderBinary> shaderBinaries(variants.size());
+
+    std::vector<ShaderVariant> compiledVariants;
+    std::vector<std::size_t> compiledIndices;
+    for (std::size_t i = 0; i < variants.size(); ++i)
+    {
+        if (variants[i].path.is_absolute())
+        {
+            ENGINE_LOG(Error, Shader) << variants[i].path << " - path must be relative!";
+            continue;
+        }
+
+        ++mStatistics.loadsCount;
+        if (const ShaderBinary* loadedShader = findLoaded(variants[i].path, variants[i].definesKey))
+        {
+            shaderBinaries[i] = *loadedShader;
+            continue;
+        }
+
+        mLoadedDefines[variants[i].path.generic_string()].emplace(variants[i].definesKey, variants[i].defines);
+        shaderBinaries[i] = findArchived(variants[i]);
+        if (shaderBinaries[i].empty())
+        {
+            compiledVariants.push_back(variants[i]);
+            compiledIndices.push_back(i);
+        }
+    }
+
+    auto compileResults = ShaderCompiler::get().compileVariants(compiledVariants);
+    for (std::size_t i = 0; i < compileResults.size(); ++i)
+    {
+        shaderBinaries[compiledIndices[i]] = addCompiled(compiledVariants[i], compileResults[i].get());
+    }
+    if (!compiledVariants.empty())
+    {
+        ENGINE_LOG(Info, Shader) << "Compiled " << compiledVariants.size() << " of " << variants.size() << " shaders, "
+                                 << mStatistics.compiledCount << " compiled and " << mStatistics.loadsCount << " loaded since the start";
+    }
+
+    return shaderBinaries;
+}
+
+bool ShaderManager::saveArchive()
+{
+    if (mCompiledShaders.empty())
+    {
+        return true;
+    }
+
+    std::vector<ShaderCacheArchive::Shader> shaders;
+    uint64_t copiedBytes = 0;
+    for (std::size_t i = 0; i < mArchive->getShadersCount(); ++i)
+    {
+        if (const auto archivedShader = mArchive->getShader(i); !findCompiled(std::string(archivedShader.name), archivedShader.definesKey))
+        {
+            shaders.push_back(archivedShader);
+        }
+    }
+    for (const auto& [name, variants] : mCompiledShaders)
+    {
+        for (const auto& [definesKey, compiledShader] : variants)
+        {
+            shaders.push_back({name, definesKey, compiledShader.key, *compiledShader.code, compiledShader.dependencies});
+            copiedBytes += compiledShader.code->size() * sizeof(uint32_t);
+        }
+    }
 
-    if (const auto cacheValue = cache.find(cachePath); cacheValue != cache.end())
+    auto temporaryPath = mArchivePath;
+    temporaryPath += ".tmp";
+    if (!ShaderCacheArchive::write(temporaryPath, shaders))
     {
-        return cacheValue->second;
+        return false;
     }
 
-    if (const auto shaderBinary = loadCacheFile(cachePath); !shaderBinary.empty())
+    // the archive can't be replaced while it's mapped on Windows, the mapping is gone
+    // unless somebody still holds a ShaderBinary from it
+    mLoadedShaders.clear();
+    mArchive = std::make_shared<ShaderCacheArchive>();
+    if (std::error_code error; fs::rename(temporaryPath, mArchivePath, error), error)
     {
-        cache.emplace(cachePath, shaderBinary);
-        return shaderBinary;
+        ENGINE_LOG(Error, Shader) << "Failed to replace " << mArchivePath << ": " << error.message();
+        fs::remove(temporaryPath, error);
+        mArchive->open(mArchivePath);
+        for (const auto& [name, variants] : mCompiledShaders)
+        {
+            for (const auto& [definesKey, compiledShader] : variants)
+            {
+                mLoadedShaders[fs::path(name).native()].emplace(definesKey, ShaderBinary(compiledShader.code, *compiledShader.code));
+            }
+        }
+        return false;
     }
 
-    const auto shaderBinary = ShaderCompiler::get().compile(path, cachePath);
-    cache.emplace(cachePath, shaderBinary);
+    mCompiledShaders.clear();
+    mArchive->open(mArchivePath);
+    mStatistics.copiedBytes += copiedBytes;
+    ENGINE_LOG(Info, Shader) << "Saved " << mArchive->getShadersCount() << " shaders to " << mArchivePath << ", " << copiedBytes
+                             << " bytes of compiled SPIR-V copied";
+    return true;
+}
 
-    return shaderBinary;
+const ShaderManagerStatistics& ShaderManager::getStatistics() const
+{
+    return mStatistics;
 }
@@ -4,23 +4,127 @@
  *  Licensed under the MIT license.
  */
 
+#pragma once
+
+#include "ShaderCache.hpp"
+#include "ShaderCompiler.hpp"
 #include <Engine/ClientSubsystem/Renderer/RenderingCommon.hpp>
 #include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
 #include <unordered_map>
 #include <vector>
-#include <string>
 
 namespace Kompot::Rendering
 {
+/*
+ * Immutable SPIR-V shared with ShaderManager. Copying a handle doesn't copy the code, the code
+ * stays valid while any handle to it lives, even after ShaderManager::saveArchive().
+ */
+class ShaderBinary
+{
+public:
+    ShaderBinary() = default;
+
+    ShaderBinary(std::shared_ptr<const void> owner, std::span<const uint32_t> code) : mOwner(std::move(owner)), mCode(code)
+    {
+    }
+
+    std::span<const uint32_t> getCode() const
+    {
+        return mCode;
+    }
+
+    operator std::span<const uint32_t>() const
+    {
+        return mCode;
+    }
+
+    bool empty() const
+    {
+        return mCode.empty();
+    }
+
+private:
+    std::shared_ptr<const void> mOwner; // the archive mapping or the compiled code
+    std::span<const uint32_t> mCode;
+};
+
+struct ShaderManagerStatistics
+{
+    uint64_t loadsCount    = 0;
+    uint64_t compiledCount = 0;
+    uint64_t copiedBytes   = 0; // SPIR-V copied by the manager, 0 while nothing is compiled or saved
+};
+
+/*
+ * SPIR-V of the shaders by the paths of their GLSL sources. Shaders come from the cache archive,
+ * the ones missing there or outdated, i.e. with the source or any included file changed, are compiled
+ * and kept in memory until saveArchive(). Variants of a shader with defines (see ShaderPermutations)
+ * are cached the same way under the path and the hash of the defines, see ShaderCompiler::getDefinesKey().
+ * The archive is chosen by ShaderCompiler::getOptimization() at the first get().
+ * A repeated load is two hash map lookups and a reference count increment.
+ */
 class ShaderManager
 {
 public:
     static ShaderManager& get();
 
-    const std::vector<uint32_t> load(const std::filesystem::path& path);
+    // an empty binary if the shader failed to compile
+    ShaderBinary load(const std::filesystem::path& path);
+
+    ShaderBinary loadVariant(const ShaderVariant& variant);
+
+    // the same as load() for every path, but the shaders missing in the cache are compiled in parallel
+    std::vector<ShaderBinary> loadAll(const std::vector<std::filesystem::path>& paths);
+
+    std::vector<ShaderBinary> loadVariants(const std::vector<ShaderVariant>& variants);
+
+    // replaces the shader with the code compiled elsewhere, e.g. by ShaderHotReloader,
+    // the binaries loaded before keep the previous code
+    ShaderBinary update(const ShaderVariant& variant, ShaderCompiler::Result compiled);
+
+    // the variants loaded so far that are compiled from the file or include it, directly or not,
+    // as known from their latest compilation
+    std::vector<ShaderVariant> getAffectedVariants(const std::filesystem::path& path) const;
+
+    // puts the shaders compiled so far into the archive, does nothing if there are none
+    bool saveArchive();
+
+    // the counters accumulated since the start
+    const ShaderManagerStatistics& getStatistics() const;
 
 private:
-    std::unordered_map<std::filesystem::path::string_type, std::vector<uint32_t>> cache;
+    ShaderManager();
+
+    struct CompiledShader
+    {
+        uint64_t key = 0;
+        std::shared_ptr<const std::vector<uint32_t>> code;
+        std::string dependencies; // in the format of ShaderCacheArchive::Shader::dependencies
+    };
+
+    // by path, then by defines key
+    template <typename Name, typename Value>
+    using VariantMap = std::unordered_map<Name, std::unordered_map<uint64_t, Value>>;
+
+    const ShaderBinary* findLoaded(const std::filesystem::path& path, uint64_t definesKey) const;
+
+    const CompiledShader* findCompiled(const std::string& name, uint64_t definesKey) const;
+
+    // an empty binary if the shader has no up to date entry in the archive
+    ShaderBinary findArchived(const ShaderVariant& variant);
+
+    ShaderBinary addCompiled(const ShaderVariant& variant, ShaderCompiler::Result compiled);
+
+    ShaderOptimization mOptimization; // every optimization has its own archive
+    std::filesystem::path mArchivePath;
+    std::shared_ptr<ShaderCacheArchive> mArchive;
+    VariantMap<std::filesystem::path::string_type, ShaderBinary> mLoadedShaders; // validated already
+    VariantMap<std::string, CompiledShader> mCompiledShaders;                     // by generic paths, not in the archive yet
+    VariantMap<std::string, std::vector<std::string>> mLoadedDefines;             // every variant loaded, for getAffectedVariants()
+    ShaderManagerStatistics mStatistics;
 };
 
 } // namespace Kompot::Rendering
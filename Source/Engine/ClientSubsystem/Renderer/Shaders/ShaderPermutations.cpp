@@ -0,0 +1,113 @@
+/*
+ *  ShaderPermutations.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "ShaderPermutations.hpp"
+#include <Engine/Log/Log.hpp>
+#include <algorithm>
+
+using namespace Kompot::Rendering;
+
+namespace fs = std::filesystem;
+
+ShaderPermutations::ShaderPermutations(fs::path path, std::vector<ShaderPermutationOption> options)
+    : mPath(std::move(path)),
+      mOptions(std::move(options))
+{
+    if (mOptions.size() > maxOptionsCount)
+    {
+        ENGINE_LOG(Error, Shader) << mPath << " has " << mOptions.size() << " permutation options, only the first " << maxOptionsCount
+                                  << " are used";
+        mOptions.resize(maxOptionsCount);
+    }
+
+    for (std::size_t i = 0; i < mOptions.size(); ++i)
+    {
+        if (!mOptions[i].specializationConstantId)
+        {
+            mDefinesMask |= 1ull << i;
+        }
+    }
+}
+
+uint64_t ShaderPermutations::getMask(std::span<const std::string_view> optionNames) const
+{
+    uint64_t mask = 0;
+    for (const auto optionName : optionNames)
+    {
+        const auto option = std::find_if(mOptions.begin(), mOptions.end(), [optionName](const auto& option) { return option.name == optionName; });
+        if (option == mOptions.end())
+        {
+            ENGINE_LOG(Warning, Shader) << mPath << " has no permutation option " << optionName;
+            continue;
+        }
+        mask |= 1ull << (option - mOptions.begin());
+    }
+    return mask;
+}
+
+ShaderVariant ShaderPermutations::getShaderVariant(uint64_t mask) const
+{
+    ShaderVariant variant;
+    variant.path = mPath;
+    for (std::size_t i = 0; i < mOptions.size(); ++i)
+    {
+        if (mask & mDefinesMask & (1ull << i))
+        {
+            variant.defines.push_back(mOptions[i].name);
+        }
+    }
+    // a bit stands for a different define in every ShaderPermutations of the shader, the text doesn't
+    variant.definesKey = ShaderCompiler::getDefinesKey(variant.defines);
+    return variant;
+}
+
+std::vector<ShaderSpecializationValue> ShaderPermutations::getSpecialization(uint64_t mask) const
+{
+    std::vector<ShaderSpecializationValue> specialization;
+    for (std::size_t i = 0; i < mOptions.size(); ++i)
+    {
+        if (const auto constantId = mOptions[i].specializationConstantId)
+        {
+            specialization.push_back({*constantId, (mask & (1ull << i)) ? 1u : 0u});
+        }
+    }
+    return specialization;
+}
+
+ShaderPermutations::Variant ShaderPermutations::get(uint64_t mask) const
+{
+    return {ShaderManager::get().loadVariant(getShaderVariant(mask)), getSpecialization(mask)};
+}
+
+std::vector<ShaderPermutations::Variant> ShaderPermutations::getAll(std::span<const uint64_t> masks) const
+{
+    // masks differing only in the specialization options are one shader variant, loaded once
+    std::vector<ShaderVariant> shaderVariants;
+    std::vector<uint64_t> shaderVariantMasks;
+    std::vector<std::size_t> variantIndices;
+    for (const uint64_t mask : masks)
+    {
+        const uint64_t definesMask = mask & mDefinesMask;
+        const auto variantIndex =
+                static_cast<std::size_t>(std::find(shaderVariantMasks.begin(), shaderVariantMasks.end(), definesMask) - shaderVariantMasks.begin());
+        variantIndices.push_back(variantIndex);
+        if (variantIndex == shaderVariants.size())
+        {
+            shaderVariants.push_back(getShaderVariant(mask));
+            shaderVariantMasks.push_back(definesMask);
+        }
+    }
+
+    const auto binaries = ShaderManager::get().loadVariants(shaderVariants);
+
+    std::vector<Variant> variants;
+    variants.reserve(masks.size());
+    for (std::size_t i = 0; i < masks.size(); ++i)
+    {
+        variants.push_back({binaries[variantIndices[i]], getSpecialization(masks[i])});
+    }
+    return variants;
+}
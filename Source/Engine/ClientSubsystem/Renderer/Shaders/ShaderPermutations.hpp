@@ -0,0 +1,83 @@
+/*
+ *  ShaderPermutations.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ShaderCompiler.hpp"
+#include "ShaderManager.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Kompot::Rendering
+{
+// a switch of a shader, e.g. NORMAL_MAP or SKINNING
+struct ShaderPermutationOption
+{
+    std::string name; // "#define <name> 1" when enabled
+
+    // the constant_id of "layout(constant_id = ...) const bool <name> = false;" in the shader,
+    // then the option is a specialization value and switching it doesn't compile another variant
+    std::optional<uint32_t> specializationConstantId;
+};
+
+struct ShaderSpecializationValue
+{
+    uint32_t id    = 0;
+    uint32_t value = 0; // 32-bit constants, the options are VK_TRUE or VK_FALSE
+};
+
+/*
+ * Variants of a shader by up to 64 options, bit i of a permutation mask enables options[i].
+ * The options backed by specialization constants only change the specialization values, so
+ * the variants differing in them share the SPIR-V. The other options are defines: every combination
+ * of them is a separate SPIR-V, compiled on the first request and cached by ShaderManager
+ * under the shader path and the hash of the defines, so permutations of the same shader with
+ * different options share the variants with equal defines and never mix up the others.
+ */
+class ShaderPermutations
+{
+public:
+    static constexpr std::size_t maxOptionsCount = 64;
+
+    struct Variant
+    {
+        ShaderBinary binary;                                   // empty if the variant failed to compile
+        std::vector<ShaderSpecializationValue> specialization; // for every specialization constant option
+    };
+
+    ShaderPermutations(std::filesystem::path path, std::vector<ShaderPermutationOption> options);
+
+    // the mask of the named options, unknown names are logged and skipped
+    uint64_t getMask(std::span<const std::string_view> optionNames) const;
+
+    // compiles the variant if it isn't cached yet
+    Variant get(uint64_t mask) const;
+
+    // the same as get() for every mask, but the variants missing in the cache are compiled in parallel
+    std::vector<Variant> getAll(std::span<const uint64_t> masks) const;
+
+    // what ShaderManager caches for the mask, the specialization options don't affect it
+    ShaderVariant getShaderVariant(uint64_t mask) const;
+
+    const std::filesystem::path& getPath() const
+    {
+        return mPath;
+    }
+
+private:
+    std::vector<ShaderSpecializationValue> getSpecialization(uint64_t mask) const;
+
+    std::filesystem::path mPath;
+    std::vector<ShaderPermutationOption> mOptions;
+    uint64_t mDefinesMask = 0; // the options without a specialization constant
+};
+
+} // namespace Kompot::Rendering
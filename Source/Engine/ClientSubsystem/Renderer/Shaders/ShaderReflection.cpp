@@ -0,0 +1,725 @@
+/*
+ *  ShaderReflection.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "ShaderReflection.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace Kompot::Rendering;
+
+namespace
+{
+// the subset of the SPIR-V specification the reflection needs, see spirv.hpp of the Vulkan SDK
+namespace Spirv
+{
+constexpr uint32_t magicNumber = 0x07230203;
+constexpr uint32_t headerSize  = 5;
+
+enum Op : uint32_t
+{
+    OpEntryPoint                   = 15,
+    OpTypeBool                     = 20,
+    OpTypeInt                      = 21,
+    OpTypeFloat                    = 22,
+    OpTypeVector                   = 23,
+    OpTypeMatrix                   = 24,
+    OpTypeImage                    = 25,
+    OpTypeSampler                  = 26,
+    OpTypeSampledImage             = 27,
+    OpTypeArray                    = 28,
+    OpTypeRuntimeArray             = 29,
+    OpTypeStruct                   = 30,
+    OpTypePointer                  = 32,
+    OpConstant                     = 43,
+    OpSpecConstantTrue             = 48,
+    OpSpecConstantFalse            = 49,
+    OpSpecConstant                 = 50,
+    OpFunction                     = 54,
+    OpVariable                     = 59,
+    OpDecorate                     = 71,
+    OpMemberDecorate               = 72,
+    OpTypeAccelerationStructureKHR = 5341
+};
+
+enum Decoration : uint32_t
+{
+    DecorationSpecId        = 1,
+    DecorationBlock         = 2,
+    DecorationBufferBlock   = 3,
+    DecorationArrayStride   = 6,
+    DecorationMatrixStride  = 7,
+    DecorationBuiltIn       = 11,
+    DecorationLocation      = 30,
+    DecorationBinding       = 33,
+    DecorationDescriptorSet = 34,
+    DecorationOffset        = 35
+};
+
+enum StorageClass : uint32_t
+{
+    StorageClassUniformConstant = 0,
+    StorageClassInput           = 1,
+    StorageClassUniform         = 2,
+    StorageClassPushConstant    = 9,
+    StorageClassStorageBuffer   = 12
+};
+
+enum Dim : uint32_t
+{
+    DimBuffer      = 5,
+    DimSubpassData = 6
+};
+
+// indexed by ExecutionModel
+constexpr ShaderStage stages[] = {
+        ShaderStage::Vertex,
+        ShaderStage::TessellationControl,
+        ShaderStage::TessellationEvaluation,
+        ShaderStage::Geometry,
+        ShaderStage::Fragment,
+        ShaderStage::Compute};
+} // namespace Spirv
+
+// nested types deeper than this are treated as malformed, valid shaders are far from it
+constexpr int maxTypeDepth = 32;
+
+struct Decorations
+{
+    std::optional<uint32_t> set;
+    std::optional<uint32_t> binding;
+    std::optional<uint32_t> location;
+    std::optional<uint32_t> specId;
+    uint32_t arrayStride = 0;
+    bool isBuiltIn       = false;
+    bool isBlock         = false;
+    bool isBufferBlock   = false;
+};
+
+struct MemberDecorations
+{
+    uint32_t offset       = 0;
+    uint32_t matrixStride = 0;
+};
+
+class Parser
+{
+public:
+    explicit Parser(std::span<const uint32_t> code) : mCode(code)
+    {
+    }
+
+    std::optional<ShaderReflection> parse();
+
+private:
+    bool readDeclarations();
+    void readDecoration(std::span<const uint32_t> instruction);
+    void readMemberDecoration(std::span<const uint32_t> instruction);
+
+    bool addResource(uint32_t variableId, uint32_t typeId, uint32_t storageClass);
+    bool addPushConstants(uint32_t typeId);
+    bool addVertexInputs(uint32_t typeId, uint32_t location, int depth);
+    bool addSpecializationConstant(uint32_t constantId);
+
+    // an empty span if the id isn't defined
+    std::span<const uint32_t> getDefinition(uint32_t id) const
+    {
+        return id < mDefinitions.size() ? mDefinitions[id] : std::span<const uint32_t>{};
+    }
+
+    static uint32_t getOpcode(std::span<const uint32_t> instruction)
+    {
+        return instruction.empty() ? 0 : instruction[0] & 0xffffu;
+    }
+
+    std::optional<uint32_t> getConstant(uint32_t id) const;
+    std::optional<uint32_t> getSize(uint32_t typeId, uint32_t matrixStride, int depth) const;
+    bool getScalarType(uint32_t typeId, ShaderScalarType& scalarType, uint32_t& bitWidth) const;
+
+    std::span<const uint32_t> mCode;
+    std::vector<std::span<const uint32_t>> mDefinitions; // the instructions by their result ids
+    std::vector<Decorations> mDecorations;
+    std::unordered_map<uint32_t, std::vector<MemberDecorations>> mMemberDecorations; // by struct ids
+    std::vector<uint32_t> mVariables;
+    std::vector<uint32_t> mSpecializationConstants;
+
+    ShaderReflection mReflection;
+};
+
+std::optional<ShaderReflection> Parser::parse()
+{
+    if (mCode.size() < Spirv::headerSize || mCode[0] != Spirv::magicNumber)
+    {
+        return std::nullopt;
+    }
+
+    // every id is defined by an instruction of two words at least
+    const uint32_t idsBound = mCode[3];
+    if (idsBound > mCode.size())
+    {
+        return std::nullopt;
+    }
+    mDefinitions.resize(idsBound);
+    mDecorations.resize(idsBound);
+
+    if (!readDeclarations())
+    {
+        return std::nullopt;
+    }
+
+    for (const uint32_t variableId : mVariables)
+    {
+        const auto variable = getDefinition(variableId);
+        const auto pointer  = getDefinition(variable[1]);
+        if (getOpcode(pointer) != Spirv::OpTypePointer || pointer.size() < 4)
+        {
+            return std::nullopt;
+        }
+
+        bool isValid = true;
+        switch (variable[3])
+        {
+        case Spirv::StorageClassUniformConstant:
+        case Spirv::StorageClassUniform:
+        case Spirv::StorageClassStorageBuffer:
+            isValid = !mDecorations[variableId].binding || addResource(variableId, pointer[3], variable[3]);
+            break;
+        case Spirv::StorageClassPushConstant:
+            isValid = addPushConstants(pointer[3]);
+            break;
+        case Spirv::StorageClassInput:
+            if (mReflection.stage == ShaderStage::Vertex && !mDecorations[variableId].isBuiltIn && mDecorations[variableId].location)
+            {
+                isValid = addVertexInputs(pointer[3], *mDecorations[variableId].location, 0);
+            }
+            break;
+        default:
+            break;
+        }
+        if (!isValid)
+        {
+            return std::nullopt;
+        }
+    }
+
+    for (const uint32_t constantId : mSpecializationConstants)
+    {
+        if (!addSpecializationConstant(constantId))
+        {
+            return std::nullopt;
+        }
+    }
+
+    std::sort(mReflection.resourceBindings.begin(), mReflection.resourceBindings.end(), [](const auto& left, const auto& right) {
+        return left.set != right.set ? left.set < right.set : left.binding < right.binding;
+    });
+    std::sort(mReflection.vertexInputs.begin(), mReflection.vertexInputs.end(), [](const auto& left, const auto& right) {
+        return left.location < right.location;
+    });
+    std::sort(mReflection.specializationConstants.begin(), mReflection.specializationConstants.end(), [](const auto& left, const auto& right) {
+        return left.id < right.id;
+    });
+    return std::move(mReflection);
+}
+
+bool Parser::readDeclarations()
+{
+    for (std::size_t position = Spirv::headerSize; position < mCode.size();)
+    {
+        const uint32_t wordsCount = mCode[position] >> 16;
+        if (wordsCount == 0 || wordsCount > mCode.size() - position)
+        {
+            return false;
+        }
+        const auto instruction = mCode.subspan(position, wordsCount);
+        position += wordsCount;
+
+        // the result id is the first operand of types and the second one of values
+        uint32_t resultId = 0;
+        switch (const uint32_t opcode = getOpcode(instruction); opcode)
+        {
+        case Spirv::OpFunction:
+            return true;
+        case Spirv::OpEntryPoint:
+            if (instruction.size() < 3)
+            {
+                return false;
+            }
+            if (mReflection.stage == ShaderStage::Unknown && instruction[1] < std::size(Spirv::stages))
+            {
+                mReflection.stage = Spirv::stages[instruction[1]];
+            }
+            break;
+        case Spirv::OpDecorate:
+            readDecoration(instruction);
+            break;
+        case Spirv::OpMemberDecorate:
+            readMemberDecoration(instruction);
+            break;
+        case Spirv::OpTypeBool:
+        case Spirv::OpTypeInt:
+        case Spirv::OpTypeFloat:
+        case Spirv::OpTypeVector:
+        case Spirv::OpTypeMatrix:
+        case Spirv::OpTypeImage:
+        case Spirv::OpTypeSampler:
+        case Spirv::OpTypeSampledImage:
+        case Spirv::OpTypeArray:
+        case Spirv::OpTypeRuntimeArray:
+        case Spirv::OpTypeStruct:
+        case Spirv::OpTypePointer:
+        case Spirv::OpTypeAccelerationStructureKHR:
+            resultId = instruction.size() > 1 ? instruction[1] : 0;
+            break;
+        case Spirv::OpConstant:
+        case Spirv::OpSpecConstantTrue:
+        case Spirv::OpSpecConstantFalse:
+        case Spirv::OpSpecConstant:
+        case Spirv::OpVariable:
+            if (instruction.size() < 3)
+            {
+                return false;
+            }
+            resultId = instruction[2];
+            if (opcode == Spirv::OpVariable)
+            {
+                if (instruction.size() < 4)
+                {
+                    return false;
+                }
+                mVariables.push_back(resultId);
+            }
+            else if (opcode != Spirv::OpConstant)
+            {
+                mSpecializationConstants.push_back(resultId);
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (resultId >= mDefinitions.size())
+        {
+            return false;
+        }
+        if (resultId != 0)
+        {
+            mDefinitions[resultId] = instruction;
+        }
+    }
+    return true;
+}
+
+void Parser::readDecoration(std::span<const uint32_t> instruction)
+{
+    if (instruction.size() < 3 || instruction[1] >= mDecorations.size())
+    {
+        return;
+    }
+
+    Decorations& decorations = mDecorations[instruction[1]];
+    const auto value         = instruction.size() > 3 ? std::optional<uint32_t>(instruction[3]) : std::nullopt;
+    switch (instruction[2])
+    {
+    case Spirv::DecorationSpecId:
+        decorations.specId = value;
+        break;
+    case Spirv::DecorationBlock:
+        decorations.isBlock = true;
+        break;
+    case Spirv::DecorationBufferBlock:
+        decorations.isBufferBlock = true;
+        break;
+    case Spirv::DecorationArrayStride:
+        decorations.arrayStride = value.value_or(0);
+        break;
+    case Spirv::DecorationBuiltIn:
+        decorations.isBuiltIn = true;
+        break;
+    case Spirv::DecorationLocation:
+        decorations.location = value;
+        break;
+    case Spirv::DecorationBinding:
+        decorations.binding = value;
+        break;
+    case Spirv::DecorationDescriptorSet:
+        decorations.set = value;
+        break;
+    default:
+        break;
+    }
+}
+
+void Parser::readMemberDecoration(std::span<const uint32_t> instruction)
+{
+    if (instruction.size() < 5 || (instruction[3] != Spirv::DecorationOffset && instruction[3] != Spirv::DecorationMatrixStride))
+    {
+        return;
+    }
+
+    // the struct may be defined after its decorations, so the members can't be counted yet
+    auto& members = mMemberDecorations[instruction[1]];
+    if (instruction[2] >= members.size())
+    {
+        if (instruction[2] >= mCode.size())
+        {
+            return;
+        }
+        members.resize(instruction[2] + 1);
+    }
+
+    if (instruction[3] == Spirv::DecorationOffset)
+    {
+        members[instruction[2]].offset = instruction[4];
+    }
+    else
+    {
+        members[instruction[2]].matrixStride = instruction[4];
+    }
+}
+
+bool Parser::addResource(uint32_t variableId, uint32_t typeId, uint32_t storageClass)
+{
+    ShaderResourceBinding resourceBinding;
+    resourceBinding.set     = mDecorations[variableId].set.value_or(0);
+    resourceBinding.binding = *mDecorations[variableId].binding;
+
+    auto type = getDefinition(typeId);
+    for (int depth = 0; getOpcode(type) == Spirv::OpTypeArray || getOpcode(type) == Spirv::OpTypeRuntimeArray; ++depth)
+    {
+        if (depth == maxTypeDepth || type.size() < 3)
+        {
+            return false;
+        }
+        if (getOpcode(type) == Spirv::OpTypeArray)
+        {
+            const auto length = type.size() > 3 ? getConstant(type[3]) : std::nullopt;
+            if (!length)
+            {
+                return false;
+            }
+            resourceBinding.count *= *length;
+        }
+        else
+        {
+            resourceBinding.count = 0;
+        }
+        typeId = type[2];
+        type   = getDefinition(typeId);
+    }
+
+    switch (getOpcode(type))
+    {
+    case Spirv::OpTypeStruct:
+        if (storageClass == Spirv::StorageClassStorageBuffer || mDecorations[typeId].isBufferBlock)
+        {
+            resourceBinding.type = ShaderResourceType::StorageBuffer;
+        }
+        else if (mDecorations[typeId].isBlock)
+        {
+            resourceBinding.type = ShaderResourceType::UniformBuffer;
+        }
+        else
+        {
+            return false;
+        }
+        break;
+    case Spirv::OpTypeSampler:
+        resourceBinding.type = ShaderResourceType::Sampler;
+        break;
+    case Spirv::OpTypeSampledImage:
+        resourceBinding.type = ShaderResourceType::CombinedImageSampler;
+        break;
+    case Spirv::OpTypeImage:
+    {
+        // OpTypeImage result, sampled type, dim, depth, arrayed, multisampled, sampled (1 - with a sampler, 2 - storage)
+        if (type.size() < 8)
+        {
+            return false;
+        }
+        const bool isStorage = type[7] == 2;
+        if (type[3] == Spirv::DimSubpassData)
+        {
+            resourceBinding.type = ShaderResourceType::InputAttachment;
+        }
+        else if (type[3] == Spirv::DimBuffer)
+        {
+            resourceBinding.type = isStorage ? ShaderResourceType::StorageTexelBuffer : ShaderResourceType::UniformTexelBuffer;
+        }
+        else
+        {
+            resourceBinding.type = isStorage ? ShaderResourceType::StorageImage : ShaderResourceType::SampledImage;
+        }
+        break;
+    }
+    case Spirv::OpTypeAccelerationStructureKHR:
+        resourceBinding.type = ShaderResourceType::AccelerationStructure;
+        break;
+    default:
+        return false;
+    }
+
+    mReflection.resourceBindings.push_back(resourceBinding);
+    return true;
+}
+
+bool Parser::addPushConstants(uint32_t typeId)
+{
+    const auto type = getDefinition(typeId);
+    if (getOpcode(type) != Spirv::OpTypeStruct)
+    {
+        return false;
+    }
+
+    const auto& members = mMemberDecorations[typeId];
+    uint32_t begin      = UINT32_MAX;
+    uint32_t end        = 0;
+    for (std::size_t i = 2; i < type.size(); ++i)
+    {
+        const auto member = i - 2 < members.size() ? members[i - 2] : MemberDecorations{};
+        const auto size   = getSize(type[i], member.matrixStride, 0);
+        if (!size)
+        {
+            return false;
+        }
+        begin = std::min(begin, member.offset);
+        end   = std::max(end, member.offset + *size);
+    }
+    if (begin >= end)
+    {
+        return true;
+    }
+
+    ShaderPushConstants pushConstants;
+    pushConstants.offset = begin & ~3u;
+    pushConstants.size   = ((end + 3u) & ~3u) - pushConstants.offset;
+    if (mReflection.pushConstants)
+    {
+        // a module declares a single push constant block, but be tolerant
+        auto& merged          = *mReflection.pushConstants;
+        const uint32_t mergedEnd = std::max(merged.offset + merged.size, pushConstants.offset + pushConstants.size);
+        merged.offset            = std::min(merged.offset, pushConstants.offset);
+        merged.size              = mergedEnd - merged.offset;
+    }
+    else
+    {
+        mReflection.pushConstants = pushConstants;
+    }
+    return true;
+}
+
+bool Parser::addVertexInputs(uint32_t typeId, uint32_t location, int depth)
+{
+    const auto type = getDefinition(typeId);
+    if (depth == maxTypeDepth || type.size() < 3)
+    {
+        return false;
+    }
+
+    ShaderVertexInput vertexInput;
+    vertexInput.location = location;
+    switch (getOpcode(type))
+    {
+    case Spirv::OpTypeBool:
+    case Spirv::OpTypeInt:
+    case Spirv::OpTypeFloat:
+        if (!getScalarType(typeId, vertexInput.scalarType, vertexInput.bitWidth))
+        {
+            return false;
+        }
+        mReflection.vertexInputs.push_back(vertexInput);
+        return true;
+    case Spirv::OpTypeVector:
+        if (type.size() < 4 || !getScalarType(type[2], vertexInput.scalarType, vertexInput.bitWidth))
+        {
+            return false;
+        }
+        vertexInput.componentsCount = type[3];
+        mReflection.vertexInputs.push_back(vertexInput);
+        return true;
+    case Spirv::OpTypeMatrix:
+    case Spirv::OpTypeArray:
+    {
+        if (type.size() < 4)
+        {
+            return false;
+        }
+        const auto elementsCount = getOpcode(type) == Spirv::OpTypeMatrix ? type[3] : getConstant(type[3]);
+        if (!elementsCount)
+        {
+            return false;
+        }
+
+        // a column or an element per location, 64-bit vectors of 3 and 4 components take two
+        for (uint32_t i = 0; i < *elementsCount; ++i)
+        {
+            const std::size_t inputsCount = mReflection.vertexInputs.size();
+            if (!addVertexInputs(type[2], location, depth + 1))
+            {
+                return false;
+            }
+            for (std::size_t j = inputsCount; j < mReflection.vertexInputs.size(); ++j)
+            {
+                const auto& input = mReflection.vertexInputs[j];
+                location          = std::max(location, input.location + (input.bitWidth == 64 && input.componentsCount > 2 ? 2 : 1));
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool Parser::addSpecializationConstant(uint32_t constantId)
+{
+    const auto constant = getDefinition(constantId);
+    if (!mDecorations[constantId].specId)
+    {
+        // can't be set by the application then
+        return true;
+    }
+
+    ShaderSpecializationConstant specializationConstant;
+    specializationConstant.id = *mDecorations[constantId].specId;
+    if (!getScalarType(constant[1], specializationConstant.scalarType, specializationConstant.bitWidth))
+    {
+        return false;
+    }
+
+    switch (getOpcode(constant))
+    {
+    case Spirv::OpSpecConstantTrue:
+        specializationConstant.defaultValue = 1;
+        break;
+    case Spirv::OpSpecConstantFalse:
+        specializationConstant.defaultValue = 0;
+        break;
+    default:
+        if (constant.size() < 4)
+        {
+            return false;
+        }
+        specializationConstant.defaultValue = constant[3];
+        if (constant.size() > 4)
+        {
+            specializationConstant.defaultValue |= static_cast<uint64_t>(constant[4]) << 32;
+        }
+        break;
+    }
+
+    mReflection.specializationConstants.push_back(specializationConstant);
+    return true;
+}
+
+std::optional<uint32_t> Parser::getConstant(uint32_t id) const
+{
+    const auto constant = getDefinition(id);
+    if ((getOpcode(constant) != Spirv::OpConstant && getOpcode(constant) != Spirv::OpSpecConstant) || constant.size() < 4)
+    {
+        return std::nullopt;
+    }
+    return constant[3];
+}
+
+std::optional<uint32_t> Parser::getSize(uint32_t typeId, uint32_t matrixStride, int depth) const
+{
+    const auto type = getDefinition(typeId);
+    if (depth == maxTypeDepth || type.size() < 2)
+    {
+        return std::nullopt;
+    }
+
+    switch (getOpcode(type))
+    {
+    case Spirv::OpTypeBool:
+        return 4;
+    case Spirv::OpTypeInt:
+    case Spirv::OpTypeFloat:
+        return type.size() > 2 ? std::optional<uint32_t>(type[2] / 8) : std::nullopt;
+    case Spirv::OpTypeVector:
+    case Spirv::OpTypeMatrix:
+    {
+        if (type.size() < 4)
+        {
+            return std::nullopt;
+        }
+        const auto componentSize = getSize(type[2], 0, depth + 1);
+        if (!componentSize)
+        {
+            return std::nullopt;
+        }
+        const bool isMatrix = getOpcode(type) == Spirv::OpTypeMatrix;
+        return type[3] * (isMatrix && matrixStride > 0 ? matrixStride : *componentSize);
+    }
+    case Spirv::OpTypeArray:
+    {
+        const auto length      = type.size() > 3 ? getConstant(type[3]) : std::nullopt;
+        const auto elementSize = type.size() > 2 ? getSize(type[2], matrixStride, depth + 1) : std::nullopt;
+        if (!length || !elementSize)
+        {
+            return std::nullopt;
+        }
+        return *length * (mDecorations[typeId].arrayStride > 0 ? mDecorations[typeId].arrayStride : *elementSize);
+    }
+    case Spirv::OpTypeRuntimeArray:
+        return 0;
+    case Spirv::OpTypeStruct:
+    {
+        const auto members = mMemberDecorations.find(typeId);
+        uint32_t size      = 0;
+        for (std::size_t i = 2; i < type.size(); ++i)
+        {
+            const bool isDecorated = members != mMemberDecorations.end() && i - 2 < members->second.size();
+            const auto member      = isDecorated ? members->second[i - 2] : MemberDecorations{};
+            const auto memberSize  = getSize(type[i], member.matrixStride, depth + 1);
+            if (!memberSize)
+            {
+                return std::nullopt;
+            }
+            size = std::max(size, member.offset + *memberSize);
+        }
+        return size;
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+bool Parser::getScalarType(uint32_t typeId, ShaderScalarType& scalarType, uint32_t& bitWidth) const
+{
+    const auto type = getDefinition(typeId);
+    switch (getOpcode(type))
+    {
+    case Spirv::OpTypeBool:
+        scalarType = ShaderScalarType::Bool;
+        bitWidth   = 32;
+        return true;
+    case Spirv::OpTypeInt:
+        if (type.size() < 4)
+        {
+            return false;
+        }
+        scalarType = type[3] ? ShaderScalarType::Int : ShaderScalarType::Uint;
+        bitWidth   = type[2];
+        return true;
+    case Spirv::OpTypeFloat:
+        if (type.size() < 3)
+        {
+            return false;
+        }
+        scalarType = ShaderScalarType::Float;
+        bitWidth   = type[2];
+        return true;
+    default:
+        return false;
+    }
+}
+} // namespace
+
+std::optional<ShaderReflection> ShaderReflection::reflect(std::span<const uint32_t> code)
+{
+    return Parser(code).parse();
+}
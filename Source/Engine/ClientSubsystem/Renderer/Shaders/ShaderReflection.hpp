@@ -0,0 +1,98 @@
+/*
+ *  ShaderReflection.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Kompot::Rendering
+{
+// the values are the ones of VkShaderStageFlagBits
+enum class ShaderStage : uint32_t
+{
+    Unknown                = 0,
+    Vertex                 = 0x01,
+    TessellationControl    = 0x02,
+    TessellationEvaluation = 0x04,
+    Geometry               = 0x08,
+    Fragment               = 0x10,
+    Compute                = 0x20
+};
+
+// the values are the ones of VkDescriptorType
+enum class ShaderResourceType : uint32_t
+{
+    Sampler               = 0,
+    CombinedImageSampler  = 1,
+    SampledImage          = 2,
+    StorageImage          = 3,
+    UniformTexelBuffer    = 4,
+    StorageTexelBuffer    = 5,
+    UniformBuffer         = 6,
+    StorageBuffer         = 7,
+    InputAttachment       = 10,
+    AccelerationStructure = 1000150000
+};
+
+enum class ShaderScalarType : uint8_t
+{
+    Bool,
+    Int,
+    Uint,
+    Float
+};
+
+struct ShaderResourceBinding
+{
+    uint32_t set            = 0;
+    uint32_t binding        = 0;
+    ShaderResourceType type = ShaderResourceType::UniformBuffer;
+    uint32_t count          = 1; // elements of a descriptor array, 0 for runtime sized arrays
+};
+
+struct ShaderPushConstants
+{
+    uint32_t offset = 0;
+    uint32_t size   = 0; // in bytes, a multiple of 4
+};
+
+struct ShaderVertexInput
+{
+    uint32_t location           = 0;
+    ShaderScalarType scalarType = ShaderScalarType::Float;
+    uint32_t bitWidth           = 32;
+    uint32_t componentsCount    = 1;
+};
+
+struct ShaderSpecializationConstant
+{
+    uint32_t id                 = 0; // constant_id of the GLSL layout
+    ShaderScalarType scalarType = ShaderScalarType::Int;
+    uint32_t bitWidth           = 32;
+    uint64_t defaultValue       = 0; // bits of the value, booleans are 0 or 1
+};
+
+/*
+ * Interface of a SPIR-V module: descriptor bindings, push constants, vertex inputs and
+ * specialization constants, the stage is the one of its first entry point. Only the declarations before the first
+ * function are parsed, so reflecting a module is a single pass over a small part of it.
+ */
+struct ShaderReflection
+{
+    ShaderStage stage = ShaderStage::Unknown;
+    std::vector<ShaderResourceBinding> resourceBindings;               // sorted by set and binding
+    std::optional<ShaderPushConstants> pushConstants;
+    std::vector<ShaderVertexInput> vertexInputs;                       // sorted by location, vertex shaders only
+    std::vector<ShaderSpecializationConstant> specializationConstants; // sorted by id
+
+    // nullopt if the code isn't SPIR-V or is malformed
+    static std::optional<ShaderReflection> reflect(std::span<const uint32_t> code);
+};
+
+} // namespace Kompot::Rendering
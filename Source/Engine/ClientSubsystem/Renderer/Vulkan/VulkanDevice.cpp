@@ -15,7 +15,7 @@ using namespace Kompot;
 using namespace Kompot::Rendering::Vulkan;
 
 
-VulkanDevice::VulkanDevice(const vk::Instance& vkInstance, const vk::PhysicalDevice& vkPhysicalDevice) :
+VulkanDevice::VulkanDevice(const vk::Instance& vkInstance, const vk::PhysicalDevice& vkPhysicalDevice, bool isHeadless) :
     mVkInstance(vkInstance), mVkPhysicalDevice(vkPhysicalDevice)
 {
     check(mVkInstance);
@@ -29,25 +29,28 @@ VulkanDevice::VulkanDevice(const vk::Instance& vkInstance, const vk::PhysicalDev
 
     const std::set<std::uint32_t> uniqueQueueFamilyIndicies = queueFamilies.getUniqueQueueFamilyIndicies();
 
-    std::vector<vk::DeviceQueueCreateInfo> queuesCreateInfos{uniqueQueueFamilyIndicies.size()};
-    std::vector<std::vector<float>> queuePriorities{uniqueQueueFamilyIndicies.size()};
-
-    auto uniqueQueueFamilyIndiciesIterator = uniqueQueueFamilyIndicies.begin();
-
-    for (std::size_t i = 0; i < uniqueQueueFamilyIndicies.size(); ++i)
+    // the first queue of each family is used only, the counts of a dedicated transfer family are usually small
+    const float queuePriority = 1.0f;
+    std::vector<vk::DeviceQueueCreateInfo> queuesCreateInfos;
+    for (const auto queueFamilyIndex : uniqueQueueFamilyIndicies)
     {
-        queuePriorities[i].resize(queueFamilies.computeCount);
-        queuesCreateInfos[i]
-                .setQueueFamilyIndex(*uniqueQueueFamilyIndiciesIterator++)
-                .setQueueCount(queueFamilies.graphicsCount)
-                .setQueuePriorities(queuePriorities[i]);
+        queuesCreateInfos.push_back(vk::DeviceQueueCreateInfo{}
+                .setQueueFamilyIndex(queueFamilyIndex)
+                .setQueueCount(1)
+                .setPQueuePriorities(&queuePriority));
     }
 
-    const auto extensions       = Utils::getRequiredDeviceExtensions();
+    const auto extensions       = Utils::getRequiredDeviceExtensions(isHeadless);
     const auto validationLayers = Utils::getRequiredDeviceValidationLayers();
 
-    auto vkDeviceCreateInfo =
-            vk::DeviceCreateInfo().setQueueCreateInfos(queuesCreateInfos).setPEnabledExtensionNames(extensions).setPEnabledLayerNames(validationLayers);
+    // VulkanUploadManager tracks the uploads by timeline semaphores, VulkanRenderer::selectPhysicalDevice() skips the devices without them
+    const auto vulkan12Features = vk::PhysicalDeviceVulkan12Features{}.setTimelineSemaphore(VK_TRUE);
+
+    auto vkDeviceCreateInfo = vk::DeviceCreateInfo()
+            .setPNext(&vulkan12Features)
+            .setQueueCreateInfos(queuesCreateInfos)
+            .setPEnabledExtensionNames(extensions)
+            .setPEnabledLayerNames(validationLayers);
 
     if (const auto result = mVkPhysicalDevice.createDevice(vkDeviceCreateInfo); result.result == vk::Result::eSuccess)
     {
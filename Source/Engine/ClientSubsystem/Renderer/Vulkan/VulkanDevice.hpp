@@ -18,7 +18,8 @@ namespace Kompot::Rendering::Vulkan
 class VulkanDevice
 {
 public:
-    VulkanDevice(const vk::Instance& vkInstance, const vk::PhysicalDevice& vkPhysicalDevice);
+    // a headless device is created without VK_KHR_swapchain, so it works on drivers without presentation
+    VulkanDevice(const vk::Instance& vkInstance, const vk::PhysicalDevice& vkPhysicalDevice, bool isHeadless = false);
     ~VulkanDevice();
 
     const vk::Device asLogicDevice() const
@@ -0,0 +1,173 @@
+/*
+ *  VulkanFrameAllocator.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "VulkanFrameAllocator.hpp"
+#include <Engine/ErrorHandling.hpp>
+#include <Engine/Log/Log.hpp>
+#include <algorithm>
+
+using namespace Kompot;
+using namespace Kompot::Rendering;
+using namespace Kompot::Rendering::Vulkan;
+
+namespace
+{
+// guaranteed maxUniformBufferRange is 16 KiB, more than this is rarely needed by a block
+constexpr vk::DeviceSize maxUniformRange = 64 * 1024;
+} // namespace
+
+void VulkanFrameAllocator::setDevice(vk::PhysicalDevice physicalDevice, vk::Device device, VmaAllocator_T* allocator, vk::DeviceSize frameSize)
+{
+    mDevice    = device;
+    mAllocator = allocator;
+    mFrameSize = frameSize;
+
+    const auto& limits = physicalDevice.getProperties().limits;
+    mAlignment         = std::max<vk::DeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+    mUniformRange      = std::min<vk::DeviceSize>(limits.maxUniformBufferRange, maxUniformRange);
+
+    const auto binding = vk::DescriptorSetLayoutBinding{}
+            .setBinding(frameUniformBinding)
+            .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+            .setDescriptorCount(1)
+            .setStageFlags(vk::ShaderStageFlagBits::eAllGraphics);
+    if (const auto result = mDevice.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{}.setBindingCount(1).setPBindings(&binding));
+            result.result == vk::Result::eSuccess)
+    {
+        mDescriptorSetLayout = result.value;
+    }
+    else
+    {
+        Kompot::ErrorHandling::exit("Failed to create a DescriptorSetLayout, result code \"" + vk::to_string(result.result) + "\"");
+    }
+}
+
+void VulkanFrameAllocator::destroy()
+{
+    if (mDevice)
+    {
+        mDevice.destroy(mDescriptorSetLayout);
+    }
+    *this = VulkanFrameAllocator{};
+}
+
+void VulkanFrameAllocator::createBuffers(std::span<VulkanFrameData> frames)
+{
+    const auto poolSize = vk::DescriptorPoolSize{}
+            .setType(vk::DescriptorType::eUniformBufferDynamic)
+            .setDescriptorCount(static_cast<uint32_t>(frames.size()));
+    const auto descriptorPoolCreateInfo = vk::DescriptorPoolCreateInfo{}
+            .setMaxSets(static_cast<uint32_t>(frames.size()))
+            .setPoolSizeCount(1)
+            .setPPoolSizes(&poolSize);
+    if (const auto result = mDevice.createDescriptorPool(descriptorPoolCreateInfo); result.result == vk::Result::eSuccess)
+    {
+        mDescriptorPool = result.value;
+    }
+    else
+    {
+        Kompot::ErrorHandling::exit("Failed to create a DescriptorPool, result code \"" + vk::to_string(result.result) + "\"");
+    }
+
+    // a dynamic offset is added to the descriptor range, so the range past the frame size has to be in the buffer too
+    const VkBufferCreateInfo bufferCreateInfo = vk::BufferCreateInfo{}
+            .setSize(mFrameSize + mUniformRange)
+            .setUsage(vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer)
+            .setSharingMode(vk::SharingMode::eExclusive);
+    VmaAllocationCreateInfo bufferAllocationCreateInfo{};
+    bufferAllocationCreateInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    bufferAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    for (auto& frame : frames)
+    {
+        auto& frameMemory = frame.frameMemory;
+
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocationInfo bufferAllocationInfo{};
+        if (const auto result = vmaCreateBuffer(
+                    mAllocator, &bufferCreateInfo, &bufferAllocationCreateInfo, &buffer, &frameMemory.allocation, &bufferAllocationInfo);
+                result != VK_SUCCESS)
+        {
+            Kompot::ErrorHandling::exit("Failed to create a frame buffer, result code \"" + vk::to_string(vk::Result(result)) + "\"");
+        }
+        frameMemory.buffer   = buffer;
+        frameMemory.data     = static_cast<std::byte*>(bufferAllocationInfo.pMappedData);
+        frameMemory.usedSize = 0;
+
+        const auto descriptorSetAllocateInfo = vk::DescriptorSetAllocateInfo{}
+                .setDescriptorPool(mDescriptorPool)
+                .setDescriptorSetCount(1)
+                .setPSetLayouts(&mDescriptorSetLayout);
+        if (const auto result = mDevice.allocateDescriptorSets(descriptorSetAllocateInfo);
+                result.result == vk::Result::eSuccess && result.value.size() == 1)
+        {
+            frameMemory.descriptorSet = result.value[0];
+        }
+        else
+        {
+            Kompot::ErrorHandling::exit("Failed to allocate a DescriptorSet, result code \"" + vk::to_string(result.result) + "\"");
+        }
+
+        const auto bufferInfo      = vk::DescriptorBufferInfo{}.setBuffer(frameMemory.buffer).setOffset(0).setRange(mUniformRange);
+        const auto descriptorWrite = vk::WriteDescriptorSet{}
+                .setDstSet(frameMemory.descriptorSet)
+                .setDstBinding(frameUniformBinding)
+                .setDescriptorCount(1)
+                .setDescriptorType(vk::DescriptorType::eUniformBufferDynamic)
+                .setPBufferInfo(&bufferInfo);
+        mDevice.updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+    }
+}
+
+void VulkanFrameAllocator::destroyBuffers(std::span<VulkanFrameData> frames)
+{
+    for (auto& frame : frames)
+    {
+        auto& frameMemory = frame.frameMemory;
+        if (frameMemory.buffer)
+        {
+            vmaDestroyBuffer(mAllocator, static_cast<VkBuffer>(frameMemory.buffer), frameMemory.allocation);
+        }
+        frameMemory = VulkanFrameMemory{};
+    }
+
+    // frees the descriptor sets
+    if (mDescriptorPool)
+    {
+        mDevice.destroy(mDescriptorPool);
+        mDescriptorPool = nullptr;
+    }
+}
+
+void VulkanFrameAllocator::endFrame(VulkanFrameData& frame)
+{
+    // does nothing if the memory VMA has picked is host coherent
+    if (frame.frameMemory.usedSize > 0)
+    {
+        vmaFlushAllocation(mAllocator, frame.frameMemory.allocation, 0, frame.frameMemory.usedSize);
+    }
+}
+
+VulkanFrameAllocation VulkanFrameAllocator::allocate(VulkanFrameData& frame, vk::DeviceSize size)
+{
+    auto& frameMemory = frame.frameMemory;
+
+    const vk::DeviceSize offset = (frameMemory.usedSize + mAlignment - 1) / mAlignment * mAlignment;
+    if (!frameMemory.data || size == 0 || offset + size > mFrameSize)
+    {
+        ENGINE_LOG_BINARY_LIMITED(Error, Renderer, 1, "the frame memory of {frameSize} bytes has no {size} bytes left", mFrameSize, size);
+        return {};
+    }
+
+    frameMemory.usedSize = offset + size;
+    return VulkanFrameAllocation{frameMemory.buffer, static_cast<uint32_t>(offset), frameMemory.data + offset};
+}
+
+void VulkanFrameAllocator::bindUniforms(VulkanFrameData& frame, vk::PipelineLayout pipelineLayout, const VulkanFrameAllocation& allocation) const
+{
+    frame.vkCommandBuffer.bindDescriptorSets(
+            vk::PipelineBindPoint::eGraphics, pipelineLayout, frameUniformSet, 1, &frame.frameMemory.descriptorSet, 1, &allocation.offset);
+}
@@ -0,0 +1,104 @@
+/*
+ *  VulkanFrameAllocator.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "VulkanTypes.hpp"
+#include <Memory/VulkanAllocator/VulkanAllocator.hpp>
+#include <vulkan/vulkan.hpp>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace Kompot::Rendering::Vulkan
+{
+// a part of the frame memory, valid until the frame slot is reused
+struct VulkanFrameAllocation
+{
+    vk::Buffer buffer;
+    uint32_t offset = 0; // the dynamic offset of the frame descriptor set
+    void* data      = nullptr;
+
+    explicit operator bool() const
+    {
+        return data != nullptr;
+    }
+};
+
+/*
+ * Per-frame data for the shaders: uniforms, instance data, dynamic vertices. Every frame slot has a persistently mapped
+ * host visible buffer, an allocation is a pointer bump and the caller's memcpy. The slot is reset once its fence is passed,
+ * there are no frees. The allocations are aligned to minUniformBufferOffsetAlignment, the uniform blocks are bound
+ * through the descriptor set of the slot with their offset as the dynamic one, see bindUniforms().
+ * The graphics shaders declare that block at frameUniformBinding of frameUniformSet, the set is reserved for it.
+ */
+class VulkanFrameAllocator
+{
+public:
+    static constexpr vk::DeviceSize defaultFrameSize = 4 * 1024 * 1024;
+    static constexpr uint32_t frameUniformSet        = 0;
+    static constexpr uint32_t frameUniformBinding    = 0;
+
+    void setDevice(vk::PhysicalDevice physicalDevice, vk::Device device, VmaAllocator_T* allocator, vk::DeviceSize frameSize = defaultFrameSize);
+    // the frame buffers must be destroyed already
+    void destroy();
+
+    void createBuffers(std::span<VulkanFrameData> frames);
+    // the frames must not be in use anymore
+    void destroyBuffers(std::span<VulkanFrameData> frames);
+
+    // call once the fence of the frame is waited for, the previous allocations of the slot are dropped
+    void beginFrame(VulkanFrameData& frame)
+    {
+        frame.frameMemory.usedSize = 0;
+    }
+    // makes the writes visible to the device, call before the submission
+    void endFrame(VulkanFrameData& frame);
+
+    // an empty allocation if the frame is out of memory
+    VulkanFrameAllocation allocate(VulkanFrameData& frame, vk::DeviceSize size);
+
+    template <typename T>
+    VulkanFrameAllocation push(VulkanFrameData& frame, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "the value is copied to the device memory");
+
+        const auto allocation = allocate(frame, sizeof(T));
+        if (allocation)
+        {
+            std::memcpy(allocation.data, &value, sizeof(T));
+        }
+        return allocation;
+    }
+
+    // binds the allocation to frameUniformSet, the pipeline layout comes from VulkanPipelineLayoutCache
+    void bindUniforms(VulkanFrameData& frame, vk::PipelineLayout pipelineLayout, const VulkanFrameAllocation& allocation) const;
+
+    // frameUniformBinding is a dynamic uniform buffer visible to the graphics stages
+    vk::DescriptorSetLayout getDescriptorSetLayout() const
+    {
+        return mDescriptorSetLayout;
+    }
+
+    // the largest uniform block bindUniforms() can bind
+    vk::DeviceSize getUniformRange() const
+    {
+        return mUniformRange;
+    }
+
+private:
+    vk::Device mDevice;
+    VmaAllocator_T* mAllocator = nullptr;
+
+    vk::DeviceSize mFrameSize    = defaultFrameSize;
+    vk::DeviceSize mAlignment    = 1;
+    vk::DeviceSize mUniformRange = 0;
+
+    vk::DescriptorSetLayout mDescriptorSetLayout;
+    vk::DescriptorPool mDescriptorPool;
+};
+
+} // namespace Kompot::Rendering::Vulkan
@@ -0,0 +1,184 @@
+/*
+ *  VulkanGpuProfiler.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "VulkanGpuProfiler.hpp"
+#include <Engine/ErrorHandling.hpp>
+#include <Engine/Log/Log.hpp>
+#include <fstream>
+#include <vector>
+
+using namespace Kompot;
+using namespace Kompot::Rendering;
+using namespace Kompot::Rendering::Vulkan;
+
+void VulkanGpuProfiler::setDevice(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t queueFamilyIndex)
+{
+    mDevice = device;
+
+    const auto queueFamilyProperties = physicalDevice.getQueueFamilyProperties();
+
+    mTimestampPeriod    = physicalDevice.getProperties().limits.timestampPeriod;
+    mTimestampValidBits = queueFamilyIndex < queueFamilyProperties.size() ? queueFamilyProperties[queueFamilyIndex].timestampValidBits : 0;
+
+    if (!isSupported())
+    {
+        ENGINE_LOG(Warning, Renderer) << "The queue family " << queueFamilyIndex << " doesn't support timestamps, the GPU isn't profiled";
+    }
+}
+
+void VulkanGpuProfiler::createQueryPools(std::span<VulkanFrameData> frames)
+{
+    if (!isSupported())
+    {
+        return;
+    }
+
+    const auto queryPoolCreateInfo = vk::QueryPoolCreateInfo{}
+            .setQueryType(vk::QueryType::eTimestamp)
+            .setQueryCount(maxQueriesPerFrame);
+
+    for (auto& frame : frames)
+    {
+        if (const auto result = mDevice.createQueryPool(queryPoolCreateInfo); result.result == vk::Result::eSuccess)
+        {
+            frame.timestamps           = VulkanFrameTimestamps{};
+            frame.timestamps.queryPool = result.value;
+        }
+        else
+        {
+            Kompot::ErrorHandling::exit("Failed to create a QueryPool, result code \"" + vk::to_string(result.result) + "\"");
+        }
+    }
+}
+
+void VulkanGpuProfiler::destroyQueryPools(std::span<VulkanFrameData> frames)
+{
+    for (auto& frame : frames)
+    {
+        mDevice.destroy(frame.timestamps.queryPool);
+        frame.timestamps = VulkanFrameTimestamps{};
+    }
+}
+
+void VulkanGpuProfiler::beginFrame(VulkanFrameData& frame, std::size_t frameNumber)
+{
+    auto& timestamps = frame.timestamps;
+    if (!timestamps.queryPool)
+    {
+        return;
+    }
+
+    if (timestamps.queriesCount > 0)
+    {
+        readFrame(frame);
+    }
+
+    frame.vkCommandBuffer.resetQueryPool(timestamps.queryPool, 0, maxQueriesPerFrame);
+    timestamps.frameNumber  = frameNumber;
+    timestamps.queriesCount = 0;
+    timestamps.scopes.clear();
+    timestamps.openScopes.clear();
+}
+
+bool VulkanGpuProfiler::beginScope(VulkanFrameData& frame, std::string_view name)
+{
+    auto& timestamps = frame.timestamps;
+    if (!timestamps.queryPool)
+    {
+        return false;
+    }
+    if (timestamps.queriesCount + 2 > maxQueriesPerFrame)
+    {
+        ENGINE_LOG_BINARY_LIMITED(Warning, Renderer, 1, "GPU scope {name} is dropped, the frame has no timestamp queries left", name);
+        return false;
+    }
+
+    const auto depth = static_cast<uint32_t>(timestamps.openScopes.size());
+    timestamps.openScopes.push_back(static_cast<uint32_t>(timestamps.scopes.size()));
+    timestamps.scopes.push_back(GpuTimestampScope{name, depth, timestamps.queriesCount, timestamps.queriesCount + 1});
+    timestamps.queriesCount += 2;
+
+    // the previous commands don't have to finish, so it's when the scope's commands may start
+    frame.vkCommandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, timestamps.queryPool, timestamps.scopes.back().beginQuery);
+    return true;
+}
+
+void VulkanGpuProfiler::endScope(VulkanFrameData& frame)
+{
+    auto& timestamps = frame.timestamps;
+    if (timestamps.openScopes.empty())
+    {
+        ENGINE_LOG(Error, Renderer) << "GPU scope ended without being begun";
+        return;
+    }
+
+    const auto& scope = timestamps.scopes[timestamps.openScopes.back()];
+    timestamps.openScopes.pop_back();
+
+    // written once all the previous commands are finished
+    frame.vkCommandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, timestamps.queryPool, scope.endQuery);
+}
+
+double VulkanGpuProfiler::getAverageFrameMs() const
+{
+    if (mFrames.empty())
+    {
+        return 0.0;
+    }
+
+    double framesMs = 0.0;
+    for (const auto& frame : mFrames)
+    {
+        framesMs += frame.durationMs;
+    }
+    return framesMs / static_cast<double>(mFrames.size());
+}
+
+bool VulkanGpuProfiler::writeTrace(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    const std::vector<GpuFrameTimings> frames(mFrames.begin(), mFrames.end());
+    writeChromeTrace(file, frames);
+    return static_cast<bool>(file);
+}
+
+void VulkanGpuProfiler::readFrame(VulkanFrameData& frame)
+{
+    const auto& timestamps = frame.timestamps;
+    if (!timestamps.openScopes.empty())
+    {
+        // an end timestamp was never written, the results would never become available
+        ENGINE_LOG_BINARY_LIMITED(Error, Renderer, 1, "frame {frame}: GPU scopes aren't ended", timestamps.frameNumber);
+        return;
+    }
+
+    mTimestamps.resize(timestamps.queriesCount);
+    // no wait flag: the fence of the frame is passed, if the results still aren't there the frame is skipped
+    const auto result = mDevice.getQueryPoolResults(
+            timestamps.queryPool,
+            0,
+            timestamps.queriesCount,
+            mTimestamps.size() * sizeof(uint64_t),
+            mTimestamps.data(),
+            sizeof(uint64_t),
+            vk::QueryResultFlagBits::e64);
+    if (result != vk::Result::eSuccess)
+    {
+        ENGINE_LOG_BINARY_LIMITED(Warning, Renderer, 1, "frame {frame}: GPU timestamps result = {result}", timestamps.frameNumber, result);
+        return;
+    }
+
+    mFrames.push_back(getGpuFrameTimings(timestamps.frameNumber, timestamps.scopes, mTimestamps, mTimestampPeriod, mTimestampValidBits));
+    if (mFrames.size() > historySize)
+    {
+        mFrames.pop_front();
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ *  VulkanGpuProfiler.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "VulkanTypes.hpp"
+#include <Engine/ClientSubsystem/Renderer/GpuTimings.hpp>
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace Kompot::Rendering::Vulkan
+{
+/*
+ * Measures the GPU time of the scopes recorded to the frame command buffers with timestamp queries.
+ * Every frame slot has its own query pool, the results are read when the slot is reused, i.e. frames in flight
+ * frames later, after its fence is waited for, so reading them never stalls the CPU.
+ */
+class VulkanGpuProfiler
+{
+public:
+    static constexpr uint32_t maxQueriesPerFrame = 128;
+    static constexpr std::size_t historySize     = 240;
+
+    // the queue family the frames are submitted to, timestamps are unsupported by some transfer or compute only families
+    void setDevice(vk::PhysicalDevice physicalDevice, vk::Device device, uint32_t queueFamilyIndex);
+
+    bool isSupported() const
+    {
+        return mTimestampValidBits > 0;
+    }
+
+    void createQueryPools(std::span<VulkanFrameData> frames);
+    // the frames must not be in use anymore, their unread timings are dropped
+    void destroyQueryPools(std::span<VulkanFrameData> frames);
+
+    // call after the fence of the frame is waited for and its command buffer is begun, outside of a render pass
+    void beginFrame(VulkanFrameData& frame, std::size_t frameNumber);
+
+    // scopes nest, false if the queries of the frame are exhausted, endScope() is skipped then
+    bool beginScope(VulkanFrameData& frame, std::string_view name);
+    void endScope(VulkanFrameData& frame);
+
+    // the last frame read back, nullptr if there is none yet
+    const GpuFrameTimings* getLatestFrame() const
+    {
+        return mFrames.empty() ? nullptr : &mFrames.back();
+    }
+
+    // the last historySize frames read back, the oldest first
+    const std::deque<GpuFrameTimings>& getFrames() const
+    {
+        return mFrames;
+    }
+
+    double getAverageFrameMs() const;
+
+    // the history in the Chrome trace format
+    bool writeTrace(const std::filesystem::path& path) const;
+
+private:
+    void readFrame(VulkanFrameData& frame);
+
+    vk::Device mDevice;
+    double mTimestampPeriod      = 0.0; // nanoseconds per tick
+    uint32_t mTimestampValidBits = 0;
+    std::vector<uint64_t> mTimestamps;
+    std::deque<GpuFrameTimings> mFrames;
+};
+
+// ends the scope when it goes out of C++ scope
+class VulkanGpuScope
+{
+public:
+    VulkanGpuScope(VulkanGpuProfiler& profiler, VulkanFrameData& frame, std::string_view name)
+        : mProfiler(profiler), mFrame(frame), mIsBegun(profiler.beginScope(frame, name))
+    {
+    }
+
+    ~VulkanGpuScope()
+    {
+        if (mIsBegun)
+        {
+            mProfiler.endScope(mFrame);
+        }
+    }
+
+    VulkanGpuScope(const VulkanGpuScope&)            = delete;
+    VulkanGpuScope& operator=(const VulkanGpuScope&) = delete;
+
+private:
+    VulkanGpuProfiler& mProfiler;
+    VulkanFrameData& mFrame;
+    const bool mIsBegun;
+};
+
+} // namespace Kompot::Rendering::Vulkan
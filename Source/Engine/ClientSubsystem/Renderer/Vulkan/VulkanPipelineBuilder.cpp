@@ -10,21 +10,68 @@
 #include <algorithm>
 
 using namespace Kompot;
+using namespace Kompot::Rendering;
 using namespace Kompot::Rendering::Vulkan;
 
+namespace
+{
+vk::Format getVertexFormat(const ShaderVertexInput& vertexInput)
+{
+    using enum vk::Format;
+    // R, RG, RGB and RGBA of 16, 32 and 64 bits
+    constexpr vk::Format floatFormats[3][4] = {
+            {eR16Sfloat, eR16G16Sfloat, eR16G16B16Sfloat, eR16G16B16A16Sfloat},
+            {eR32Sfloat, eR32G32Sfloat, eR32G32B32Sfloat, eR32G32B32A32Sfloat},
+            {eR64Sfloat, eR64G64Sfloat, eR64G64B64Sfloat, eR64G64B64A64Sfloat}};
+    constexpr vk::Format intFormats[3][4] = {
+            {eR16Sint, eR16G16Sint, eR16G16B16Sint, eR16G16B16A16Sint},
+            {eR32Sint, eR32G32Sint, eR32G32B32Sint, eR32G32B32A32Sint},
+            {eR64Sint, eR64G64Sint, eR64G64B64Sint, eR64G64B64A64Sint}};
+    constexpr vk::Format uintFormats[3][4] = {
+            {eR16Uint, eR16G16Uint, eR16G16B16Uint, eR16G16B16A16Uint},
+            {eR32Uint, eR32G32Uint, eR32G32B32Uint, eR32G32B32A32Uint},
+            {eR64Uint, eR64G64Uint, eR64G64B64Uint, eR64G64B64A64Uint}};
+
+    const int widthIndex = vertexInput.bitWidth == 16 ? 0 : vertexInput.bitWidth == 32 ? 1 : vertexInput.bitWidth == 64 ? 2 : -1;
+    if (widthIndex < 0 || vertexInput.componentsCount < 1 || vertexInput.componentsCount > 4)
+    {
+        return eUndefined;
+    }
+
+    switch (vertexInput.scalarType)
+    {
+    case ShaderScalarType::Float:
+        return floatFormats[widthIndex][vertexInput.componentsCount - 1];
+    case ShaderScalarType::Int:
+        return intFormats[widthIndex][vertexInput.componentsCount - 1];
+    case ShaderScalarType::Uint:
+        return uintFormats[widthIndex][vertexInput.componentsCount - 1];
+    default:
+        return eUndefined;
+    }
+}
+} // namespace
+
 void VulkanPipelineBuilder::setDevice(vk::Device device)
 {
     mDevice = device;
+    mLayoutCache.setDevice(device);
+}
+
+void VulkanPipelineBuilder::destroyLayouts()
+{
+    mLayoutCache.destroy();
 }
 
 vk::Result VulkanPipelineBuilder::buildGraphicsPipeline(
-        VulkanWindowRendererAttributes* windowRendererAttributes,
+        const vk::Rect2D& scissor,
         VulkanRenderer* renderer,
-        const std::vector<VulkanShader>& shaders)
+        const std::vector<VulkanShader>& shaders,
+        VulkanPipeline& builtPipeline)
 {
     VulkanPipeline pipeline{};
 
-    if (!windowRendererAttributes || !renderer)
+    if (!renderer)
     {
         return vk::Result::eErrorUnknown;
     }
@@ -46,7 +93,7 @@ vk::Result VulkanPipelineBuilder::buildGraphicsPipeline(
 
     if (shaderStagesFlags.size() != shaders.size() || haveInvalidShader)
     {
-        Log::getInstance() << "Tried to build a graphics pipeline with shaders of equal stages" << std::endl;
+        ENGINE_LOG(Error, Renderer) << "Tried to build a graphics pipeline with shaders of equal stages";
         return vk::Result::eErrorUnknown;
     }
 
@@ -57,17 +104,37 @@ vk::Result VulkanPipelineBuilder::buildGraphicsPipeline(
         shaderStages.emplace_back(createPipelineShaderStage(shader));
     }
 
+    std::vector<const ShaderReflection*> shaderReflections;
+    const ShaderReflection* vertexShaderReflection = nullptr;
+    for (const auto& shader : shaders)
+    {
+        shaderReflections.push_back(shader.getReflection());
+        if (shader.getStageFlag() == vk::ShaderStageFlagBits::eVertex)
+        {
+            vertexShaderReflection = shader.getReflection();
+        }
+    }
+
     // pipelien stages
-    const vk::PipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
+    vk::VertexInputBindingDescription vertexBinding;
+    std::vector<vk::VertexInputAttributeDescription> vertexAttributes;
+    const auto pipelineVertexInputStateCreateInfo = createVertexInputStateCreateInfo(vertexShaderReflection, vertexBinding, vertexAttributes);
+    if (std::any_of(vertexAttributes.cbegin(), vertexAttributes.cend(), [](const auto& attribute) {
+            return attribute.format == vk::Format::eUndefined;
+        }))
+    {
+        ENGINE_LOG(Error, Renderer) << "Tried to build a graphics pipeline with vertex inputs of unsupported types";
+        return vk::Result::eErrorUnknown;
+    }
 
     const auto inputAssemblyStateCreateInfo =
             createInputAssemblyStateCreateInfo(vk::PrimitiveTopology::eTriangleList, PrimitiveRestartOption::Disabled);
 
     const auto viewport = vk::Viewport{}
-            .setWidth(static_cast<float>(windowRendererAttributes->scissor.extent.width))
-            .setHeight(static_cast<float>(windowRendererAttributes->scissor.extent.height))
+            .setWidth(static_cast<float>(scissor.extent.width))
+            .setHeight(static_cast<float>(scissor.extent.height))
             .setMaxDepth(1.0f);
-    const auto viewportStateCreateInfo = createViewportStateCreateInfo(viewport, &windowRendererAttributes->scissor);
+    const auto viewportStateCreateInfo = createViewportStateCreateInfo(viewport, &scissor);
 
     const auto rasterizationStateCreateInfo =
             createRasterizationStateCreateInfo(vk::PolygonMode::eFill, vk::CullModeFlagBits::eBack, vk::FrontFace::eClockwise);
@@ -87,14 +154,11 @@ vk::Result VulkanPipelineBuilder::buildGraphicsPipeline(
 
     // VkPipelineDynamicStateCreateInfo
 
-    if (const auto createPipelineLayoutResult = mDevice.createPipelineLayout(createLayoutCreateInfo());
-            createPipelineLayoutResult.result == vk::Result::eSuccess)
+    // shared with the other pipelines of the same layout
+    pipeline.pipelineLayout = mLayoutCache.getPipelineLayout(shaderReflections);
+    if (!pipeline.pipelineLayout)
     {
-        pipeline.pipelineLayout = createPipelineLayoutResult.value;
-    }
-    else
-    {
-        Log::getInstance() << "Tried to build a graphics pipeline with shaders of equal stages" << std::endl;
+        ENGINE_LOG(Error, Renderer) << "Failed to derive a pipeline layout from the shaders";
         return vk::Result::eErrorUnknown;
     }
 
@@ -121,12 +185,11 @@ vk::Result VulkanPipelineBuilder::buildGraphicsPipeline(
     }
     else
     {
-        mDevice.destroy(pipeline.pipelineLayout);
-        Log::getInstance() << "Tried to build a graphics pipeline with shaders of equal stages" << std::endl;
+        ENGINE_LOG(Error, Renderer) << "Tried to build a graphics pipeline with shaders of equal stages";
         return vk::Result::eErrorUnknown;
     }
 
-    windowRendererAttributes->pipeline = pipeline;
+    builtPipeline = pipeline;
 
     return vk::Result::eSuccess;
 }
@@ -135,7 +198,11 @@ vk::PipelineShaderStageCreateInfo VulkanPipelineBuilder::createPipelineShaderSta
         const VulkanShader& shaderModule,
         const std::string_view& entryPointName)
 {
-    return vk::PipelineShaderStageCreateInfo{}.setModule(shaderModule.get()).setPName(entryPointName.data()).setStage(shaderModule.getStageFlag());
+    return vk::PipelineShaderStageCreateInfo{}
+            .setModule(shaderModule.get())
+            .setPName(entryPointName.data())
+            .setStage(shaderModule.getStageFlag())
+            .setPSpecializationInfo(shaderModule.getSpecializationInfo());
 }
 
 vk::PipelineInputAssemblyStateCreateInfo VulkanPipelineBuilder::createInputAssemblyStateCreateInfo(
@@ -146,7 +213,9 @@ vk::PipelineInputAssemblyStateCreateInfo VulkanPipelineBuilder::createInputAssem
                 primitiveRestartOption == PrimitiveRestartOption::Enabled);
 }
 
-vk::PipelineViewportStateCreateInfo VulkanPipelineBuilder::createViewportStateCreateInfo(const vk::Viewport& viewport, vk::Rect2D* viewportExtent)
+vk::PipelineViewportStateCreateInfo VulkanPipelineBuilder::createViewportStateCreateInfo(
+        const vk::Viewport& viewport,
+        const vk::Rect2D* viewportExtent)
 {
     return vk::PipelineViewportStateCreateInfo{}.setViewportCount(1).setPViewports(&viewport).setScissorCount(1).setPScissors(viewportExtent);
 }
@@ -176,7 +245,32 @@ vk::PipelineColorBlendStateCreateInfo VulkanPipelineBuilder::createColorBlendSta
     return vk::PipelineColorBlendStateCreateInfo{}.setAttachmentCount(1).setPAttachments(pipelineColorBlendAttachmentState);
 }
 
-vk::PipelineLayoutCreateInfo VulkanPipelineBuilder::createLayoutCreateInfo()
+vk::PipelineVertexInputStateCreateInfo VulkanPipelineBuilder::createVertexInputStateCreateInfo(
+        const ShaderReflection* vertexShaderReflection,
+        vk::VertexInputBindingDescription& binding,
+        std::vector<vk::VertexInputAttributeDescription>& attributes)
 {
-    return vk::PipelineLayoutCreateInfo{};
+    attributes.clear();
+    if (!vertexShaderReflection || vertexShaderReflection->vertexInputs.empty())
+    {
+        return vk::PipelineVertexInputStateCreateInfo{};
+    }
+
+    uint32_t offset = 0;
+    for (const auto& vertexInput : vertexShaderReflection->vertexInputs)
+    {
+        attributes.push_back(vk::VertexInputAttributeDescription{}
+                .setLocation(vertexInput.location)
+                .setBinding(0)
+                .setFormat(getVertexFormat(vertexInput))
+                .setOffset(offset));
+        offset += vertexInput.bitWidth / 8 * vertexInput.componentsCount;
+    }
+    binding = vk::VertexInputBindingDescription{}.setBinding(0).setStride(offset).setInputRate(vk::VertexInputRate::eVertex);
+
+    return vk::PipelineVertexInputStateCreateInfo{}
+            .setVertexBindingDescriptionCount(1)
+            .setPVertexBindingDescriptions(&binding)
+            .setVertexAttributeDescriptionCount(static_cast<uint32_t>(attributes.size()))
+            .setPVertexAttributeDescriptions(attributes.data());
 }
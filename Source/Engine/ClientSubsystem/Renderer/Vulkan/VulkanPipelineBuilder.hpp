@@ -8,6 +8,7 @@
 
 #include "VulkanTypes.hpp"
 #include "VulkanShader.hpp"
+#include "VulkanPipelineLayoutCache.hpp"
 #include <vulkan/vulkan.hpp>
 #include <vector>
 
@@ -25,23 +26,33 @@ class VulkanPipelineBuilder
 {
 public:
     void setDevice(vk::Device device);
+
+    // the pipeline layout is derived from the shaders reflection and belongs to the builder, see destroyLayouts()
     vk::Result buildGraphicsPipeline(
-            VulkanWindowRendererAttributes* windowRendererAttributes,
+            const vk::Rect2D& scissor,
             VulkanRenderer* renderer,
-            const std::vector<VulkanShader>& shaders);
+            const std::vector<VulkanShader>& shaders,
+            VulkanPipeline& builtPipeline);
+
+    // call once no pipeline built so far is in use
+    void destroyLayouts();
 
 protected: // static create info builders
     static vk::PipelineShaderStageCreateInfo createPipelineShaderStage(
             const VulkanShader& shaderModule,
             const std::string_view& entryPointName = "main");
 
-    // static vk::PipelineVertexInputStateCreateInfo createVertexInputStateCreateInfo(foo);
+    // one interleaved vertex buffer at binding 0, the attributes are packed in the order of their locations
+    static vk::PipelineVertexInputStateCreateInfo createVertexInputStateCreateInfo(
+            const ShaderReflection* vertexShaderReflection,
+            vk::VertexInputBindingDescription& binding,
+            std::vector<vk::VertexInputAttributeDescription>& attributes);
 
     static vk::PipelineInputAssemblyStateCreateInfo createInputAssemblyStateCreateInfo(
             vk::PrimitiveTopology topology,
             PrimitiveRestartOption primitiveRestartOption);
 
-    static vk::PipelineViewportStateCreateInfo createViewportStateCreateInfo(const vk::Viewport& viewport, vk::Rect2D* viewportExtent);
+    static vk::PipelineViewportStateCreateInfo createViewportStateCreateInfo(const vk::Viewport& viewport, const vk::Rect2D* viewportExtent);
 
     static vk::PipelineRasterizationStateCreateInfo createRasterizationStateCreateInfo(
             vk::PolygonMode polygonMode,
@@ -55,10 +66,9 @@ protected: // static create info builders
             const vk::PipelineColorBlendAttachmentState* pipelineColorBlendAttachmentState);
 
 
-    static vk::PipelineLayoutCreateInfo createLayoutCreateInfo();
-
 private:
     vk::Device mDevice;
+    VulkanPipelineLayoutCache mLayoutCache;
 
 
     //    std::vector<VkPipelineShaderStageCreateInfo> _shaderStages;
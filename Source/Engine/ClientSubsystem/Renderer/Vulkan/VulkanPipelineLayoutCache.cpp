@@ -0,0 +1,245 @@
+/*
+ *  VulkanPipelineLayoutCache.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "VulkanPipelineLayoutCache.hpp"
+#include "VulkanFrameAllocator.hpp"
+#include <Engine/Log/Log.hpp>
+#include <Misc/Hash.hpp>
+#include <algorithm>
+#include <optional>
+
+using namespace Kompot;
+using namespace Kompot::Rendering;
+using namespace Kompot::Rendering::Vulkan;
+
+namespace
+{
+// guaranteed maxBoundDescriptorSets is 4, no device goes beyond a few dozens
+constexpr uint32_t maxDescriptorSetsCount = 32;
+
+bool isEqual(const vk::DescriptorSetLayoutBinding& left, const vk::DescriptorSetLayoutBinding& right)
+{
+    return left.binding == right.binding && left.descriptorType == right.descriptorType && left.descriptorCount == right.descriptorCount &&
+           left.stageFlags == right.stageFlags;
+}
+
+bool isEqual(const vk::PushConstantRange& left, const vk::PushConstantRange& right)
+{
+    return left.offset == right.offset && left.size == right.size && left.stageFlags == right.stageFlags;
+}
+
+uint64_t getHash(std::span<const vk::DescriptorSetLayoutBinding> bindings)
+{
+    uint64_t hash = 0;
+    for (const auto& binding : bindings)
+    {
+        const uint32_t words[] = {
+                binding.binding,
+                static_cast<uint32_t>(binding.descriptorType),
+                binding.descriptorCount,
+                static_cast<VkShaderStageFlags>(binding.stageFlags)};
+        hash = Kompot::Hash::xxHash64(words, sizeof(words), hash);
+    }
+    return hash;
+}
+
+uint64_t getHash(std::span<const vk::DescriptorSetLayout> setLayouts, std::span<const vk::PushConstantRange> pushConstantRanges)
+{
+    uint64_t hash = 0;
+    // the set layouts are unique, so equal handles mean equal layouts
+    for (const auto& setLayout : setLayouts)
+    {
+        const auto handle = static_cast<VkDescriptorSetLayout>(setLayout);
+        hash              = Kompot::Hash::xxHash64(&handle, sizeof(handle), hash);
+    }
+    for (const auto& range : pushConstantRanges)
+    {
+        const uint32_t words[] = {range.offset, range.size, static_cast<VkShaderStageFlags>(range.stageFlags)};
+        hash                   = Kompot::Hash::xxHash64(words, sizeof(words), hash);
+    }
+    return hash;
+}
+} // namespace
+
+void VulkanPipelineLayoutCache::setDevice(vk::Device device)
+{
+    mDevice = device;
+}
+
+vk::PipelineLayout VulkanPipelineLayoutCache::getPipelineLayout(std::span<const ShaderReflection* const> reflections)
+{
+    std::vector<std::vector<vk::DescriptorSetLayoutBinding>> setsBindings;
+    std::optional<vk::PushConstantRange> pushConstantRange;
+    for (const ShaderReflection* reflection : reflections)
+    {
+        if (!reflection)
+        {
+            continue;
+        }
+
+        const auto stageFlag = static_cast<vk::ShaderStageFlagBits>(reflection->stage);
+        for (const auto& resource : reflection->resourceBindings)
+        {
+            if (resource.count == 0 || resource.set >= maxDescriptorSetsCount)
+            {
+                ENGINE_LOG(Error, Renderer) << "Unsupported descriptor: set " << resource.set << ", binding " << resource.binding << ", count "
+                                            << resource.count;
+                return nullptr;
+            }
+
+            if (setsBindings.size() <= resource.set)
+            {
+                setsBindings.resize(resource.set + 1);
+            }
+            auto& setBindings = setsBindings[resource.set];
+
+            // the frame uniform set of the graphics stages is fed by VulkanFrameAllocator: its only binding is dynamic
+            // and visible to all the graphics stages, so the layout is compatible with the frame descriptor set.
+            // The other uniform blocks are static and visible to the stages declaring them
+            const bool isFrameUniform = resource.set == VulkanFrameAllocator::frameUniformSet && stageFlag != vk::ShaderStageFlagBits::eCompute;
+            if (isFrameUniform &&
+                (resource.type != ShaderResourceType::UniformBuffer || resource.binding != VulkanFrameAllocator::frameUniformBinding ||
+                 resource.count != 1))
+            {
+                ENGINE_LOG(Error, Renderer) << "Set " << resource.set << " is reserved for the frame uniform block at binding "
+                                            << VulkanFrameAllocator::frameUniformBinding << ", binding " << resource.binding << " can't be there";
+                return nullptr;
+            }
+            const auto descriptorType =
+                    isFrameUniform ? vk::DescriptorType::eUniformBufferDynamic : static_cast<vk::DescriptorType>(resource.type);
+            const auto stageFlags =
+                    isFrameUniform ? vk::ShaderStageFlags{vk::ShaderStageFlagBits::eAllGraphics} : vk::ShaderStageFlags{stageFlag};
+            auto binding = std::find_if(setBindings.begin(), setBindings.end(), [&resource](const auto& setBinding) {
+                return setBinding.binding == resource.binding;
+            });
+            if (binding == setBindings.end())
+            {
+                setBindings.push_back(vk::DescriptorSetLayoutBinding{}
+                        .setBinding(resource.binding)
+                        .setDescriptorType(descriptorType)
+                        .setDescriptorCount(resource.count)
+                        .setStageFlags(stageFlags));
+            }
+            else if (binding->descriptorType != descriptorType || binding->descriptorCount != resource.count)
+            {
+                ENGINE_LOG(Error, Renderer) << "Shader stages declare set " << resource.set << ", binding " << resource.binding
+                                            << " differently: " << vk::to_string(binding->descriptorType) << " and " << vk::to_string(descriptorType);
+                return nullptr;
+            }
+            else
+            {
+                binding->stageFlags |= stageFlags;
+            }
+        }
+
+        if (const auto& pushConstants = reflection->pushConstants)
+        {
+            if (!pushConstantRange)
+            {
+                pushConstantRange = vk::PushConstantRange{}.setOffset(pushConstants->offset).setSize(pushConstants->size).setStageFlags(stageFlag);
+                continue;
+            }
+            // one range visible to every stage using push constants, that's what the stages of a pipeline usually share
+            const uint32_t rangeEnd   = std::max(pushConstantRange->offset + pushConstantRange->size, pushConstants->offset + pushConstants->size);
+            pushConstantRange->offset = std::min(pushConstantRange->offset, pushConstants->offset);
+            pushConstantRange->size   = rangeEnd - pushConstantRange->offset;
+            pushConstantRange->stageFlags |= stageFlag;
+        }
+    }
+
+    std::vector<vk::DescriptorSetLayout> setLayouts;
+    for (auto& setBindings : setsBindings)
+    {
+        std::sort(setBindings.begin(), setBindings.end(), [](const auto& left, const auto& right) { return left.binding < right.binding; });
+        setLayouts.push_back(getDescriptorSetLayout(setBindings));
+        if (!setLayouts.back())
+        {
+            return nullptr;
+        }
+    }
+
+    std::vector<vk::PushConstantRange> pushConstantRanges;
+    if (pushConstantRange)
+    {
+        pushConstantRanges.push_back(*pushConstantRange);
+    }
+
+    const uint64_t hash     = getHash(setLayouts, pushConstantRanges);
+    const auto [begin, end] = mPipelineLayouts.equal_range(hash);
+    for (auto pipelineLayout = begin; pipelineLayout != end; ++pipelineLayout)
+    {
+        if (pipelineLayout->second.setLayouts == setLayouts &&
+            std::equal(
+                    pipelineLayout->second.pushConstantRanges.begin(),
+                    pipelineLayout->second.pushConstantRanges.end(),
+                    pushConstantRanges.begin(),
+                    pushConstantRanges.end(),
+                    [](const auto& left, const auto& right) { return isEqual(left, right); }))
+        {
+            return pipelineLayout->second.layout;
+        }
+    }
+
+    const auto pipelineLayoutCreateInfo = vk::PipelineLayoutCreateInfo{}
+            .setSetLayoutCount(static_cast<uint32_t>(setLayouts.size()))
+            .setPSetLayouts(setLayouts.data())
+            .setPushConstantRangeCount(static_cast<uint32_t>(pushConstantRanges.size()))
+            .setPPushConstantRanges(pushConstantRanges.data());
+    const auto result = mDevice.createPipelineLayout(pipelineLayoutCreateInfo);
+    if (result.result != vk::Result::eSuccess)
+    {
+        ENGINE_LOG(Error, Renderer) << "Failed to create a pipeline layout, result code \"" << vk::to_string(result.result) << "\"";
+        return nullptr;
+    }
+
+    mPipelineLayouts.emplace(hash, PipelineLayout{std::move(setLayouts), std::move(pushConstantRanges), result.value});
+    return result.value;
+}
+
+vk::DescriptorSetLayout VulkanPipelineLayoutCache::getDescriptorSetLayout(std::span<const vk::DescriptorSetLayoutBinding> bindings)
+{
+    const uint64_t hash     = getHash(bindings);
+    const auto [begin, end] = mDescriptorSetLayouts.equal_range(hash);
+    for (auto setLayout = begin; setLayout != end; ++setLayout)
+    {
+        if (std::equal(
+                    setLayout->second.bindings.begin(),
+                    setLayout->second.bindings.end(),
+                    bindings.begin(),
+                    bindings.end(),
+                    [](const auto& left, const auto& right) { return isEqual(left, right); }))
+        {
+            return setLayout->second.layout;
+        }
+    }
+
+    const auto setLayoutCreateInfo =
+            vk::DescriptorSetLayoutCreateInfo{}.setBindingCount(static_cast<uint32_t>(bindings.size())).setPBindings(bindings.data());
+    const auto result = mDevice.createDescriptorSetLayout(setLayoutCreateInfo);
+    if (result.result != vk::Result::eSuccess)
+    {
+        ENGINE_LOG(Error, Renderer) << "Failed to create a descriptor set layout, result code \"" << vk::to_string(result.result) << "\"";
+        return nullptr;
+    }
+
+    mDescriptorSetLayouts.emplace(hash, DescriptorSetLayout{{bindings.begin(), bindings.end()}, result.value});
+    return result.value;
+}
+
+void VulkanPipelineLayoutCache::destroy()
+{
+    for (const auto& [hash, pipelineLayout] : mPipelineLayouts)
+    {
+        mDevice.destroy(pipelineLayout.layout);
+    }
+    mPipelineLayouts.clear();
+
+    for (const auto& [hash, setLayout] : mDescriptorSetLayouts)
+    {
+        mDevice.destroy(setLayout.layout);
+    }
+    mDescriptorSetLayouts.clear();
+}
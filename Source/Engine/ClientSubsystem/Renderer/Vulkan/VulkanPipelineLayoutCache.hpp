@@ -0,0 +1,55 @@
+/*
+ *  VulkanPipelineLayoutCache.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderReflection.hpp>
+#include <vulkan/vulkan.hpp>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace Kompot::Rendering::Vulkan
+{
+/*
+ * Descriptor set and pipeline layouts derived from the reflection of the shader stages.
+ * Equal layouts are looked up by hash and created once, so pipelines of compatible shaders
+ * share a vk::PipelineLayout and can share bound descriptor sets. The cache owns the layouts,
+ * they live until destroy().
+ */
+class VulkanPipelineLayoutCache
+{
+public:
+    void setDevice(vk::Device device);
+
+    // merges the bindings and push constants of the stages, a null layout if they conflict
+    vk::PipelineLayout getPipelineLayout(std::span<const ShaderReflection* const> reflections);
+
+    vk::DescriptorSetLayout getDescriptorSetLayout(std::span<const vk::DescriptorSetLayoutBinding> bindings);
+
+    // the layouts must not be in use anymore
+    void destroy();
+
+private:
+    struct DescriptorSetLayout
+    {
+        std::vector<vk::DescriptorSetLayoutBinding> bindings;
+        vk::DescriptorSetLayout layout;
+    };
+
+    struct PipelineLayout
+    {
+        std::vector<vk::DescriptorSetLayout> setLayouts;
+        std::vector<vk::PushConstantRange> pushConstantRanges;
+        vk::PipelineLayout layout;
+    };
+
+    vk::Device mDevice;
+    std::unordered_multimap<uint64_t, DescriptorSetLayout> mDescriptorSetLayouts; // by hash of the bindings
+    std::unordered_multimap<uint64_t, PipelineLayout> mPipelineLayouts;           // by hash of the set layouts and ranges
+};
+
+} // namespace Kompot::Rendering::Vulkan
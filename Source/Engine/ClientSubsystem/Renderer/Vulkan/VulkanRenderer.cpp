@@ -8,10 +8,14 @@
 
 #include "VulkanRenderer.hpp"
 #include <Engine/ClientSubsystem/Window/Window.hpp>
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderHotReloader.hpp>
 #include <Engine/ClientSubsystem/Renderer/Shaders/ShaderManager.hpp>
 #include <Engine/ErrorHandling.hpp>
 #include <Engine/Log/Log.hpp>
 #include <EngineDefines.hpp>
+#include <algorithm>
+#include <array>
+#include <optional>
 #include <vector>
 #include <cmath>
 
@@ -21,40 +25,78 @@ using namespace Kompot;
 using namespace Kompot::Rendering;
 using namespace Kompot::Rendering::Vulkan;
 
-//const uint64_t VulkanRenderer::VULKAN_BUFFERS_COUNT = 2;
+namespace
+{
+const auto fenceTimeout = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)).count();
+
+// mVkSwapchainFormat is 8 bits BGRA
+constexpr uint32_t offscreenBytesPerPixel = 4;
+} // namespace
 
-Vulkan::VulkanRenderer::VulkanRenderer() : mVkInstance(nullptr)
+Vulkan::VulkanRenderer::VulkanRenderer(const VulkanRendererConfig& config)
+    : mConfig(getSupportedConfig(config)),
+      mVkInstance(nullptr),
+      mIsHeadless(mConfig.offscreenExtent.has_value())
 {
     createInstance();
     setupDebugCallback();
-    mVulkanDevice.reset(new VulkanDevice(mVkInstance, selectPhysicalDevice()));
+    mVulkanDevice.reset(new VulkanDevice(mVkInstance, selectPhysicalDevice(), mIsHeadless));
     mVulkanPipelineBuilder.setDevice(mVulkanDevice->asLogicDevice());
+    mGpuProfiler.setDevice(mVulkanDevice->asPhysicalDevice(), mVulkanDevice->asLogicDevice(), mVulkanDevice->getGraphicsQueueIndex());
 
     setupAllocator();
+    mUploadManager.create(*mVulkanDevice, mAllocator);
+    mFrameAllocator.setDevice(mVulkanDevice->asPhysicalDevice(), mVulkanDevice->asLogicDevice(), mAllocator);
 
+    mVulkanFrames.resize(mConfig.framesInFlightCount);
     createCommands();
     createRenderpass();
     createSyncObjects();
+    mGpuProfiler.createQueryPools(mVulkanFrames);
+    mFrameAllocator.createBuffers(mVulkanFrames);
+
+    if (mIsHeadless)
+    {
+        mOffscreenTarget.scissor.extent = *mConfig.offscreenExtent;
+        createOffscreenTarget();
+        createPipeline(mOffscreenTarget.scissor, mOffscreenTarget.pipeline);
+    }
+    else
+    {
+        // headless runs render the shaders they've started with, so their frames are reproducible
+        mShaderHotReloader = std::make_unique<ShaderHotReloader>();
+        if (!mShaderHotReloader->start("Shaders"))
+        {
+            mShaderHotReloader.reset();
+        }
+    }
 
     mRendererState = RendererState::Initialized;
 };
 
 Rendering::Vulkan::VulkanRenderer::~VulkanRenderer()
 {
-    mVulkanDevice->asLogicDevice().destroy(mVertexShader.get());
-    mVulkanDevice->asLogicDevice().destroy(mFragmentShader.get());
+    mShaderHotReloader.reset();
+    // keeps the reloaded shaders for the next start
+    ShaderManager::get().saveArchive();
 
-    for (auto& frame : mVulkanFrames)
+    if (mIsHeadless)
     {
-        mVulkanDevice->asLogicDevice().destroy(frame.vkRenderFence);
-        mVulkanDevice->asLogicDevice().destroy(frame.vkRenderSemaphore);
-        mVulkanDevice->asLogicDevice().destroy(frame.vkPresentSemaphore);
-
-        mVulkanDevice->asLogicDevice().destroy(frame.vkCommandPool);
-        frame.vkCommandBuffer = nullptr;
+        destroyOffscreenTarget();
     }
+    // the frames in flight read the frame memory and write the queries destroyed below
+    checkVulkanSuccess(mVulkanDevice->asLogicDevice().waitIdle());
+
+    mVulkanDevice->asLogicDevice().destroy(mVertexShader.get());
+    mVulkanDevice->asLogicDevice().destroy(mFragmentShader.get());
+    destroyRetiredResources(true);
+    mVulkanPipelineBuilder.destroyLayouts();
+    destroyFrames();
 
     mVulkanDevice->asLogicDevice().destroy(mVkRenderPass);
+    mUploadManager.destroy();
+    mFrameAllocator.destroy();
+    vmaDestroyAllocator(mAllocator);
     // mVulkanDevice->asLogicDevice().destroy();
     mVulkanDevice.reset();
     deleteDebugCallback();
@@ -65,9 +107,25 @@ void VulkanRenderer::createInstance()
 {
     vk::ApplicationInfo vkApplicationInfo{ENGINE_NAME, 0, ENGINE_NAME, 0, ENGINE_VULKAN_VERSION};
 
-    const auto instanceExtensions       = Utils::getRequiredInstanceExtensions();
-    const auto instanceValidationLayers = Utils::getRequiredInstanceValidationLayers();
-    auto vkInstanceCreateInfo           = vk::InstanceCreateInfo{}
+    const auto instanceExtensions = Utils::getRequiredInstanceExtensions(mIsHeadless);
+    auto instanceValidationLayers = Utils::getRequiredInstanceValidationLayers();
+
+    // build machines usually have a driver only, e.g. lavapipe, the debug builds run there without validation then
+    if (const auto result = vk::enumerateInstanceLayerProperties(); result.result == vk::Result::eSuccess)
+    {
+        std::erase_if(instanceValidationLayers, [&availableLayers = result.value](const char* layerName) {
+            const bool isAvailable = std::any_of(availableLayers.begin(), availableLayers.end(), [layerName](const vk::LayerProperties& layer) {
+                return std::string_view(layer.layerName.data()) == layerName;
+            });
+            if (!isAvailable)
+            {
+                ENGINE_LOG(Warning, Renderer) << layerName << " isn't installed, the instance is created without it";
+            }
+            return !isAvailable;
+        });
+    }
+
+    auto vkInstanceCreateInfo = vk::InstanceCreateInfo{}
             .setPApplicationInfo(&vkApplicationInfo)
             .setPEnabledExtensionNames(instanceExtensions)
             .setPEnabledLayerNames(instanceValidationLayers)
@@ -105,19 +163,26 @@ vk::PhysicalDevice VulkanRenderer::selectPhysicalDevice()
         Kompot::ErrorHandling::exit("\"No one GPU has founded\"");
     }
 
-    uint32_t selectedDeviceIndex = 0;
+    std::optional<uint32_t> selectedDeviceIndex;
     Utils::DeviceComparsionAttributes selectedDeviceAttributes{};
     bool hasDiscreteDeviceWasFound = false;
     for (auto i = 0u; i < physicalDevices.size(); ++i)
     {
-        const auto& physicalDevice   = physicalDevices[i];
+        const auto& physicalDevice = physicalDevices[i];
+        if (!Utils::hasRequiredFeatures(physicalDevice))
+        {
+            ENGINE_LOG(Warning, Renderer) << "GPU \"" << physicalDevice.getProperties().deviceName.data()
+                                          << "\" is skipped, it doesn't support Vulkan 1.2 timeline semaphores";
+            continue;
+        }
+
         const auto& deviceAttributes = Utils::getDeviceComparsionAttributes(physicalDevice, vk::MemoryPropertyFlagBits::eDeviceLocal);
 
         const bool isHaveMoreMemory             = deviceAttributes.memorySize > selectedDeviceAttributes.memorySize;
         const bool isMoreBetterDevice           = (deviceAttributes.isDiscreteDevice == hasDiscreteDeviceWasFound) && isHaveMoreMemory;
         const bool isFirstFoundedDiscreteDevice = deviceAttributes.isDiscreteDevice && !hasDiscreteDeviceWasFound;
 
-        const bool isNeedToSelectThisDevice = isMoreBetterDevice || isFirstFoundedDiscreteDevice;
+        const bool isNeedToSelectThisDevice = !selectedDeviceIndex || isMoreBetterDevice || isFirstFoundedDiscreteDevice;
 
         if (isNeedToSelectThisDevice)
         {
@@ -127,7 +192,11 @@ vk::PhysicalDevice VulkanRenderer::selectPhysicalDevice()
         }
     }
 
-    return physicalDevices[selectedDeviceIndex];
+    if (!selectedDeviceIndex)
+    {
+        Kompot::ErrorHandling::exit("No GPU supports Vulkan 1.2 timeline semaphores");
+    }
+    return physicalDevices[selectedDeviceIndex.value()];
 }
 
 WindowRendererAttributes* VulkanRenderer::updateWindowAttributes(Window* window)
@@ -136,6 +205,11 @@ WindowRendererAttributes* VulkanRenderer::updateWindowAttributes(Window* window)
     {
         return nullptr;
     }
+    if (mIsHeadless)
+    {
+        ENGINE_LOG(Error, Renderer) << "A headless renderer can't present to windows";
+        return nullptr;
+    }
     mWindows.emplace(window);
 
     checkVulkanSuccess(mVulkanDevice->asLogicDevice().waitIdle());
@@ -215,10 +289,19 @@ void VulkanRenderer::recreateWindowHandlers(VulkanWindowRendererAttributes* wind
         windowAttributes->scissor.setExtent(vkSurfaceCapabilities.currentExtent);
     }
 
+    const auto presentMode = selectPresentMode(windowAttributes->surface);
+
+    // mailbox renders on while an image waits for the vertical blank, so it needs an image more than the minimum
+    uint32_t minImageCount = vkSurfaceCapabilities.minImageCount + (presentMode == vk::PresentModeKHR::eMailbox ? 1 : 0);
+    if (vkSurfaceCapabilities.maxImageCount > 0)
+    {
+        minImageCount = std::min(minImageCount, vkSurfaceCapabilities.maxImageCount);
+    }
+
     // VK_SWAPCHAIN_CREATE_SPLIT_INSTANCE_BIND_REGIONS_BIT_KHR  ?
     auto swapchainCreateInfo = vk::SwapchainCreateInfoKHR{}
             .setSurface(windowAttributes->surface)
-            .setMinImageCount(vkSurfaceCapabilities.minImageCount)
+            .setMinImageCount(minImageCount)
             .setImageFormat(mVkSwapchainFormat)
             .setImageColorSpace(vk::ColorSpaceKHR::eSrgbNonlinear)
             //.setImageExtent(windowAttributes->scissor.extent)
@@ -229,7 +312,7 @@ void VulkanRenderer::recreateWindowHandlers(VulkanWindowRendererAttributes* wind
             .setQueueFamilyIndices(queueFamilyIndices)
             .setPreTransform(vkSurfaceCapabilities.currentTransform)
             .setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque)
-            .setPresentMode(vk::PresentModeKHR::eFifo)
+            .setPresentMode(presentMode)
             .setClipped(VK_TRUE);
     windowAttributes->scissor.extent = vkSurfaceCapabilities.currentExtent;
 
@@ -286,7 +369,7 @@ void VulkanRenderer::recreateWindowHandlers(VulkanWindowRendererAttributes* wind
         }
     }
 
-    createPipeline(windowAttributes);
+    createPipeline(windowAttributes->scissor, windowAttributes->pipeline);
 
     windowAttributes->framebufferResized = false;
 }
@@ -310,8 +393,38 @@ VkBool32 VulkanRenderer::vulkanDebugCallbackImpl(
         const vk::DebugUtilsMessengerCallbackDataEXT& callbackData,
         void* userData)
 {
-    Log::getInstance() << Log::DateTimeBlock << "[Validation layer " << vk::to_string(messageType) << vk::to_string(messageSeverite) << "] "
-                       << callbackData.pMessage << std::endl;
+    using SeverityFlagBits = vk::DebugUtilsMessageSeverityFlagBitsEXT;
+
+    LogLevel level = LogLevel::Verbose;
+    if (messageSeverite & SeverityFlagBits::eError)
+    {
+        level = LogLevel::Error;
+    }
+    else if (messageSeverite & SeverityFlagBits::eWarning)
+    {
+        level = LogLevel::Warning;
+    }
+    else if (messageSeverite & SeverityFlagBits::eInfo)
+    {
+        level = LogLevel::Info;
+    }
+
+    // the same message comes every frame until the bug is fixed, so each severity gets a limited call site,
+    // one statement each, the line tells their reports apart
+    static LogCallSite verboseCallSite(LogLevel::Verbose, LogCategory::Renderer, __FILE__, __LINE__, 20);
+    static LogCallSite infoCallSite(LogLevel::Info, LogCategory::Renderer, __FILE__, __LINE__, 20);
+    static LogCallSite warningCallSite(LogLevel::Warning, LogCategory::Renderer, __FILE__, __LINE__, 20);
+    static LogCallSite errorCallSite(LogLevel::Error, LogCategory::Renderer, __FILE__, __LINE__, 20);
+    static LogCallSite* const validationCallSites[] = {&verboseCallSite, &infoCallSite, &warningCallSite, &errorCallSite};
+    LogCallSite& callSite                           = *validationCallSites[static_cast<std::size_t>(level)];
+
+    // the callback is called a lot with verbose messages, skip them before any formatting
+    if (Log::isCompiledIn(level) && Log::getInstance().isEnabled(level, LogCategory::Renderer) &&
+        callSite.tryAcquire(Log::timeNow().time_since_epoch().count()))
+    {
+        Log::getInstance().record(callSite)
+            << "[Validation layer " << vk::to_string(messageType) << vk::to_string(messageSeverite) << "] " << callbackData.pMessage;
+    }
     return VK_SUCCESS;
 }
 
@@ -341,7 +454,7 @@ void VulkanRenderer::setupDebugCallback()
     }
     else
     {
-        Log::getInstance() << "Failed to createDebugUtilsMessengerEXT, result code \"" << vk::to_string(result) << "\"" << std::endl;
+        ENGINE_LOG(Warning, Renderer) << "Failed to createDebugUtilsMessengerEXT, result code \"" << vk::to_string(result) << "\"";
     }
 #endif
 }
@@ -367,11 +480,8 @@ void VulkanRenderer::cleanupWindowHandlers(VulkanWindowRendererAttributes* windo
 
     auto& logicDevice = mVulkanDevice->asLogicDevice();
 
-    if (windowAttributes->pipeline.pipelineLayout)
-    {
-        logicDevice.destroy(windowAttributes->pipeline.pipelineLayout);
-        windowAttributes->pipeline.pipelineLayout = nullptr;
-    }
+    // the layout is shared, it's destroyed along with mVulkanPipelineBuilder
+    windowAttributes->pipeline.pipelineLayout = nullptr;
 
     if (windowAttributes->pipeline.pipeline)
     {
@@ -440,7 +550,7 @@ void VulkanRenderer::createRenderpass()
             .setStencilLoadOp(vk::AttachmentLoadOp::eDontCare)
             .setStencilStoreOp(vk::AttachmentStoreOp::eDontCare)
             .setInitialLayout(vk::ImageLayout::eUndefined)
-            .setFinalLayout(vk::ImageLayout::ePresentSrcKHR);
+            .setFinalLayout(mIsHeadless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR);
 
     const auto attachmentReference = vk::AttachmentReference{}.setAttachment(0).setLayout(vk::ImageLayout::eColorAttachmentOptimal);
 
@@ -449,11 +559,22 @@ void VulkanRenderer::createRenderpass()
             .setColorAttachmentCount(1)
             .setPColorAttachments(&attachmentReference);
 
+    // a headless frame is copied by readbackFrame() in a later submission
+    const auto readbackDependency = vk::SubpassDependency{}
+            .setSrcSubpass(0)
+            .setDstSubpass(VK_SUBPASS_EXTERNAL)
+            .setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput)
+            .setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite)
+            .setDstStageMask(vk::PipelineStageFlagBits::eTransfer)
+            .setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+
     const auto renderpassCreateInfo = vk::RenderPassCreateInfo{}
             .setAttachmentCount(1)
             .setPAttachments(&renderpassAttachmentDescription)
             .setSubpassCount(1)
-            .setPSubpasses(&subpassDescription);
+            .setPSubpasses(&subpassDescription)
+            .setDependencyCount(mIsHeadless ? 1 : 0)
+            .setPDependencies(&readbackDependency);
 
 
     if (const auto result = mVulkanDevice->asLogicDevice().createRenderPass(renderpassCreateInfo); result.result == vk::Result::eSuccess)
@@ -494,6 +615,318 @@ void VulkanRenderer::createSyncObjects()
     }
 }
 
+void VulkanRenderer::destroyFrames()
+{
+    mGpuProfiler.destroyQueryPools(mVulkanFrames);
+    mFrameAllocator.destroyBuffers(mVulkanFrames);
+
+    const auto logicDevice = mVulkanDevice->asLogicDevice();
+    for (auto& frame : mVulkanFrames)
+    {
+        logicDevice.destroy(frame.vkRenderFence);
+        logicDevice.destroy(frame.vkRenderSemaphore);
+        logicDevice.destroy(frame.vkPresentSemaphore);
+
+        logicDevice.destroy(frame.vkCommandPool);
+        frame.vkCommandBuffer = nullptr;
+    }
+    mVulkanFrames.clear();
+
+    mIsCurrentFrameReady = false;
+    mLastOffscreenFrame  = nullptr;
+}
+
+void VulkanRenderer::createOffscreenTarget()
+{
+    const auto& extent = mOffscreenTarget.scissor.extent;
+
+    const VkImageCreateInfo imageCreateInfo = vk::ImageCreateInfo{}
+            .setImageType(vk::ImageType::e2D)
+            .setFormat(mVkSwapchainFormat)
+            .setExtent(vk::Extent3D{extent.width, extent.height, 1})
+            .setMipLevels(1)
+            .setArrayLayers(1)
+            .setSamples(vk::SampleCountFlagBits::e1)
+            .setTiling(vk::ImageTiling::eOptimal)
+            .setUsage(vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc)
+            .setSharingMode(vk::SharingMode::eExclusive)
+            .setInitialLayout(vk::ImageLayout::eUndefined);
+    VmaAllocationCreateInfo imageAllocationCreateInfo{};
+    imageAllocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    auto framebufferCreateInfo = vk::FramebufferCreateInfo{}
+            .setRenderPass(mVkRenderPass)
+            .setHeight(extent.height)
+            .setWidth(extent.width)
+            .setLayers(1)
+            .setAttachmentCount(1);
+
+    const auto& logicalDevice = mVulkanDevice->asLogicDevice();
+    for (auto& frame : mVulkanFrames)
+    {
+        auto& offscreenImage = frame.offscreenImage;
+
+        VkImage image = VK_NULL_HANDLE;
+        if (const auto result = vmaCreateImage(mAllocator, &imageCreateInfo, &imageAllocationCreateInfo, &image, &offscreenImage.allocation, nullptr);
+                result != VK_SUCCESS)
+        {
+            Kompot::ErrorHandling::exit("Failed to create an offscreen image, result code \"" + vk::to_string(vk::Result(result)) + "\"");
+        }
+        offscreenImage.image = image;
+
+        const auto imageViewCreateInfo =
+                vk::ImageViewCreateInfo{}
+                .setImage(offscreenImage.image)
+                .setViewType(vk::ImageViewType::e2D)
+                .setFormat(mVkSwapchainFormat)
+                .setComponents(vk::ComponentMapping{})
+                .setSubresourceRange(
+                    vk::ImageSubresourceRange{}.setAspectMask(vk::ImageAspectFlagBits::eColor).setLevelCount(1).setLayerCount(1));
+        if (const auto result = logicalDevice.createImageView(imageViewCreateInfo); result.result == vk::Result::eSuccess)
+        {
+            offscreenImage.imageView = result.value;
+        }
+        else
+        {
+            Kompot::ErrorHandling::exit("Failed to create an image view for offscreen image, result code \"" + vk::to_string(result.result) + "\"");
+        }
+
+        framebufferCreateInfo.setPAttachments(&offscreenImage.imageView);
+        if (const auto result = logicalDevice.createFramebuffer(framebufferCreateInfo); result.result == vk::Result::eSuccess)
+        {
+            offscreenImage.framebuffer = result.value;
+        }
+        else
+        {
+            Kompot::ErrorHandling::exit("Failed to create a framebuffer for offscreen image, result code \"" + vk::to_string(result.result) + "\"");
+        }
+    }
+
+    const VkBufferCreateInfo bufferCreateInfo = vk::BufferCreateInfo{}
+            .setSize(vk::DeviceSize{extent.width} * extent.height * offscreenBytesPerPixel)
+            .setUsage(vk::BufferUsageFlagBits::eTransferDst)
+            .setSharingMode(vk::SharingMode::eExclusive);
+    VmaAllocationCreateInfo bufferAllocationCreateInfo{};
+    bufferAllocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    bufferAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocationInfo bufferAllocationInfo{};
+    if (const auto result = vmaCreateBuffer(
+                mAllocator, &bufferCreateInfo, &bufferAllocationCreateInfo, &buffer, &mOffscreenTarget.readbackAllocation, &bufferAllocationInfo);
+            result != VK_SUCCESS)
+    {
+        Kompot::ErrorHandling::exit("Failed to create a readback buffer, result code \"" + vk::to_string(vk::Result(result)) + "\"");
+    }
+    mOffscreenTarget.readbackBuffer = buffer;
+    mOffscreenTarget.readbackData   = bufferAllocationInfo.pMappedData;
+}
+
+void VulkanRenderer::destroyOffscreenTarget()
+{
+    auto& logicDevice = mVulkanDevice->asLogicDevice();
+    checkVulkanSuccess(logicDevice.waitIdle());
+
+    // the layout is shared, it's destroyed along with mVulkanPipelineBuilder
+    if (mOffscreenTarget.pipeline.pipeline)
+    {
+        logicDevice.destroy(mOffscreenTarget.pipeline.pipeline);
+    }
+
+    for (auto& frame : mVulkanFrames)
+    {
+        auto& offscreenImage = frame.offscreenImage;
+        logicDevice.destroy(offscreenImage.framebuffer);
+        logicDevice.destroy(offscreenImage.imageView);
+        vmaDestroyImage(mAllocator, static_cast<VkImage>(offscreenImage.image), offscreenImage.allocation);
+        offscreenImage = {};
+    }
+
+    vmaDestroyBuffer(mAllocator, static_cast<VkBuffer>(mOffscreenTarget.readbackBuffer), mOffscreenTarget.readbackAllocation);
+    mOffscreenTarget = {};
+}
+
+VulkanRendererConfig VulkanRenderer::getSupportedConfig(const VulkanRendererConfig& config)
+{
+    VulkanRendererConfig supportedConfig = config;
+
+    supportedConfig.framesInFlightCount = std::clamp(config.framesInFlightCount, 1u, VulkanRendererConfig::maxFramesInFlightCount);
+    if (supportedConfig.framesInFlightCount != config.framesInFlightCount)
+    {
+        ENGINE_LOG(Warning, Renderer) << config.framesInFlightCount << " frames in flight aren't supported, " << supportedConfig.framesInFlightCount
+                                      << " are used";
+    }
+
+    switch (config.presentMode)
+    {
+    case vk::PresentModeKHR::eFifo:
+    case vk::PresentModeKHR::eFifoRelaxed:
+    case vk::PresentModeKHR::eMailbox:
+    case vk::PresentModeKHR::eImmediate:
+        break;
+    default:
+        ENGINE_LOG(Warning, Renderer) << "Present mode " << vk::to_string(config.presentMode) << " isn't supported, Fifo is used";
+        supportedConfig.presentMode = vk::PresentModeKHR::eFifo;
+        break;
+    }
+
+    if (auto& extent = supportedConfig.offscreenExtent; extent && (extent->width == 0 || extent->height == 0))
+    {
+        ENGINE_LOG(Warning, Renderer) << "Empty offscreen extent " << extent->width << "x" << extent->height << ", it's 1 pixel at least";
+        extent->width  = std::max(extent->width, 1u);
+        extent->height = std::max(extent->height, 1u);
+    }
+    return supportedConfig;
+}
+
+void VulkanRenderer::setConfig(const VulkanRendererConfig& config)
+{
+    auto supportedConfig = getSupportedConfig(config);
+    if (supportedConfig.offscreenExtent.has_value() != mIsHeadless)
+    {
+        ENGINE_LOG(Error, Renderer) << "A renderer can't switch between the headless and windowed modes, the offscreen extent is ignored";
+        supportedConfig.offscreenExtent = mConfig.offscreenExtent;
+    }
+
+    const bool isFramesCountChanged     = supportedConfig.framesInFlightCount != mConfig.framesInFlightCount;
+    const bool isOffscreenExtentChanged = supportedConfig.offscreenExtent != mConfig.offscreenExtent;
+    const bool isPresentModeChanged     = supportedConfig.presentMode != mConfig.presentMode;
+    mConfig                             = supportedConfig;
+
+    checkVulkanSuccess(mVulkanDevice->asLogicDevice().waitIdle());
+    destroyRetiredResources(true);
+
+    if (isFramesCountChanged || isOffscreenExtentChanged)
+    {
+        if (mIsHeadless)
+        {
+            destroyOffscreenTarget();
+        }
+        destroyFrames();
+
+        mVulkanFrames.resize(mConfig.framesInFlightCount);
+        createCommands();
+        createSyncObjects();
+        mGpuProfiler.createQueryPools(mVulkanFrames);
+        mFrameAllocator.createBuffers(mVulkanFrames);
+
+        if (mIsHeadless)
+        {
+            mOffscreenTarget.scissor.extent = *mConfig.offscreenExtent;
+            createOffscreenTarget();
+            createPipeline(mOffscreenTarget.scissor, mOffscreenTarget.pipeline);
+        }
+    }
+
+    if (isPresentModeChanged)
+    {
+        // the swapchains are recreated by the next draw()
+        for (Window* window : mWindows)
+        {
+            if (auto windowAttributes = dynamic_cast<VulkanWindowRendererAttributes*>(window->getWindowRendererAttributes()))
+            {
+                windowAttributes->framebufferResized = true;
+            }
+        }
+    }
+}
+
+vk::PresentModeKHR VulkanRenderer::selectPresentMode(vk::SurfaceKHR surface) const
+{
+    std::vector<vk::PresentModeKHR> supportedModes;
+    if (const auto result = mVulkanDevice->asPhysicalDevice().getSurfacePresentModesKHR(surface); result.result == vk::Result::eSuccess)
+    {
+        supportedModes = result.value;
+    }
+
+    // immediate is wanted for the latency, mailbox is the next lowest. Every device supports FIFO
+    const vk::PresentModeKHR candidateModes[] = {
+            mConfig.presentMode,
+            mConfig.presentMode == vk::PresentModeKHR::eImmediate ? vk::PresentModeKHR::eMailbox : vk::PresentModeKHR::eFifo,
+            vk::PresentModeKHR::eFifo};
+    for (const auto presentMode : candidateModes)
+    {
+        if (std::find(supportedModes.begin(), supportedModes.end(), presentMode) == supportedModes.end())
+        {
+            continue;
+        }
+        if (presentMode != mConfig.presentMode)
+        {
+            ENGINE_LOG(Warning, Renderer) << "The surface doesn't support present mode " << vk::to_string(mConfig.presentMode) << ", "
+                                          << vk::to_string(presentMode) << " is used";
+        }
+        return presentMode;
+    }
+    return vk::PresentModeKHR::eFifo;
+}
+
+void VulkanRenderer::waitForNextFrame()
+{
+    if (mConfig.isLowLatency)
+    {
+        waitForCurrentFrame();
+    }
+}
+
+bool VulkanRenderer::waitForCurrentFrame()
+{
+    if (mRendererState == RendererState::DeviceLost)
+    {
+        return false;
+    }
+    if (mIsCurrentFrameReady)
+    {
+        return true;
+    }
+
+    // wait until the GPU has finished rendering the frame that used the slot before
+    if (!waitForFrameFence(getCurrentFrame()))
+    {
+        return false;
+    }
+    mIsCurrentFrameReady = true;
+
+    // the device has finished reading the frame data of the slot
+    mFrameAllocator.beginFrame(getCurrentFrame());
+    return true;
+}
+
+bool VulkanRenderer::waitForFrameFence(VulkanFrameData& frame)
+{
+    // the frame resources can't be reused earlier, so a frame longer than the timeout is reported and waited for further
+    const auto logicDevice = mVulkanDevice->asLogicDevice();
+    vk::Result result;
+    while ((result = logicDevice.waitForFences(1, &frame.vkRenderFence, true, fenceTimeout)) == vk::Result::eTimeout)
+    {
+        ENGINE_LOG_BINARY_LIMITED(Warning, Renderer, 1, "frame {frame}: the GPU takes longer than a second", mFrameNumber);
+    }
+    if (result == vk::Result::eErrorDeviceLost)
+    {
+        mRendererState = RendererState::DeviceLost;
+        return false;
+    }
+    if (result != vk::Result::eSuccess)
+    {
+        ENGINE_LOG(Error, Renderer) << "Failed to wait for the frame fence, result code \"" << vk::to_string(result) << "\"";
+        return false;
+    }
+    return true;
+}
+
+VulkanFrameAllocation VulkanRenderer::allocateFrameData(vk::DeviceSize size)
+{
+    if (mRendererState == RendererState::DeviceLost)
+    {
+        return {};
+    }
+
+    if (!waitForCurrentFrame())
+    {
+        return {};
+    }
+    return mFrameAllocator.allocate(getCurrentFrame(), size);
+}
+
 void VulkanRenderer::draw(Window* window)
 {
     auto windowAttributes = dynamic_cast<VulkanWindowRendererAttributes*>(window ? window->getWindowRendererAttributes() : nullptr);
@@ -518,17 +951,23 @@ void VulkanRenderer::draw(Window* window)
         return;
     }
 
-    auto currentFrame      = getCurrentFrame();
+    auto& currentFrame     = getCurrentFrame();
     const auto logicDevice = mVulkanDevice->asLogicDevice();
 
-    static const auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)).count();
-
-    // wait until the GPU has finished rendering the last frame. Timeout of 1 second
-    checkVulkanSuccess(logicDevice.waitForFences(1, &currentFrame.vkRenderFence, true, timeout));
+    // done by waitForNextFrame() already in the low latency mode
+    if (!waitForCurrentFrame())
+    {
+        return;
+    }
     checkVulkanSuccess(currentFrame.vkCommandBuffer.reset(vk::CommandBufferResetFlagBits{}));
 
+    // nothing is recorded for this frame yet, so the shaders and pipelines can be swapped here
+    destroyRetiredResources(false);
+    reloadShaders();
+
     uint32_t swapchainImageIndex = 0;
-    if (const auto result = logicDevice.acquireNextImageKHR(windowAttributes->swapchain.handler, timeout, currentFrame.vkPresentSemaphore, nullptr);
+    if (const auto result =
+                logicDevice.acquireNextImageKHR(windowAttributes->swapchain.handler, fenceTimeout, currentFrame.vkPresentSemaphore, nullptr);
             result.result == vk::Result::eSuccess)
     {
         swapchainImageIndex = result.value;
@@ -543,39 +982,198 @@ void VulkanRenderer::draw(Window* window)
         Kompot::ErrorHandling::exit("Failed to acquire next framebuffer image");
     }
     checkVulkanSuccess(logicDevice.resetFences(1, &currentFrame.vkRenderFence));
+    mIsCurrentFrameReady = false;
+
+    mUploadManager.flush();
+    recordFrame(
+            currentFrame, windowAttributes->swapchain.framebuffers[swapchainImageIndex], windowAttributes->scissor, windowAttributes->pipeline);
+    if (!submitFrame(currentFrame, true))
+    {
+        return;
+    }
+
+    const auto presentInfo = vk::PresentInfoKHR{}
+            .setWaitSemaphoreCount(1)
+            .setPWaitSemaphores(&currentFrame.vkRenderSemaphore)
+            .setSwapchainCount(1)
+            .setPSwapchains(&windowAttributes->swapchain.handler)
+            .setPImageIndices(&swapchainImageIndex);
+
+    const auto presentResult = windowAttributes->presentQueue.presentKHR(presentInfo);
+    if (presentResult == vk::Result::eErrorOutOfDateKHR)
+    {
+        windowAttributes->framebufferResized = true;
+    }
+    if (presentResult != vk::Result::eSuccess)
+    {
+        // suboptimal or out of date swapchains are reported on every frame until the resize is handled
+        ENGINE_LOG_BINARY_LIMITED(Warning, Renderer, 10, "presentResult = {presentResult}", presentResult);
+    }
+
+    ++mFrameNumber;
+}
+
+void VulkanRenderer::drawOffscreen()
+{
+    if (!mIsHeadless || mRendererState == RendererState::DeviceLost)
+    {
+        return;
+    }
+
+    auto& currentFrame     = getCurrentFrame();
+    const auto logicDevice = mVulkanDevice->asLogicDevice();
+
+    if (!waitForCurrentFrame())
+    {
+        return;
+    }
+    checkVulkanSuccess(logicDevice.resetFences(1, &currentFrame.vkRenderFence));
+    mIsCurrentFrameReady = false;
+    checkVulkanSuccess(currentFrame.vkCommandBuffer.reset(vk::CommandBufferResetFlagBits{}));
+
+    destroyRetiredResources(false);
+
+    mUploadManager.flush();
+    recordFrame(currentFrame, currentFrame.offscreenImage.framebuffer, mOffscreenTarget.scissor, mOffscreenTarget.pipeline);
+    if (!submitFrame(currentFrame, false))
+    {
+        return;
+    }
+    mLastOffscreenFrame = &currentFrame;
+
+    ++mFrameNumber;
+}
+
+VulkanFrameReadback VulkanRenderer::readbackFrame()
+{
+    VulkanFrameReadback readback;
+    if (!mIsHeadless || !mLastOffscreenFrame || mRendererState == RendererState::DeviceLost)
+    {
+        return readback;
+    }
 
-    checkVulkanSuccess(currentFrame.vkCommandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
+    // the command buffer of the last frame is free to record the copy once the frame is finished
+    auto& frame            = *mLastOffscreenFrame;
+    const auto logicDevice = mVulkanDevice->asLogicDevice();
+    const auto& extent     = mOffscreenTarget.scissor.extent;
+
+    if (!waitForFrameFence(frame))
+    {
+        return readback;
+    }
+    checkVulkanSuccess(logicDevice.resetFences(1, &frame.vkRenderFence));
+    checkVulkanSuccess(frame.vkCommandBuffer.reset(vk::CommandBufferResetFlagBits{}));
+    checkVulkanSuccess(frame.vkCommandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
+
+    // the render pass leaves the image in eTransferSrcOptimal and makes its writes visible to transfers
+    const auto copyRegion = vk::BufferImageCopy{}
+            .setImageSubresource(vk::ImageSubresourceLayers{}.setAspectMask(vk::ImageAspectFlagBits::eColor).setLayerCount(1))
+            .setImageExtent(vk::Extent3D{extent.width, extent.height, 1});
+    frame.vkCommandBuffer.copyImageToBuffer(
+            frame.offscreenImage.image, vk::ImageLayout::eTransferSrcOptimal, mOffscreenTarget.readbackBuffer, 1, &copyRegion);
+
+    const auto hostReadBarrier = vk::BufferMemoryBarrier{}
+            .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setDstAccessMask(vk::AccessFlagBits::eHostRead)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setBuffer(mOffscreenTarget.readbackBuffer)
+            .setSize(VK_WHOLE_SIZE);
+    frame.vkCommandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, 0, nullptr, 1, &hostReadBarrier, 0, nullptr);
+
+    checkVulkanSuccess(frame.vkCommandBuffer.end());
+
+    // the pixels are read only once the copy is finished
+    if (!submitFrame(frame, false) || !waitForFrameFence(frame))
+    {
+        return readback;
+    }
+
+    // does nothing if the memory VMA has picked is host coherent
+    vmaInvalidateAllocation(mAllocator, mOffscreenTarget.readbackAllocation, 0, VK_WHOLE_SIZE);
+
+    const auto* pixels = static_cast<const uint8_t*>(mOffscreenTarget.readbackData);
+    readback.width     = extent.width;
+    readback.height    = extent.height;
+    readback.format    = mVkSwapchainFormat;
+    readback.pixels.assign(pixels, pixels + std::size_t{extent.width} * extent.height * offscreenBytesPerPixel);
+    return readback;
+}
+
+void VulkanRenderer::recordFrame(VulkanFrameData& frame, vk::Framebuffer framebuffer, const vk::Rect2D& scissor, const VulkanPipeline& pipeline)
+{
+    checkVulkanSuccess(frame.vkCommandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
 
     const float flash              = std::abs(std::sin(mFrameNumber / 120.f));
     const auto clearValue          = vk::ClearValue{}.setColor(vk::ClearColorValue{}.setFloat32({0.0f, 0.0f, flash, 1.0f}));
     const auto renderPassBeginInfo = vk::RenderPassBeginInfo{}
             .setRenderPass(mVkRenderPass)
-            .setFramebuffer(windowAttributes->swapchain.framebuffers[swapchainImageIndex])
-            //.setRenderArea(vk::Rect2D{}.setExtent(windowAttributes->scissor.extent))
-            .setRenderArea(vk::Rect2D{}.setExtent(windowAttributes->scissor.extent))
+            .setFramebuffer(framebuffer)
+            .setRenderArea(vk::Rect2D{}.setExtent(scissor.extent))
             .setClearValueCount(1)
             .setPClearValues(&clearValue);
 
-    currentFrame.vkCommandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+    // reads the timings of the frame that used the slot before, so it's done outside of the render pass
+    mGpuProfiler.beginFrame(frame, mFrameNumber);
+    mUploadsWaitValue = mUploadManager.recordAcquires(frame.vkCommandBuffer);
+    {
+        VulkanGpuScope frameScope(mGpuProfiler, frame, "Frame");
+        frame.vkCommandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
 
-    currentFrame.vkCommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, windowAttributes->pipeline.pipeline);
-    currentFrame.vkCommandBuffer.draw(3, 1, 0, 0);
+        {
+            VulkanGpuScope drawScope(mGpuProfiler, frame, "Triangle");
+            frame.vkCommandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.pipeline);
+            frame.vkCommandBuffer.draw(3, 1, 0, 0);
+        }
 
-    currentFrame.vkCommandBuffer.endRenderPass();
+        frame.vkCommandBuffer.endRenderPass();
+    }
 
-    checkVulkanSuccess(currentFrame.vkCommandBuffer.end());
+    checkVulkanSuccess(frame.vkCommandBuffer.end());
+    mFrameAllocator.endFrame(frame);
+}
 
-    const auto pipelineStageFlags = vk::PipelineStageFlags{vk::PipelineStageFlagBits::eColorAttachmentOutput};
-    const auto submitInfo         = vk::SubmitInfo{}
-            .setWaitSemaphoreCount(1)
-            .setPWaitSemaphores(&currentFrame.vkPresentSemaphore)
-            .setPWaitDstStageMask(&pipelineStageFlags)
+bool VulkanRenderer::submitFrame(VulkanFrameData& frame, bool isPresented)
+{
+    std::array<vk::Semaphore, 2> waitSemaphores;
+    std::array<vk::PipelineStageFlags, 2> waitStages;
+    std::array<uint64_t, 2> waitValues{}; // ignored for the binary semaphores
+    uint32_t waitSemaphoresCount = 0;
+    if (isPresented)
+    {
+        // waits for the acquired swapchain image
+        waitSemaphores[waitSemaphoresCount] = frame.vkPresentSemaphore;
+        waitStages[waitSemaphoresCount]     = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+        ++waitSemaphoresCount;
+    }
+    if (mUploadsWaitValue != 0)
+    {
+        // signaled already, it orders the ownership acquires after the copies on the transfer queue
+        waitSemaphores[waitSemaphoresCount] = mUploadManager.getTimelineSemaphore();
+        waitStages[waitSemaphoresCount]     = VulkanUploadManager::consumerStages;
+        waitValues[waitSemaphoresCount]     = mUploadsWaitValue;
+        ++waitSemaphoresCount;
+        mUploadsWaitValue = 0;
+    }
+
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}
+            .setWaitSemaphoreValueCount(waitSemaphoresCount)
+            .setPWaitSemaphoreValues(waitValues.data());
+    auto submitInfo = vk::SubmitInfo{}
+            .setPNext(&timelineSubmitInfo)
             .setCommandBufferCount(1)
-            .setPCommandBuffers(&currentFrame.vkCommandBuffer)
-            .setSignalSemaphoreCount(1)
-            .setPSignalSemaphores(&currentFrame.vkRenderSemaphore);
+            .setPCommandBuffers(&frame.vkCommandBuffer)
+            .setWaitSemaphoreCount(waitSemaphoresCount)
+            .setPWaitSemaphores(waitSemaphores.data())
+            .setPWaitDstStageMask(waitStages.data());
+    if (isPresented)
+    {
+        // the present waits for the rendering
+        submitInfo.setSignalSemaphoreCount(1).setPSignalSemaphores(&frame.vkRenderSemaphore);
+    }
 
-    switch (const auto queueSubmitRresult = mVulkanDevice->getGraphicsQueue().submit(1, &submitInfo, currentFrame.vkRenderFence); queueSubmitRresult)
+    switch (const auto queueSubmitRresult = mVulkanDevice->getGraphicsQueue().submit(1, &submitInfo, frame.vkRenderFence); queueSubmitRresult)
     {
     case vk::Result::eErrorOutOfDeviceMemory:
     {
@@ -588,30 +1186,12 @@ void VulkanRenderer::draw(Window* window)
     case vk::Result::eErrorDeviceLost:
     {
         mRendererState = RendererState::DeviceLost;
-        return;
+        return false;
     }
     default:
         break;
     }
-
-    const auto presentInfo = vk::PresentInfoKHR{}
-            .setWaitSemaphoreCount(1)
-            .setPWaitSemaphores(&currentFrame.vkRenderSemaphore)
-            .setSwapchainCount(1)
-            .setPSwapchains(&windowAttributes->swapchain.handler)
-            .setPImageIndices(&swapchainImageIndex);
-
-    const auto presentResult = windowAttributes->presentQueue.presentKHR(presentInfo);
-    if (presentResult == vk::Result::eErrorOutOfDateKHR)
-    {
-        windowAttributes->framebufferResized = true;
-    }
-    if (presentResult != vk::Result::eSuccess)
-    {
-        Log::getInstance() << "presentResult = " << vk::to_string(presentResult) << std::endl;
-    }
-
-    ++mFrameNumber;
+    return true;
 }
 
 void VulkanRenderer::notifyWindowResized(Window* window)
@@ -638,33 +1218,108 @@ void VulkanRenderer::setupAllocator()
     }
 }
 
-void VulkanRenderer::createPipeline(VulkanWindowRendererAttributes* windowAttributes)
+void VulkanRenderer::createPipeline(const vk::Rect2D& scissor, VulkanPipeline& pipeline)
 {
-    if (!windowAttributes)
+    if (!mVertexShader || !mFragmentShader)
     {
-        return;
+        // compiled concurrently if the cache is cold
+        const auto shaderBinaries = ShaderManager::get().loadAll({"Shaders/triangle.vert", "Shaders/triangle.frag"});
+
+        mVertexShader = VulkanShader("Shaders/triangle.vert", mVulkanDevice->asLogicDevice());
+        mVertexShader.setStageFlag(vk::ShaderStageFlagBits::eVertex);
+        check(mVertexShader.load(shaderBinaries[0]));
+
+        mFragmentShader = VulkanShader("Shaders/triangle.frag", mVulkanDevice->asLogicDevice());
+        mFragmentShader.setStageFlag(vk::ShaderStageFlagBits::eFragment);
+        check(mFragmentShader.load(shaderBinaries[1]));
+
+        // the next start finds the shaders compiled now in the archive
+        ShaderManager::get().saveArchive();
     }
 
-    if (!mVertexShader)
+    std::vector<VulkanShader> shaders = {mVertexShader, mFragmentShader};
+    if (const auto result = mVulkanPipelineBuilder.buildGraphicsPipeline(scissor, this, shaders, pipeline); result != vk::Result::eSuccess)
     {
-        const auto vertexShader = ShaderManager::get().load("Shaders/triangle.vert");
-        mVertexShader = VulkanShader("vert", mVulkanDevice->asLogicDevice());
-        mVertexShader.setStageFlag(vk::ShaderStageFlagBits::eVertex);
-        check(mVertexShader.load(vertexShader));
+        Kompot::ErrorHandling::exit("Failed to build graphics pipeline");
     }
+}
 
-    if (!mFragmentShader)
+void VulkanRenderer::reloadShaders()
+{
+    if (!mShaderHotReloader)
     {
-        const auto fragmentShader = ShaderManager::get().load("Shaders/triangle.frag");
-        mFragmentShader = VulkanShader("frag", mVulkanDevice->asLogicDevice());
-        mFragmentShader.setStageFlag(vk::ShaderStageFlagBits::eFragment);
-        check(mFragmentShader.load(fragmentShader));
+        return;
+    }
+
+    bool isPipelineOutdated = false;
+    for (auto& reloadedShader : mShaderHotReloader->takeReloaded())
+    {
+        const auto& variant     = reloadedShader.variant;
+        const auto shaderBinary = ShaderManager::get().update(variant, std::move(reloadedShader.compiled));
+        for (VulkanShader* shader : {&mVertexShader, &mFragmentShader})
+        {
+            if (!*shader || variant.definesKey != 0 || shader->getSourceFilename() != variant.path.generic_string())
+            {
+                continue;
+            }
+
+            // the copy keeps the stage and the specialization, load() replaces the module
+            VulkanShader reloadedModule = *shader;
+            check(reloadedModule.load(shaderBinary));
+
+            mRetiredResources.push_back({mFrameNumber, shader->get(), {}});
+            *shader            = reloadedModule;
+            isPipelineOutdated = true;
+            ENGINE_LOG(Info, Shader) << variant.path << " reloaded";
+        }
+    }
 
+    if (!isPipelineOutdated)
+    {
+        return;
     }
 
     std::vector<VulkanShader> shaders = {mVertexShader, mFragmentShader};
-    if (const auto result = mVulkanPipelineBuilder.buildGraphicsPipeline(windowAttributes, this, shaders); result != vk::Result::eSuccess)
+    for (Window* window : mWindows)
     {
-        Kompot::ErrorHandling::exit("Failed to build graphics pipeline");
+        auto windowAttributes = dynamic_cast<VulkanWindowRendererAttributes*>(window->getWindowRendererAttributes());
+        if (!windowAttributes || !windowAttributes->pipeline.pipeline)
+        {
+            continue;
+        }
+
+        const VulkanPipeline previousPipeline = windowAttributes->pipeline;
+        if (const auto result = mVulkanPipelineBuilder.buildGraphicsPipeline(windowAttributes->scissor, this, shaders, windowAttributes->pipeline);
+                result != vk::Result::eSuccess)
+        {
+            ENGINE_LOG(Error, Renderer) << "Failed to rebuild the graphics pipeline, result code \"" << vk::to_string(result)
+                                        << "\", the previous one stays in use";
+            continue;
+        }
+        mRetiredResources.push_back({mFrameNumber, nullptr, previousPipeline});
     }
 }
+
+void VulkanRenderer::destroyRetiredResources(bool isDeviceIdle)
+{
+    auto& logicDevice = mVulkanDevice->asLogicDevice();
+
+    // the frames recorded before retiredAtFrame have used the resources, the fence of the last of them
+    // is waited for when its frame slot comes round again, mVulkanFrames.size() frames later
+    std::erase_if(mRetiredResources, [&](const VulkanRetiredResources& resources) {
+        if (!isDeviceIdle && mFrameNumber < resources.retiredAtFrame + mVulkanFrames.size())
+        {
+            return false;
+        }
+
+        if (resources.shaderModule)
+        {
+            logicDevice.destroy(resources.shaderModule);
+        }
+        if (resources.pipeline.pipeline)
+        {
+            logicDevice.destroy(resources.pipeline.pipeline);
+        }
+        return true;
+    });
+}
@@ -9,10 +9,21 @@
 #include "../RenderingCommon.hpp"
 #include "VulkanTypes.hpp"
 #include "VulkanDevice.hpp"
+#include "VulkanFrameAllocator.hpp"
+#include "VulkanGpuProfiler.hpp"
+#include "VulkanUploadManager.hpp"
 #include "VulkanPipelineBuilder.hpp"
 #include <Memory/VulkanAllocator/VulkanAllocator.hpp>
 #include <vulkan/vulkan.hpp>
+#include <memory>
+#include <optional>
 #include <set>
+#include <vector>
+
+namespace Kompot::Rendering
+{
+class ShaderHotReloader;
+}
 
 namespace Kompot::Rendering::Vulkan
 {
@@ -24,14 +35,51 @@ enum class RendererState
     DeviceLost
 };
 
+struct VulkanRendererConfig
+{
+    static constexpr uint32_t maxFramesInFlightCount = 4;
+
+    // more frames keep the GPU busier at the cost of latency, clamped to [1, maxFramesInFlightCount]
+    uint32_t framesInFlightCount = 2;
+
+    // eFifo, eFifoRelaxed, eMailbox or eImmediate, the closest one the surface supports is used
+    vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
+
+    // the frame fence is waited for by waitForNextFrame() before the input is sampled, not by draw() after it
+    bool isLowLatency = false;
+
+    // with an extent the renderer is headless: it draws into VMA allocated images of that size by drawOffscreen(),
+    // no surface or swapchain is created, so it runs without a display, e.g. on lavapipe in CI
+    std::optional<vk::Extent2D> offscreenExtent;
+};
+
 class VulkanRenderer : public Kompot::Rendering::IRenderer
 {
 public:
-    VulkanRenderer();
+    explicit VulkanRenderer(const VulkanRendererConfig& config = {});
     ~VulkanRenderer();
 
+    void waitForNextFrame() override;
     void draw(Window* window) override;
 
+    // headless mode only
+    void drawOffscreen();
+    // waits for the last frame drawn by drawOffscreen() and copies it to the host, empty pixels if there is none
+    VulkanFrameReadback readbackFrame();
+
+    bool isHeadless() const
+    {
+        return mIsHeadless;
+    }
+
+    // waits for the device to be idle, so call it on settings changes only. A renderer can't become headless or windowed
+    void setConfig(const VulkanRendererConfig& config);
+
+    const VulkanRendererConfig& getConfig() const
+    {
+        return mConfig;
+    }
+
     void notifyWindowResized(Window* window) override;
     WindowRendererAttributes* updateWindowAttributes(Window* window) override;
     void unregisterWindow(Window* window) override;
@@ -56,6 +104,26 @@ public:
         return mVkRenderPass;
     };
 
+    // the GPU time of the frames drawn framesInFlightCount frames ago and before
+    const VulkanGpuProfiler& getGpuProfiler() const
+    {
+        return mGpuProfiler;
+    }
+
+    // the uploads are submitted and acquired by the next frame drawn
+    VulkanUploadManager& getUploadManager()
+    {
+        return mUploadManager;
+    }
+
+    // shader data of the next frame drawn, valid until its slot is reused. Waits for the slot like waitForNextFrame()
+    VulkanFrameAllocation allocateFrameData(vk::DeviceSize size);
+
+    const VulkanFrameAllocator& getFrameAllocator() const
+    {
+        return mFrameAllocator;
+    }
+
 protected:
     void cleanupWindowHandlers(VulkanWindowRendererAttributes* windowAttributes);
     void recreateWindowHandlers(VulkanWindowRendererAttributes* windowAttributes, vk::SurfaceCapabilitiesKHR vkSurfaceCapabilities);
@@ -74,10 +142,13 @@ private:
             [[maybe_unused]] void* userData);
 
 private:
-    static const uint64_t VULKAN_BUFFERS_COUNT = 2;
+    VulkanRendererConfig mConfig;
     std::size_t mFrameNumber = 0;
+    bool mIsCurrentFrameReady = false; // the fence of the current frame is waited for and not reset yet
 
     VmaAllocator_T* mAllocator = nullptr;
+    VulkanUploadManager mUploadManager;
+    uint64_t mUploadsWaitValue = 0; // the timeline value of mUploadManager the next submitFrame() waits for
 
     vk::Instance mVkInstance;
     std::unique_ptr<VulkanDevice> mVulkanDevice;
@@ -88,13 +159,22 @@ private:
     vk::RenderPass mVkRenderPass;
     std::vector<vk::Framebuffer> mVkFramebuffers;
 
-    std::array<VulkanFrameData, VULKAN_BUFFERS_COUNT> mVulkanFrames;
+    std::vector<VulkanFrameData> mVulkanFrames; // mConfig.framesInFlightCount
+    VulkanGpuProfiler mGpuProfiler;
+    VulkanFrameAllocator mFrameAllocator;
 
     VulkanShader mVertexShader;
     VulkanShader mFragmentShader;
 
+    std::unique_ptr<ShaderHotReloader> mShaderHotReloader;
+    std::vector<VulkanRetiredResources> mRetiredResources;
+
     std::set<Window*> mWindows;
 
+    const bool mIsHeadless;
+    VulkanOffscreenTarget mOffscreenTarget;
+    VulkanFrameData* mLastOffscreenFrame = nullptr; // what readbackFrame() copies
+
     RendererState mRendererState = RendererState::Uninitialized;
 
 #if 1 // ENGINE_DEBUG
@@ -109,13 +189,32 @@ private:
     vk::PhysicalDevice selectPhysicalDevice();
     void createDevice();
     void createCommands();
-    void createPipeline(VulkanWindowRendererAttributes* window);
+    void createPipeline(const vk::Rect2D& scissor, VulkanPipeline& pipeline);
     void createRenderpass();
     void createSyncObjects();
+    void destroyFrames();
+    void createOffscreenTarget();
+    void destroyOffscreenTarget();
+
+    // clamps and replaces what no device supports, the present mode is checked against each surface
+    static VulkanRendererConfig getSupportedConfig(const VulkanRendererConfig& config);
+    vk::PresentModeKHR selectPresentMode(vk::SurfaceKHR surface) const;
+
+    // false if the device is lost or the fence can't be waited for, the slot stays busy then
+    bool waitForCurrentFrame();
+    // waits for the fence past the timeout, false if the device is lost or the wait fails
+    bool waitForFrameFence(VulkanFrameData& frame);
+    void recordFrame(VulkanFrameData& frame, vk::Framebuffer framebuffer, const vk::Rect2D& scissor, const VulkanPipeline& pipeline);
+    // false if the device is lost
+    bool submitFrame(VulkanFrameData& frame, bool isPresented);
+
+    // swaps the shaders recompiled by mShaderHotReloader and the pipelines using them, call between frames
+    void reloadShaders();
+    void destroyRetiredResources(bool isDeviceIdle);
 
     VulkanFrameData& getCurrentFrame()
     {
-        return mVulkanFrames[mFrameNumber % VULKAN_BUFFERS_COUNT];
+        return mVulkanFrames[mFrameNumber % mVulkanFrames.size()];
     }
 
 };
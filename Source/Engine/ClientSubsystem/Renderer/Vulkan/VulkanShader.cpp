@@ -18,10 +18,12 @@ VulkanShader::VulkanShader()
 VulkanShader::VulkanShader(const VulkanShader& otherShader) :
     mFilename(otherShader.mFilename), mShaderModule(otherShader.mShaderModule), mStageFlag(otherShader.mStageFlag)
 {
-    mFilename     = otherShader.mFilename;
-    mDevice       = otherShader.mDevice;
-    mShaderModule = otherShader.mShaderModule;
-    mStageFlag    = otherShader.mStageFlag;
+    mFilename       = otherShader.mFilename;
+    mDevice         = otherShader.mDevice;
+    mShaderModule   = otherShader.mShaderModule;
+    mStageFlag      = otherShader.mStageFlag;
+    mReflection     = otherShader.mReflection;
+    mSpecialization = otherShader.mSpecialization;
 }
 
 VulkanShader::VulkanShader(const std::string_view& filename, vk::Device device) : mFilename(filename), mDevice(device)
@@ -35,14 +37,18 @@ VulkanShader::VulkanShader(VulkanShader&& otherShader)
     otherShader.mFilename     = std::string{};
     otherShader.mDevice       = nullptr;
     otherShader.mShaderModule = nullptr;
+    otherShader.mReflection.reset();
+    otherShader.mSpecialization.reset();
 }
 
 void VulkanShader::operator=(const VulkanShader& otherShader)
 {
-    mFilename     = otherShader.mFilename;
-    mDevice       = otherShader.mDevice;
-    mShaderModule = otherShader.mShaderModule;
-    mStageFlag    = otherShader.mStageFlag;
+    mFilename       = otherShader.mFilename;
+    mDevice         = otherShader.mDevice;
+    mShaderModule   = otherShader.mShaderModule;
+    mStageFlag      = otherShader.mStageFlag;
+    mReflection     = otherShader.mReflection;
+    mSpecialization = otherShader.mSpecialization;
 }
 
 VulkanShader::~VulkanShader()
@@ -57,9 +63,9 @@ VulkanShader::~VulkanShader()
     mShaderModule = nullptr;
 }
 
-bool VulkanShader::load(const std::vector<uint32_t>& shaderBytecode)
+bool VulkanShader::load(std::span<const uint32_t> shaderBytecode)
 {
-    const auto shaderModuleCreateInfo = vk::ShaderModuleCreateInfo{}.setCodeSize(shaderBytecode.size() * 4).setPCode(shaderBytecode.data());
+    const auto shaderModuleCreateInfo = vk::ShaderModuleCreateInfo{}.setCodeSize(shaderBytecode.size_bytes()).setPCode(shaderBytecode.data());
 
     if (const auto result = mDevice.createShaderModule(shaderModuleCreateInfo); result.result == vk::Result::eSuccess)
     {
@@ -70,5 +76,41 @@ bool VulkanShader::load(const std::vector<uint32_t>& shaderBytecode)
         Kompot::ErrorHandling::exit("Failed to create Shader from file \"" + mFilename + "\", result code \"" + vk::to_string(result.result) + "\"");
     }
 
+    if (auto reflection = ShaderReflection::reflect(shaderBytecode))
+    {
+        mReflection = std::make_shared<const ShaderReflection>(std::move(*reflection));
+    }
+    else
+    {
+        mReflection.reset();
+        ENGINE_LOG(Warning, Shader) << "Failed to reflect \"" << mFilename << "\", pipeline layouts won't include its resources";
+    }
+
     return mShaderModule;
 }
+
+void VulkanShader::setSpecialization(std::span<const ShaderSpecializationValue> values)
+{
+    if (values.empty())
+    {
+        mSpecialization.reset();
+        return;
+    }
+
+    // the copies keep pointing to the previous values, the info stays valid while they live
+    auto specialization = std::make_shared<Specialization>();
+    for (const auto& value : values)
+    {
+        specialization->entries.push_back(vk::SpecializationMapEntry{}
+                .setConstantID(value.id)
+                .setOffset(static_cast<uint32_t>(specialization->data.size() * sizeof(uint32_t)))
+                .setSize(sizeof(uint32_t)));
+        specialization->data.push_back(value.value);
+    }
+    specialization->info = vk::SpecializationInfo{}
+            .setMapEntryCount(static_cast<uint32_t>(specialization->entries.size()))
+            .setPMapEntries(specialization->entries.data())
+            .setDataSize(specialization->data.size() * sizeof(uint32_t))
+            .setPData(specialization->data.data());
+    mSpecialization = std::move(specialization);
+}
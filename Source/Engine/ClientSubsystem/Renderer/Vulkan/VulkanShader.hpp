@@ -7,7 +7,12 @@
 #pragma once
 #include "VulkanDevice.hpp"
 #include <Engine/ClientSubsystem/Renderer/RenderingCommon.hpp>
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderPermutations.hpp>
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderReflection.hpp>
 #include <vulkan/vulkan.hpp>
+#include <memory>
+#include <span>
+#include <vector>
 
 namespace Kompot::Rendering::Vulkan
 {
@@ -21,7 +26,7 @@ public:
     void operator=(const VulkanShader& otherShader);
     ~VulkanShader();
 
-    bool load(const std::vector<uint32_t>& shaderBytecode);
+    bool load(std::span<const uint32_t> shaderBytecode);
 
     operator bool() const
     {
@@ -48,11 +53,35 @@ public:
         mStageFlag = inFlag;
     }
 
+    // made by load(), nullptr if the code couldn't be reflected
+    const ShaderReflection* getReflection() const
+    {
+        return mReflection.get();
+    }
+
+    // the specialization constants the pipelines are built with, e.g. of a ShaderPermutations::Variant
+    void setSpecialization(std::span<const ShaderSpecializationValue> values);
+
+    // nullptr without specialization constants
+    const vk::SpecializationInfo* getSpecializationInfo() const
+    {
+        return mSpecialization ? &mSpecialization->info : nullptr;
+    }
+
 private:
+    struct Specialization
+    {
+        std::vector<vk::SpecializationMapEntry> entries;
+        std::vector<uint32_t> data;
+        vk::SpecializationInfo info; // points into entries and data
+    };
+
     std::string mFilename;
     vk::Device mDevice;
     vk::ShaderModule mShaderModule;
     vk::ShaderStageFlagBits mStageFlag;
+    std::shared_ptr<const ShaderReflection> mReflection; // shared by the copies
+    std::shared_ptr<const Specialization> mSpecialization;
 };
 
 } // namespace Kompot
@@ -6,8 +6,12 @@
 
 #pragma once
 
+#include <Engine/ClientSubsystem/Renderer/GpuTimings.hpp>
 #include <Engine/ClientSubsystem/Renderer/RenderingCommon.hpp>
+#include <Memory/VulkanAllocator/VulkanAllocator.hpp>
 #include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace Kompot::Rendering::Vulkan
@@ -24,7 +28,7 @@ struct VulkanSwapchain
 
 struct VulkanPipeline
 {
-    vk::PipelineLayout  pipelineLayout;
+    vk::PipelineLayout  pipelineLayout; // owned by VulkanPipelineBuilder
     vk::Pipeline        pipeline;
 };
 
@@ -40,13 +44,74 @@ struct VulkanWindowRendererAttributes : public WindowRendererAttributes
     bool            isPendingDestroy   = false;
 };
 
+// the color attachment of a headless frame, allocated by VMA instead of a swapchain
+struct VulkanOffscreenImage
+{
+    vk::Image       image;
+    VmaAllocation   allocation = nullptr;
+    vk::ImageView   imageView;
+    vk::Framebuffer framebuffer;
+};
+
+// what a headless renderer draws into instead of a window
+struct VulkanOffscreenTarget
+{
+    vk::Rect2D     scissor;
+    VulkanPipeline pipeline;
+
+    // host visible, the last frame is copied here by VulkanRenderer::readbackFrame()
+    vk::Buffer     readbackBuffer;
+    VmaAllocation  readbackAllocation = nullptr;
+    const void*    readbackData       = nullptr;
+};
+
+// tightly packed rows of 4 bytes pixels, top to bottom
+struct VulkanFrameReadback
+{
+    uint32_t             width  = 0;
+    uint32_t             height = 0;
+    vk::Format           format = vk::Format::eUndefined;
+    std::vector<uint8_t> pixels;
+};
+
+// the timestamp queries of a frame, read back by VulkanGpuProfiler when the slot is reused
+struct VulkanFrameTimestamps
+{
+    vk::QueryPool                  queryPool;
+    std::size_t                    frameNumber  = 0;
+    uint32_t                       queriesCount = 0;
+    std::vector<GpuTimestampScope> scopes;
+    std::vector<uint32_t>          openScopes; // indices in scopes
+};
+
+// the memory VulkanFrameAllocator sub-allocates for a frame, persistently mapped
+struct VulkanFrameMemory
+{
+    vk::Buffer        buffer;
+    VmaAllocation     allocation = nullptr;
+    std::byte*        data       = nullptr;
+    vk::DeviceSize    usedSize   = 0;
+    vk::DescriptorSet descriptorSet; // the buffer as a dynamic uniform buffer at binding 0
+};
+
 struct VulkanFrameData
 {
-    vk::CommandPool   vkCommandPool;
-    vk::CommandBuffer vkCommandBuffer;
-    vk::Semaphore     vkPresentSemaphore;
-    vk::Semaphore     vkRenderSemaphore;
-    vk::Fence         vkRenderFence;
+    vk::CommandPool       vkCommandPool;
+    vk::CommandBuffer     vkCommandBuffer;
+    vk::Semaphore         vkPresentSemaphore;
+    vk::Semaphore         vkRenderSemaphore;
+    vk::Fence             vkRenderFence;
+    VulkanOffscreenImage  offscreenImage; // headless mode only
+    VulkanFrameTimestamps timestamps;
+    VulkanFrameMemory     frameMemory;
+};
+
+// replaced while the frames in flight may still use them, destroyed once their fences are passed
+struct VulkanRetiredResources
+{
+    std::size_t       retiredAtFrame = 0;
+    vk::ShaderModule  shaderModule;
+    VulkanPipeline    pipeline;
 };
 
 } // namespace Kompot
@@ -0,0 +1,392 @@
+/*
+ *  VulkanUploadManager.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "VulkanUploadManager.hpp"
+#include <Engine/ErrorHandling.hpp>
+#include <Engine/Log/Log.hpp>
+#include <EngineDefines.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace Kompot;
+using namespace Kompot::Rendering;
+using namespace Kompot::Rendering::Vulkan;
+
+namespace
+{
+// what the consumerStages may read the uploaded resources as
+constexpr vk::AccessFlags consumerAccess = vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead |
+                                           vk::AccessFlagBits::eUniformRead | vk::AccessFlagBits::eShaderRead;
+
+const auto colorSubresourceRange = vk::ImageSubresourceRange{}.setAspectMask(vk::ImageAspectFlagBits::eColor).setLevelCount(1).setLayerCount(1);
+} // namespace
+
+void VulkanUploadManager::create(const VulkanDevice& device, VmaAllocator_T* allocator, vk::DeviceSize stagingSize)
+{
+    mDevice             = device.asLogicDevice();
+    mAllocator          = allocator;
+    mTransferQueue      = device.getTransferQueue();
+    mTransferQueueIndex = device.getTransferQueueIndex();
+    mGraphicsQueueIndex = device.getGraphicsQueueIndex();
+
+    // the copy offsets of images must be multiples of the texel size, 16 covers all the uncompressed and block compressed formats
+    mStagingAlignment = std::max<vk::DeviceSize>(16, device.asPhysicalDevice().getProperties().limits.optimalBufferCopyOffsetAlignment);
+
+    const VkBufferCreateInfo bufferCreateInfo = vk::BufferCreateInfo{}
+            .setSize(stagingSize)
+            .setUsage(vk::BufferUsageFlagBits::eTransferSrc)
+            .setSharingMode(vk::SharingMode::eExclusive);
+    VmaAllocationCreateInfo bufferAllocationCreateInfo{};
+    bufferAllocationCreateInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    bufferAllocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocationInfo bufferAllocationInfo{};
+    if (const auto result =
+                vmaCreateBuffer(mAllocator, &bufferCreateInfo, &bufferAllocationCreateInfo, &buffer, &mStagingAllocation, &bufferAllocationInfo);
+            result != VK_SUCCESS)
+    {
+        Kompot::ErrorHandling::exit("Failed to create a staging buffer, result code \"" + vk::to_string(vk::Result(result)) + "\"");
+    }
+    mStagingBuffer = buffer;
+    mStagingData   = static_cast<std::byte*>(bufferAllocationInfo.pMappedData);
+    mStagingRing.reset(stagingSize);
+
+    const auto semaphoreTypeCreateInfo = vk::SemaphoreTypeCreateInfo{}.setSemaphoreType(vk::SemaphoreType::eTimeline).setInitialValue(0);
+    if (const auto result = mDevice.createSemaphore(vk::SemaphoreCreateInfo{}.setPNext(&semaphoreTypeCreateInfo));
+            result.result == vk::Result::eSuccess)
+    {
+        mTimelineSemaphore = result.value;
+    }
+    else
+    {
+        Kompot::ErrorHandling::exit("Failed to create a timeline semaphore, result code \"" + vk::to_string(result.result) + "\"");
+    }
+
+    // the pools are reset as a whole, a batch is recorded once per reset
+    const auto commandPoolCreateInfo = vk::CommandPoolCreateInfo{}
+            .setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+            .setQueueFamilyIndex(mTransferQueueIndex);
+    for (auto& batch : mBatches)
+    {
+        if (const auto result = mDevice.createCommandPool(commandPoolCreateInfo); result.result == vk::Result::eSuccess)
+        {
+            batch.commandPool = result.value;
+        }
+        else
+        {
+            Kompot::ErrorHandling::exit("Failed to create a CommandPool, result code \"" + vk::to_string(result.result) + "\"");
+        }
+
+        const auto commandBufferAllocateInfo =
+                vk::CommandBufferAllocateInfo{}.setCommandPool(batch.commandPool).setCommandBufferCount(1).setLevel(vk::CommandBufferLevel::ePrimary);
+        if (const auto result = mDevice.allocateCommandBuffers(commandBufferAllocateInfo);
+                result.result == vk::Result::eSuccess && result.value.size() == 1)
+        {
+            batch.commandBuffer = result.value[0];
+        }
+        else
+        {
+            Kompot::ErrorHandling::exit("Failed to create a CommandBuffer, result code \"" + vk::to_string(result.result) + "\"");
+        }
+    }
+}
+
+void VulkanUploadManager::destroy()
+{
+    if (!mDevice)
+    {
+        return;
+    }
+
+    // the recorded copies are dropped, nobody waits for them anymore
+    if (mIsRecording)
+    {
+        checkVulkanSuccess(mBatches[mBatchIndex].commandBuffer.end());
+        mIsRecording = false;
+    }
+    waitForValue(mSubmittedValue);
+
+    for (auto& batch : mBatches)
+    {
+        mDevice.destroy(batch.commandPool);
+        batch = Batch{};
+    }
+    mDevice.destroy(mTimelineSemaphore);
+    vmaDestroyBuffer(mAllocator, static_cast<VkBuffer>(mStagingBuffer), mStagingAllocation);
+
+    *this = VulkanUploadManager{};
+}
+
+VulkanUploadTicket VulkanUploadManager::uploadBuffer(vk::Buffer buffer, vk::DeviceSize offset, std::span<const std::byte> data)
+{
+    if (!buffer || data.empty())
+    {
+        return 0;
+    }
+
+    vk::DeviceSize stagingOffset = 0;
+    std::byte* stagingData       = allocateStaging(data.size(), stagingOffset);
+    if (!stagingData)
+    {
+        return 0;
+    }
+    std::memcpy(stagingData, data.data(), data.size());
+
+    auto& batch           = getRecordingBatch();
+    const auto copyRegion = vk::BufferCopy{}.setSrcOffset(stagingOffset).setDstOffset(offset).setSize(data.size());
+    batch.commandBuffer.copyBuffer(mStagingBuffer, buffer, 1, &copyRegion);
+
+    if (isOwnershipTransferred())
+    {
+        mRecordingAcquires.bufferBarriers.push_back(vk::BufferMemoryBarrier{}
+                .setDstAccessMask(consumerAccess)
+                .setSrcQueueFamilyIndex(mTransferQueueIndex)
+                .setDstQueueFamilyIndex(mGraphicsQueueIndex)
+                .setBuffer(buffer)
+                .setOffset(offset)
+                .setSize(data.size()));
+    }
+    return mSubmittedValue + 1;
+}
+
+VulkanUploadTicket
+VulkanUploadManager::uploadImage(vk::Image image, const vk::Extent3D& extent, std::span<const std::byte> data, vk::ImageLayout layout)
+{
+    if (!image || data.empty())
+    {
+        return 0;
+    }
+
+    vk::DeviceSize stagingOffset = 0;
+    std::byte* stagingData       = allocateStaging(data.size(), stagingOffset);
+    if (!stagingData)
+    {
+        return 0;
+    }
+    std::memcpy(stagingData, data.data(), data.size());
+
+    auto& batch = getRecordingBatch();
+
+    const auto transferDstBarrier = vk::ImageMemoryBarrier{}
+            .setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+            .setOldLayout(vk::ImageLayout::eUndefined)
+            .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+            .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+            .setImage(image)
+            .setSubresourceRange(colorSubresourceRange);
+    batch.commandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, 0, nullptr, 0, nullptr, 1, &transferDstBarrier);
+
+    const auto copyRegion = vk::BufferImageCopy{}
+            .setBufferOffset(stagingOffset)
+            .setImageSubresource(vk::ImageSubresourceLayers{}.setAspectMask(vk::ImageAspectFlagBits::eColor).setLayerCount(1))
+            .setImageExtent(extent);
+    batch.commandBuffer.copyBufferToImage(mStagingBuffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &copyRegion);
+
+    // the layout transition is the same in the release and the acquire, it's done once between them
+    mRecordingAcquires.imageBarriers.push_back(vk::ImageMemoryBarrier{}
+            .setDstAccessMask(consumerAccess)
+            .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+            .setNewLayout(layout)
+            .setSrcQueueFamilyIndex(isOwnershipTransferred() ? mTransferQueueIndex : VK_QUEUE_FAMILY_IGNORED)
+            .setDstQueueFamilyIndex(isOwnershipTransferred() ? mGraphicsQueueIndex : VK_QUEUE_FAMILY_IGNORED)
+            .setImage(image)
+            .setSubresourceRange(colorSubresourceRange));
+    return mSubmittedValue + 1;
+}
+
+void VulkanUploadManager::flush()
+{
+    if (!mIsRecording)
+    {
+        return;
+    }
+
+    auto& batch = mBatches[mBatchIndex];
+
+    // the releases are the acquires without the destination access, images change their layouts here if the family is the same
+    std::vector<vk::BufferMemoryBarrier> bufferReleases = mRecordingAcquires.bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> imageReleases   = mRecordingAcquires.imageBarriers;
+    for (auto& barrier : bufferReleases)
+    {
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setDstAccessMask({});
+    }
+    for (auto& barrier : imageReleases)
+    {
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setDstAccessMask({});
+    }
+    if (!bufferReleases.empty() || !imageReleases.empty())
+    {
+        batch.commandBuffer.pipelineBarrier(
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eBottomOfPipe,
+                {},
+                0,
+                nullptr,
+                static_cast<uint32_t>(bufferReleases.size()),
+                bufferReleases.data(),
+                static_cast<uint32_t>(imageReleases.size()),
+                imageReleases.data());
+    }
+    checkVulkanSuccess(batch.commandBuffer.end());
+
+    // does nothing if the memory VMA has picked is host coherent
+    vmaFlushAllocation(mAllocator, mStagingAllocation, 0, VK_WHOLE_SIZE);
+
+    batch.timelineValue = mSubmittedValue + 1;
+    batch.stagingEnd    = mStagingRing.getMarker();
+
+    const auto timelineSubmitInfo = vk::TimelineSemaphoreSubmitInfo{}.setSignalSemaphoreValueCount(1).setPSignalSemaphoreValues(&batch.timelineValue);
+    const auto submitInfo         = vk::SubmitInfo{}
+            .setPNext(&timelineSubmitInfo)
+            .setCommandBufferCount(1)
+            .setPCommandBuffers(&batch.commandBuffer)
+            .setSignalSemaphoreCount(1)
+            .setPSignalSemaphores(&mTimelineSemaphore);
+    if (const auto result = mTransferQueue.submit(1, &submitInfo, nullptr); result != vk::Result::eSuccess)
+    {
+        Kompot::ErrorHandling::exit("vkQueueSubmit of the uploads failed with a result code \"" + vk::to_string(result) + "\"");
+    }
+    mSubmittedValue = batch.timelineValue;
+    mBatchesInFlight.push_back(&batch);
+
+    // without an ownership transfer the graphics queue only has to wait for the semaphore
+    mRecordingAcquires.timelineValue = batch.timelineValue;
+    if (!isOwnershipTransferred())
+    {
+        mRecordingAcquires.imageBarriers.clear();
+    }
+    mPendingAcquires.push_back(std::move(mRecordingAcquires));
+    mRecordingAcquires = Acquires{};
+
+    mBatchIndex  = (mBatchIndex + 1) % mBatches.size();
+    mIsRecording = false;
+}
+
+uint64_t VulkanUploadManager::recordAcquires(vk::CommandBuffer commandBuffer)
+{
+    releaseFinishedBatches();
+
+    const uint64_t completedValue = getCompletedValue();
+    std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+    std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    uint64_t waitValue = 0;
+    while (!mPendingAcquires.empty() && mPendingAcquires.front().timelineValue <= completedValue)
+    {
+        auto& acquires = mPendingAcquires.front();
+        bufferBarriers.insert(bufferBarriers.end(), acquires.bufferBarriers.begin(), acquires.bufferBarriers.end());
+        imageBarriers.insert(imageBarriers.end(), acquires.imageBarriers.begin(), acquires.imageBarriers.end());
+        waitValue = acquires.timelineValue;
+        mPendingAcquires.pop_front();
+    }
+
+    if (!bufferBarriers.empty() || !imageBarriers.empty())
+    {
+        // the source stages chain with the semaphore wait of the submission
+        commandBuffer.pipelineBarrier(
+                consumerStages,
+                consumerStages,
+                {},
+                0,
+                nullptr,
+                static_cast<uint32_t>(bufferBarriers.size()),
+                bufferBarriers.data(),
+                static_cast<uint32_t>(imageBarriers.size()),
+                imageBarriers.data());
+    }
+
+    if (waitValue != 0)
+    {
+        mAcquiredValue = waitValue;
+    }
+    return waitValue;
+}
+
+VulkanUploadManager::Batch& VulkanUploadManager::getRecordingBatch()
+{
+    auto& batch = mBatches[mBatchIndex];
+    if (mIsRecording)
+    {
+        return batch;
+    }
+
+    // the batches are reused in turn, so it's the oldest one in flight if any
+    if (batch.timelineValue > getCompletedValue())
+    {
+        ENGINE_LOG_BINARY_LIMITED(Warning, Renderer, 1, "all {count} upload batches are in flight, waits for the transfer queue", batchesCount);
+        waitForValue(batch.timelineValue);
+    }
+    releaseFinishedBatches();
+
+    checkVulkanSuccess(mDevice.resetCommandPool(batch.commandPool, {}));
+    checkVulkanSuccess(batch.commandBuffer.begin(vk::CommandBufferBeginInfo{}.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
+    mIsRecording = true;
+    return batch;
+}
+
+std::byte* VulkanUploadManager::allocateStaging(std::size_t size, vk::DeviceSize& offset)
+{
+    releaseFinishedBatches();
+
+    auto stagingOffset = mStagingRing.allocate(size, mStagingAlignment);
+    while (!stagingOffset)
+    {
+        if (!mBatchesInFlight.empty())
+        {
+            ENGINE_LOG_BINARY_LIMITED(Warning, Renderer, 1, "the staging buffer is full, {size} bytes wait for the transfer queue", size);
+            waitForValue(mBatchesInFlight.front()->timelineValue);
+            releaseFinishedBatches();
+        }
+        else if (mIsRecording)
+        {
+            // the recorded copies hold the rest of the staging memory
+            flush();
+        }
+        else
+        {
+            ENGINE_LOG_BINARY_LIMITED(
+                    Error, Renderer, 1, "{size} bytes don't fit the staging buffer of {capacity} bytes", size, mStagingRing.getCapacity());
+            return nullptr;
+        }
+        stagingOffset = mStagingRing.allocate(size, mStagingAlignment);
+    }
+
+    offset = *stagingOffset;
+    return mStagingData + *stagingOffset;
+}
+
+uint64_t VulkanUploadManager::getCompletedValue() const
+{
+    if (const auto result = mDevice.getSemaphoreCounterValue(mTimelineSemaphore); result.result == vk::Result::eSuccess)
+    {
+        return result.value;
+    }
+    return 0;
+}
+
+void VulkanUploadManager::waitForValue(uint64_t value) const
+{
+    const auto semaphoreWaitInfo = vk::SemaphoreWaitInfo{}.setSemaphoreCount(1).setPSemaphores(&mTimelineSemaphore).setPValues(&value);
+    checkVulkanSuccess(mDevice.waitSemaphores(semaphoreWaitInfo, std::numeric_limits<uint64_t>::max()));
+}
+
+void VulkanUploadManager::releaseFinishedBatches()
+{
+    if (mBatchesInFlight.empty())
+    {
+        return;
+    }
+
+    const uint64_t completedValue = getCompletedValue();
+    while (!mBatchesInFlight.empty() && mBatchesInFlight.front()->timelineValue <= completedValue)
+    {
+        mStagingRing.release(mBatchesInFlight.front()->stagingEnd);
+        mBatchesInFlight.pop_front();
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ *  VulkanUploadManager.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "VulkanDevice.hpp"
+#include <Engine/ClientSubsystem/Renderer/RingAllocator.hpp>
+#include <Memory/VulkanAllocator/VulkanAllocator.hpp>
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace Kompot::Rendering::Vulkan
+{
+// the timeline value signaled when the upload is copied, 0 if the upload has failed
+using VulkanUploadTicket = uint64_t;
+
+/*
+ * Copies buffers and images to the device local memory on the transfer queue, so they don't stall the graphics one.
+ * The data is written to a persistently mapped staging ring buffer right away, the copies are batched
+ * into a command buffer submitted by flush(). A timeline semaphore tracks the batches: the staging memory
+ * of a batch is reused once the semaphore reaches its value.
+ *
+ * If the transfer family differs from the graphics one, the resources must be created with exclusive sharing,
+ * their ownership is released after the copy and acquired by recordAcquires() once the batch is finished.
+ */
+class VulkanUploadManager
+{
+public:
+    static constexpr vk::DeviceSize defaultStagingSize = 32 * 1024 * 1024;
+    static constexpr std::size_t batchesCount          = 4;
+
+    // the stages of the graphics queue that read the uploaded resources
+    static constexpr vk::PipelineStageFlags consumerStages =
+            vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader;
+
+    void create(const VulkanDevice& device, VmaAllocator_T* allocator, vk::DeviceSize stagingSize = defaultStagingSize);
+    // waits for the batches in flight
+    void destroy();
+
+    VulkanUploadTicket uploadBuffer(vk::Buffer buffer, vk::DeviceSize offset, std::span<const std::byte> data);
+
+    // the whole first mip level of a color image in eUndefined layout, the data is tightly packed texels
+    VulkanUploadTicket uploadImage(
+            vk::Image image,
+            const vk::Extent3D& extent,
+            std::span<const std::byte> data,
+            vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    // submits the recorded copies to the transfer queue, does nothing if there are none
+    void flush();
+
+    /*
+     * Records the ownership acquires of the finished batches to a graphics command buffer, outside of a render pass.
+     * The submission must wait for the returned value of getTimelineSemaphore() at consumerStages, it's signaled already,
+     * so the wait costs nothing. 0 if nothing has finished since the last call.
+     */
+    uint64_t recordAcquires(vk::CommandBuffer commandBuffer);
+
+    // the resource can be used by the commands recorded after recordAcquires()
+    bool isUploaded(VulkanUploadTicket ticket) const
+    {
+        return ticket != 0 && ticket <= mAcquiredValue;
+    }
+
+    vk::Semaphore getTimelineSemaphore() const
+    {
+        return mTimelineSemaphore;
+    }
+
+private:
+    struct Batch
+    {
+        vk::CommandPool commandPool;
+        vk::CommandBuffer commandBuffer;
+        uint64_t timelineValue = 0; // signaled when the batch is finished
+        RingAllocator::Marker stagingEnd;
+    };
+
+    // the ownership acquires of a submitted batch, recorded to a graphics command buffer once it's finished
+    struct Acquires
+    {
+        uint64_t timelineValue = 0;
+        std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+        std::vector<vk::ImageMemoryBarrier> imageBarriers;
+    };
+
+    // the batch the copies are recorded to, begun if needed
+    Batch& getRecordingBatch();
+    // waits for the batches in flight if the staging ring is full, nullptr if the data can't fit at all
+    std::byte* allocateStaging(std::size_t size, vk::DeviceSize& offset);
+
+    uint64_t getCompletedValue() const;
+    void waitForValue(uint64_t value) const;
+    // frees the staging memory of the finished batches
+    void releaseFinishedBatches();
+
+    bool isOwnershipTransferred() const
+    {
+        return mTransferQueueIndex != mGraphicsQueueIndex;
+    }
+
+    vk::Device mDevice;
+    VmaAllocator_T* mAllocator = nullptr;
+
+    vk::Queue mTransferQueue;
+    uint32_t mTransferQueueIndex = 0;
+    uint32_t mGraphicsQueueIndex = 0;
+
+    vk::Buffer mStagingBuffer;
+    VmaAllocation mStagingAllocation = nullptr;
+    std::byte* mStagingData          = nullptr;
+    vk::DeviceSize mStagingAlignment = 16;
+    RingAllocator mStagingRing;
+
+    vk::Semaphore mTimelineSemaphore;
+    uint64_t mSubmittedValue = 0;
+    uint64_t mAcquiredValue  = 0;
+
+    std::array<Batch, batchesCount> mBatches;
+    std::size_t mBatchIndex = 0;
+    bool mIsRecording       = false;
+
+    std::deque<Batch*> mBatchesInFlight; // the oldest first
+    Acquires mRecordingAcquires;
+    std::deque<Acquires> mPendingAcquires; // the oldest first
+};
+
+} // namespace Kompot::Rendering::Vulkan
@@ -41,8 +41,25 @@ Utils::DeviceComparsionAttributes Utils::getDeviceComparsionAttributes(
     return deviceComparsionAttributes;
 }
 
-std::vector<const char*> Utils::getRequiredDeviceExtensions()
+bool Utils::hasRequiredFeatures(const vk::PhysicalDevice& vkPhysicalDevice)
 {
+    if (vkPhysicalDevice.getProperties().apiVersion < VK_API_VERSION_1_2)
+    {
+        return false;
+    }
+
+    vk::PhysicalDeviceVulkan12Features vulkan12Features;
+    auto physicalDeviceFeatures = vk::PhysicalDeviceFeatures2{}.setPNext(&vulkan12Features);
+    vkPhysicalDevice.getFeatures2(&physicalDeviceFeatures);
+    return vulkan12Features.timelineSemaphore == VK_TRUE;
+}
+
+std::vector<const char*> Utils::getRequiredDeviceExtensions(bool isHeadless)
+{
+    if (isHeadless)
+    {
+        return {};
+    }
     return {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 }
 
@@ -73,19 +90,24 @@ Utils::QueueFamilies Utils::selectQueuesFamilies(const vk::PhysicalDevice& vkPhy
             result.graphicsCount = queueFamily.queueCount;
         }
 
-        if (isHaveComputeFlag && (!result.computeIndex.has_value() || result.graphicsIndex.value() != i))
+        // the first family without graphics wins, the graphics one is used only if there is none
+        if (isHaveComputeFlag && (!result.computeIndex.has_value() || result.computeIndex == result.graphicsIndex))
         {
             result.computeIndex = static_cast<uint32_t>(i);
             result.computeCount = queueFamily.queueCount;
         }
 
-        if (isHaveTransferFlag && !result.transferIndex.has_value())
+        // a family without graphics and compute is a DMA engine, it copies while the graphics queue renders
+        const bool isDedicatedTransfer = isHaveTransferFlag && !isHaveGraphicsFlag && !isHaveComputeFlag;
+        if (isHaveTransferFlag && (!result.transferIndex.has_value() || (isDedicatedTransfer && !result.isTransferDedicated)))
         {
-            result.transferIndex = static_cast<uint32_t>(i);
-            result.transferCount = queueFamily.queueCount;
+            result.transferIndex       = static_cast<uint32_t>(i);
+            result.transferCount       = queueFamily.queueCount;
+            result.isTransferDedicated = isDedicatedTransfer;
         }
 
-        if (result.hasAllIndicies())
+        // nothing better can be found further
+        if (result.hasAllIndicies() && result.computeIndex != result.graphicsIndex && result.isTransferDedicated)
         {
             break;
         }
@@ -93,8 +115,17 @@ Utils::QueueFamilies Utils::selectQueuesFamilies(const vk::PhysicalDevice& vkPhy
     return result;
 }
 
-std::vector<const char*> Utils::getRequiredInstanceExtensions()
+std::vector<const char*> Utils::getRequiredInstanceExtensions(bool isHeadless)
 {
+    if (isHeadless)
+    {
+#ifdef ENGINE_DEBUG
+        return {VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_EXT_DEBUG_REPORT_EXTENSION_NAME};
+#else
+        return {};
+#endif
+    }
+
     return
     {
         VK_KHR_SURFACE_EXTENSION_NAME,
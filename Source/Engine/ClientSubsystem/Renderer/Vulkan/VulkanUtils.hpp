@@ -13,8 +13,8 @@
 
 namespace Kompot::Rendering::Vulkan::Utils
 {
-// instance
-std::vector<const char*> getRequiredInstanceExtensions();
+// instance, a headless renderer needs neither surfaces nor swapchains
+std::vector<const char*> getRequiredInstanceExtensions(bool isHeadless);
 std::vector<const char*> getRequiredInstanceValidationLayers();
 
 // physical device selection
@@ -24,9 +24,11 @@ struct DeviceComparsionAttributes
     bool isDiscreteDevice;
 };
 DeviceComparsionAttributes getDeviceComparsionAttributes(const vk::PhysicalDevice& vkPhysicalDevice, const vk::MemoryPropertyFlagBits memoryFlags);
+// Vulkan 1.2 with timeline semaphores, VulkanDevice enables them unconditionally
+bool hasRequiredFeatures(const vk::PhysicalDevice& vkPhysicalDevice);
 
 // logical device selection
-std::vector<const char*> getRequiredDeviceExtensions();
+std::vector<const char*> getRequiredDeviceExtensions(bool isHeadless);
 std::vector<const char*> getRequiredDeviceValidationLayers();
 
 struct QueueFamilies
@@ -39,6 +41,7 @@ struct QueueFamilies
 
     std::optional<std::uint32_t> transferIndex;
     std::uint32_t transferCount;
+    bool isTransferDedicated = false;
 
     bool hasAllIndicies() const;
 
@@ -129,6 +129,11 @@ void Window::run()
     {
         if (iGetOk == -1)
             return;
+        if (mRenderer)
+        {
+            // the low latency mode waits for the GPU here, so the input is handled as late as possible before the frame is recorded
+            mRenderer->waitForNextFrame();
+        }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
@@ -141,11 +146,11 @@ vk::SurfaceKHR Window::createVulkanSurface() const
     {
         check(!mRenderer) if (mRenderer)
         {
-            Log::getInstance() << "Trying to create VkSurface with non-Vulkan renderer (" << mRenderer->getName() << ')' << std::endl;
+            ENGINE_LOG(Error, Window) << "Trying to create VkSurface with non-Vulkan renderer (" << mRenderer->getName() << ')';
         }
         else
         {
-            Log::getInstance() << "Trying to create VkSurface with not setted renderer" << std::endl;
+            ENGINE_LOG(Error, Window) << "Trying to create VkSurface with not setted renderer";
         }
         return nullptr;
     }
@@ -324,6 +329,12 @@ void Kompot::Window::run()
     XEvent xlibEvent;
     while (!mNeedToClose)
     {
+        if (mRenderer)
+        {
+            // the low latency mode waits for the GPU here, so the events polled next are fresh when the frame is recorded
+            mRenderer->waitForNextFrame();
+        }
+
         if (XPending(mWindowHandlers->xlibDisplay))
         {
             XNextEvent(mWindowHandlers->xlibDisplay, &xlibEvent);
@@ -355,11 +366,11 @@ vk::SurfaceKHR Kompot::Window::createVulkanSurface() const
         check(!mRenderer);
         if (mRenderer)
         {
-            Log::getInstance() << "Trying to create VkSurface with non-Vulkan renderer (" << mRenderer->getName() << ')' << std::endl;
+            ENGINE_LOG(Error, Window) << "Trying to create VkSurface with non-Vulkan renderer (" << mRenderer->getName() << ')';
         }
         else
         {
-            Log::getInstance() << "Trying to create VkSurface with not setted renderer" << std::endl;
+            ENGINE_LOG(Error, Window) << "Trying to create VkSurface with not setted renderer";
         }
         return nullptr;
     }
@@ -137,6 +137,12 @@ void Window::run()
     xcb_generic_event_t* xcbEvent = xcb_wait_for_event(mWindowHandlers->xcbConnection);
     while (!mNeedToClose)
     {
+        if (mRenderer)
+        {
+            // the low latency mode waits for the GPU here, so the events polled next are fresh when the frame is recorded
+            mRenderer->waitForNextFrame();
+        }
+
         xcbEvent = xcb_poll_for_event(mWindowHandlers->xcbConnection);
         if (xcbEvent)
         {
@@ -263,11 +269,11 @@ vk::SurfaceKHR Window::createVulkanSurface() const
         check(!mRenderer);
         if (mRenderer)
         {
-            Log::getInstance() << "Trying to create VkSurface with non-Vulkan renderer (" << mRenderer->getName() << ')' << std::endl;
+            ENGINE_LOG(Error, Window) << "Trying to create VkSurface with non-Vulkan renderer (" << mRenderer->getName() << ')';
         }
         else
         {
-            Log::getInstance() << "Trying to create VkSurface with not setted renderer" << std::endl;
+            ENGINE_LOG(Error, Window) << "Trying to create VkSurface with not setted renderer";
         }
         return nullptr;
     }
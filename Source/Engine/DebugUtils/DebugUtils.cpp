@@ -6,6 +6,7 @@
 
 #include "DebugUtils.hpp"
 #include <Engine/Log/Log.hpp>
+#include <Engine/Log/LogSignalSafeFile.hpp>
 #include <Misc/StringUtils/StringUtils.hpp>
 #include <limits>
 
@@ -112,14 +113,14 @@ std::string DebugUtils::getCallstack()
     const int32_t stackEntriesCount = backtrace(stack, STACK_MAX_SIZE);
     if (stackEntriesCount < 1)
     {
-        Log::getInstance() << getLastPlatformError() << std::endl;
+        ENGINE_LOG(Error, General) << getLastPlatformError();
         return {};
     }
 
     char** stackRawText = backtrace_symbols(stack, stackEntriesCount);
     if (stackRawText == nullptr)
     {
-        Log::getInstance() << getLastPlatformError() << std::endl;
+        ENGINE_LOG(Error, General) << getLastPlatformError();
         return {};
     }
 
@@ -139,3 +140,30 @@ std::string DebugUtils::getCallstack()
     return result;
 #endif
 }
+
+int DebugUtils::captureCallstack(void** frames, int maxFramesCount)
+{
+#if defined(ENGINE_OS_WINDOWS)
+    return ::CaptureStackBackTrace(0, static_cast<DWORD>(maxFramesCount), frames, nullptr);
+#elif defined(ENGINE_OS_LINUX)
+    return backtrace(frames, maxFramesCount);
+#else
+    return 0;
+#endif
+}
+
+void DebugUtils::writeCallstack(void* const* frames, int framesCount, int descriptor)
+{
+#if defined(ENGINE_OS_LINUX)
+    backtrace_symbols_fd(frames, framesCount, descriptor);
+#else
+    char lineData[32];
+    for (int i = 0; i < framesCount; ++i)
+    {
+        LogFixedBuffer line(lineData, sizeof(lineData));
+        line.appendHex(reinterpret_cast<uint64_t>(frames[i]));
+        line.append('\n');
+        LogSignalSafeFile::write(descriptor, line.view());
+    }
+#endif
+}
@@ -13,6 +13,14 @@ std::string getLastPlatformError();
 
 std::string getCallstack();
 
+/*
+ * Async-signal-safe versions for the crash handler, captureCallstack() must have been called once outside of it,
+ * the first unwinding loads its library. writeCallstack() puts one line per frame to the descriptor,
+ * symbolized if the platform can do it without allocating, raw addresses otherwise.
+ */
+int captureCallstack(void** frames, int maxFramesCount);
+void writeCallstack(void* const* frames, int framesCount, int descriptor);
+
 template<typename T>
 void PrintCallstack(T& outputStream)
 {
@@ -6,6 +6,12 @@
 
 #include "ErrorHandling.hpp"
 #include <Engine/Log/Log.hpp>
+#include <atomic>
+#include <csignal>
+
+#if defined(ENGINE_OS_UNIX)
+    #include <signal.h>
+#endif
 
 #if __GNUC__ > 10
 void Kompot::ErrorHandling::exit(std::string_view exitMessage, const std::source_location& location, std::string_view stack)
@@ -13,11 +19,96 @@ void Kompot::ErrorHandling::exit(std::string_view exitMessage, const std::source
 void Kompot::ErrorHandling::exit(std::string_view exitMessage, std::string_view stack)
 #endif
 {
-    Log::getInstance() << Log::DateTimeBlock << ' '
+    ENGINE_LOG(Fatal, General)
 #if __GNUC__ > 10
-                       << location.file_name() << ':' << location.line() << ':' << location.column() << ' '
+        << location.file_name() << ':' << location.line() << ':' << location.column() << ' '
 #endif
-                       << exitMessage << "\nStack:\n"
-                       << stack << std::endl;
+        << exitMessage << "\nStack:\n"
+        << stack;
+
+    // std::exit doesn't wait for the asynchronous writer, the other threads may still be logging
+    Log::getInstance().flush();
     std::exit(1);
 }
+
+namespace
+{
+constexpr int maxCallstackDepth = 256;
+
+std::string_view getSignalDescription(int signalNumber)
+{
+    switch (signalNumber)
+    {
+    case SIGSEGV:
+        return " Crashed with SIGSEGV (invalid memory access)\n";
+    case SIGABRT:
+        return " Crashed with SIGABRT (abort)\n";
+    case SIGILL:
+        return " Crashed with SIGILL (illegal instruction, check() or breakPoint() failed)\n";
+    case SIGFPE:
+        return " Crashed with SIGFPE (arithmetic error)\n";
+#if defined(ENGINE_OS_UNIX)
+    case SIGTRAP:
+        return " Crashed with SIGTRAP (trap)\n";
+    case SIGBUS:
+        return " Crashed with SIGBUS (bus error)\n";
+#endif
+    default:
+        return " Crashed with an unknown signal\n";
+    }
+}
+
+void crashHandler(int signalNumber)
+{
+    static std::atomic_flag isHandling = ATOMIC_FLAG_INIT;
+    if (!isHandling.test_and_set())
+    {
+        Log& log = Log::getInstance();
+        log.flushSignalSafe();
+        log.writeSignalSafe(LogLevel::Fatal, LogCategory::General, getSignalDescription(signalNumber));
+
+        // static, the alternate signal stack is small
+        static void* frames[maxCallstackDepth];
+        const int framesCount = DebugUtils::captureCallstack(frames, maxCallstackDepth);
+        log.writeSignalSafe(LogLevel::Fatal, LogCategory::General, " Stack:\n");
+        log.writeCallstackSignalSafe(frames, framesCount);
+    }
+
+    // the default action ends the process and makes a core dump if enabled
+    std::signal(signalNumber, SIG_DFL);
+    std::raise(signalNumber);
+}
+
+} // namespace
+
+void Kompot::ErrorHandling::installCrashHandler()
+{
+    // the first call of backtrace loads its library, which mustn't happen inside the handler
+    void* frames[1];
+    DebugUtils::captureCallstack(frames, 1);
+
+#if defined(ENGINE_OS_UNIX)
+    // stack overflows end up in SIGSEGV, the handler needs a stack of its own
+    static char alternateStack[64 * 1024];
+    stack_t signalStack{};
+    signalStack.ss_sp   = alternateStack;
+    signalStack.ss_size = sizeof(alternateStack);
+    sigaltstack(&signalStack, nullptr);
+
+    struct sigaction action
+    {
+    };
+    action.sa_handler = &crashHandler;
+    action.sa_flags   = SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (const int signalNumber : {SIGSEGV, SIGABRT, SIGTRAP, SIGILL, SIGBUS, SIGFPE})
+    {
+        sigaction(signalNumber, &action, nullptr);
+    }
+#else
+    for (const int signalNumber : {SIGSEGV, SIGABRT, SIGILL, SIGFPE})
+    {
+        std::signal(signalNumber, &crashHandler);
+    }
+#endif
+}
@@ -23,4 +23,7 @@ void exit(
 void exit(std::string_view exitMessage, std::string_view stack = DebugUtils::getCallstack());
 #endif
 
+// on SIGSEGV, SIGABRT, SIGTRAP, SIGILL, SIGBUS and SIGFPE puts out the buffered log and the callstack, then lets the process die
+void installCrashHandler();
+
 } // namespace Kompot::ErrorHandling
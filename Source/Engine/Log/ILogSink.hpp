@@ -0,0 +1,54 @@
+/*
+ *  ILogSink.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "LogFormatStream.hpp"
+#include "LogTypes.hpp"
+#include <Misc/DateTimeFormatter.hpp>
+#include <string_view>
+
+/*
+ * Destination of the log records. Sinks are called either under the Log lock (synchronous mode)
+ * or from the writer thread only (asynchronous mode), so they don't need own synchronization.
+ */
+class ILogSink
+{
+public:
+    virtual ~ILogSink(){};
+
+    virtual void write(const LogRecordHeader& header, std::string_view message) = 0;
+    virtual void flush()                                                       = 0;
+
+    virtual void setDateTimeFormat(const Kompot::DateTimeFormat&)
+    {
+    }
+
+    /*
+     * Used by the crash handler only, the process dies right after. Both must be async-signal-safe:
+     * no allocations, no locks, no streams. flushSignalSafe() puts out what is batched,
+     * writeSignalSafe() puts out a line already formatted by LogTextFormatter::formatSignalSafe.
+     */
+    virtual void flushSignalSafe()
+    {
+    }
+    virtual void writeSignalSafe(std::string_view)
+    {
+    }
+
+    // the frames of DebugUtils::captureCallstack, the sinks writing through a file descriptor symbolize them
+    virtual void writeCallstackSignalSafe(void* const* frames, int framesCount)
+    {
+        char lineData[32];
+        for (int i = 0; i < framesCount; ++i)
+        {
+            LogFixedBuffer line(lineData, sizeof(lineData));
+            line.appendHex(reinterpret_cast<uint64_t>(frames[i]));
+            line.append('\n');
+            writeSignalSafe(line.view());
+        }
+    }
+};
@@ -5,36 +5,368 @@
  */
 
 #include "Log.hpp"
+#include "LogBinarySink.hpp"
+#include "LogJsonSink.hpp"
+#include "LogMappedFileSink.hpp"
+#include "LogTextFormatter.hpp"
+#include "LogTextSink.hpp"
 #include <string>
 
 const Log::DateTimeBlock_t Log::DateTimeBlock{};
 
-Log::Log()
+Log::Log() : m_writer(m_sinks, m_mutex)
 {
     using namespace Kompot;
-    m_logFile.open("log.txt");
+    createSinks(false, false);
+    setLevel(m_config.minimumLevel);
+
     *this << DateTimeBlock << " Log initialized" << std::endl;
 }
 
+Log::~Log()
+{
+    m_writer.stop();
+    {
+        std::lock_guard<std::mutex> scopeLock(m_mutex);
+        writeCallSiteReports(true);
+    }
+    m_sinks.clear();
+    m_logFile.close();
+    m_logSignalSafeFile.close();
+}
+
+void Log::configure(const LogConfig& config)
+{
+    // must be called before other threads start logging
+    m_mode.store(LogMode::Synchronous, std::memory_order_release);
+    m_writer.stop();
+
+    // reopening the same files would rotate or truncate the lines written so far
+    const bool keepFileSink = config.outputFormat == m_config.outputFormat && config.logFileSize == m_config.logFileSize &&
+                              config.logFilesCount == m_config.logFilesCount;
+    const bool keepJsonSink = config.writeJsonLines && m_config.writeJsonLines;
+
+    m_config = config;
+    setLevel(m_config.minimumLevel);
+    {
+        std::lock_guard<std::mutex> scopeLock(m_mutex);
+        createSinks(keepFileSink, keepJsonSink);
+    }
+
+    if (m_config.mode == LogMode::Asynchronous)
+    {
+        m_writer.start(m_config);
+        m_mode.store(LogMode::Asynchronous, std::memory_order_release);
+    }
+}
+
+void Log::flush()
+{
+    if (m_mode.load(std::memory_order_acquire) == LogMode::Asynchronous)
+    {
+        m_writer.flush();
+    }
+
+    // the counts of a storm which has just ended, otherwise they wait for a second or for the next line
+    std::lock_guard<std::mutex> scopeLock(m_mutex);
+    writeCallSiteReports(true);
+}
+
+void Log::writeCallSiteReports(bool force)
+{
+    if (LogCallSite::hasPendingReports())
+    {
+        m_writer.writeCallSiteReports(force);
+        for (auto& sink : m_sinks)
+        {
+            sink->flush();
+        }
+    }
+}
+
+void Log::flushSignalSafe()
+{
+    for (auto& sink : m_sinks)
+    {
+        sink->flushSignalSafe();
+    }
+    m_writer.drainSignalSafe();
+}
+
+void Log::writeSignalSafe(LogLevel level, LogCategory category, std::string_view message)
+{
+    LogRecordHeader header;
+    header.flags    = LogRecordLeveled;
+    header.size     = static_cast<uint32_t>(message.size());
+    header.level    = level;
+    header.category = category;
+
+    // static, the alternate signal stack is small
+    static char lineData[64 * 1024];
+    LogFixedBuffer line(lineData, sizeof(lineData));
+    LogTextFormatter::formatSignalSafe(line, header, message);
+
+    for (auto& sink : m_sinks)
+    {
+        sink->writeSignalSafe(line.view());
+    }
+}
+
+void Log::writeCallstackSignalSafe(void* const* frames, int framesCount)
+{
+    for (auto& sink : m_sinks)
+    {
+        sink->writeCallstackSignalSafe(frames, framesCount);
+    }
+}
+
+void Log::setLevel(LogCategory category, LogLevel minimumLevel)
+{
+    uint64_t categoryMask = 0;
+    for (auto level = static_cast<uint32_t>(minimumLevel); level < static_cast<uint32_t>(LogLevel::Count); ++level)
+    {
+        categoryMask |= 1ull << getMaskBit(static_cast<LogLevel>(level), category);
+    }
+
+    const uint64_t allCategoryBits = ((1ull << static_cast<uint32_t>(LogLevel::Count)) - 1) << getMaskBit(LogLevel::Verbose, category);
+
+    uint64_t mask = m_enabledMask.load(std::memory_order_relaxed);
+    while (!m_enabledMask.compare_exchange_weak(mask, (mask & ~allCategoryBits) | categoryMask, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Log::setLevel(LogLevel minimumLevel)
+{
+    for (auto category = 0u; category < static_cast<uint32_t>(LogCategory::Count); ++category)
+    {
+        setLevel(static_cast<LogCategory>(category), minimumLevel);
+    }
+}
+
+void Log::createSinks(bool keepFileSink, bool keepJsonSink)
+{
+    // the file sink is always the first one, the JSON sink goes right after it
+    std::unique_ptr<ILogSink> fileSink;
+    if (keepFileSink && !m_sinks.empty())
+    {
+        fileSink = std::move(m_sinks.front());
+    }
+    std::unique_ptr<ILogSink> jsonSink;
+    if (keepJsonSink && m_sinks.size() > 1)
+    {
+        jsonSink = std::move(m_sinks[1]);
+    }
+    m_sinks.clear();
+
+    if (!fileSink && m_config.outputFormat == LogOutputFormat::MappedText)
+    {
+        std::unique_ptr<LogMappedFileSink> mappedFileSink(new LogMappedFileSink("log.txt", m_config.logFileSize, m_config.logFilesCount));
+        if (mappedFileSink->isOpen())
+        {
+            fileSink = std::move(mappedFileSink);
+        }
+    }
+    if (!fileSink && m_config.outputFormat == LogOutputFormat::Binary)
+    {
+        fileSink.reset(new LogBinarySink("log.bin"));
+    }
+    if (!fileSink) // Text, or mapping of the file failed
+    {
+        if (!m_logFile.is_open())
+        {
+            m_logFile.open("log.txt");
+            m_logSignalSafeFile.open("log.txt");
+        }
+        fileSink.reset(new LogTextSink(m_logFile, m_logSignalSafeFile.getDescriptor()));
+    }
+
+    m_sinks.push_back(std::move(fileSink));
+    if (!jsonSink && m_config.writeJsonLines)
+    {
+        jsonSink.reset(new LogJsonSink("log.jsonl"));
+    }
+    if (jsonSink)
+    {
+        m_sinks.push_back(std::move(jsonSink));
+    }
+#if defined(ENGINE_DEBUG)
+    constexpr int standardOutputDescriptor = 1;
+    m_sinks.emplace_back(new LogTextSink(std::cout, standardOutputDescriptor));
+#endif
+
+    std::lock_guard<std::mutex> dateTimeLock(m_dateTimeMutex);
+    for (auto& sink : m_sinks)
+    {
+        sink->setDateTimeFormat(m_dateTimeFormatter.getFormat());
+    }
+}
+
+LogFormatStream& Log::getThreadStream()
+{
+    static thread_local LogFormatStream threadStream;
+    return threadStream;
+}
+
+LogFormatStream& Log::getThreadRecordStream()
+{
+    static thread_local LogFormatStream threadRecordStream;
+    return threadRecordStream;
+}
+
+LogFormatStream& Log::getThreadReportStream()
+{
+    static thread_local LogFormatStream threadReportStream;
+    return threadReportStream;
+}
+
+LogRecordHeader& Log::getThreadStreamHeader()
+{
+    static thread_local LogRecordHeader threadStreamHeader;
+    return threadStreamHeader;
+}
+
+std::vector<char>& Log::getThreadBinaryBuffer()
+{
+    static thread_local std::vector<char> threadBinaryBuffer;
+    return threadBinaryBuffer;
+}
+
+uint16_t Log::getThreadIndex()
+{
+    static std::atomic<uint16_t> threadsCount = 0;
+    static thread_local const uint16_t threadIndex = threadsCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    return threadIndex;
+}
+
+void Log::commit(LogRecordHeader header, std::string_view message)
+{
+    header.size        = static_cast<uint32_t>(message.size());
+    header.threadIndex = getThreadIndex();
+
+    if (m_mode.load(std::memory_order_acquire) == LogMode::Asynchronous)
+    {
+        m_writer.write(header, message);
+        return;
+    }
+
+    std::lock_guard<std::mutex> scopeLock(m_mutex);
+    for (auto& sink : m_sinks)
+    {
+        sink->write(header, message);
+        sink->flush();
+    }
+
+    // nothing wakes up periodically in this mode, so the counts of finished storms go out with the next line
+    writeCallSiteReports(false);
+}
+
+bool Log::isNewCallSiteMessage(LogCallSite& callSite, int64_t timestamp, uint64_t messageHash)
+{
+    const bool isNewMessage = callSite.isNewMessage(messageHash, timestamp);
+
+    // a different message ends the run of repeats, so their count goes right before it
+    LogFormatStream& report = getThreadReportStream();
+    if (callSite.takeReport(timestamp, isNewMessage && callSite.hasRepeats(), report))
+    {
+        LogRecordHeader header;
+        header.flags     = LogRecordTimestamped | LogRecordLeveled;
+        header.timestamp = timestamp;
+        header.level     = callSite.getLevel();
+        header.category  = callSite.getCategory();
+        commit(header, report.view());
+        report.clear();
+    }
+    return isNewMessage;
+}
+
+void Log::commitThreadStream()
+{
+    LogFormatStream& stream = getThreadStream();
+    LogRecordHeader& header = getThreadStreamHeader();
+
+    commit(header, stream.view());
+
+    stream.clear();
+    header = LogRecordHeader{};
+}
+
+Log& Log::operator<<(OstreamManipulator manipulator)
+{
+    manipulator(getThreadStream());
+
+    using StandardManipulator = std::ostream& (*)(std::ostream&);
+    if (manipulator == static_cast<StandardManipulator>(std::endl) || manipulator == static_cast<StandardManipulator>(std::flush))
+    {
+        commitThreadStream();
+    }
+    return *this;
+}
+
 Log& Log::operator<<(const Kompot::DateTimeFormat& dateTimeFormat)
 {
-    m_dateTimeFormatter.setFormat(dateTimeFormat);
+    {
+        std::lock_guard<std::mutex> dateTimeLock(m_dateTimeMutex);
+        m_dateTimeFormatter.setFormat(dateTimeFormat);
+    }
+
+    // a rare configuration call, may wait for the writer thread
+    std::lock_guard<std::mutex> scopeLock(m_mutex);
+    for (auto& sink : m_sinks)
+    {
+        sink->setDateTimeFormat(dateTimeFormat);
+    }
     return *this;
 }
 
 Log& Log::operator<<(const std::chrono::system_clock::time_point& time)
 {
-    m_dateTimeFormatter.printTime(*this, time);
+    std::lock_guard<std::mutex> dateTimeLock(m_dateTimeMutex);
+    m_dateTimeFormatter.printTime(getThreadStream(), time);
     return *this;
 }
 
 Log& Log::write(const char* text, std::streamsize size)
 {
-    m_logFile.write(text, size);
+    getThreadStream().write(text, size);
     return *this;
 }
-Log& Log::operator<<(const Log::DateTimeBlock_t& value)
+
+Log& Log::operator<<(const Log::DateTimeBlock_t&)
 {
-    *this << '[' << Log::timeNow() << ']';
+    // the timestamp is taken now, but formatted by the sinks in front of the line
+    LogRecordHeader& header = getThreadStreamHeader();
+    header.flags |= LogRecordTimestamped;
+    header.timestamp = timeNow().time_since_epoch().count();
     return *this;
 }
+
+Log::Record::Record(Log& log) : m_log(log), m_stream(Log::getThreadRecordStream()), m_streamOffset(m_stream.size())
+{
+    m_header.flags     = LogRecordTimestamped;
+    m_header.timestamp = Log::timeNow().time_since_epoch().count();
+    m_stream << ' ';
+}
+
+Log::Record::Record(Log& log, LogLevel level, LogCategory category) : Record(log)
+{
+    m_header.flags |= LogRecordLeveled;
+    m_header.level    = level;
+    m_header.category = category;
+}
+
+Log::Record::Record(Log& log, LogCallSite& callSite) : Record(log, callSite.getLevel(), callSite.getCategory())
+{
+    m_callSite = &callSite;
+}
+
+Log::Record::~Record()
+{
+    m_stream << '\n';
+    const std::string_view message = m_stream.view().substr(m_streamOffset);
+    if (!m_callSite || m_log.isNewCallSiteMessage(*m_callSite, m_header.timestamp, LogCallSite::hash(message)))
+    {
+        m_log.commit(m_header, message);
+    }
+    m_stream.truncate(m_streamOffset);
+}
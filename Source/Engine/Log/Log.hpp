@@ -9,12 +9,22 @@
 #include <EngineDefines.hpp>
 #include <EngineTypes.hpp>
 #include <Misc/DateTimeFormatter.hpp>
+#include "ILogSink.hpp"
+#include "LogBinaryFormat.hpp"
+#include "LogCallSite.hpp"
+#include "LogFormatStream.hpp"
+#include "LogSignalSafeFile.hpp"
+#include "LogTypes.hpp"
+#include "LogWriter.hpp"
 #include <vulkan/vulkan.hpp>
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include <iostream>
 
 class Log
@@ -28,6 +38,44 @@ public:
 
     const static DateTimeBlock_t DateTimeBlock;
 
+    /*
+     * One log line, formatted into a thread-local buffer and committed as a single record
+     * when the temporary dies at the end of the full expression:
+     *     Log::getInstance().record() << "Loaded " << count << " shaders";
+     * The line is timestamped and terminated by the sinks, nested records are allowed.
+     */
+    class Record
+    {
+    public:
+        explicit Record(Log& log);
+        Record(Log& log, LogLevel level, LogCategory category);
+        Record(Log& log, LogCallSite& callSite);
+        ~Record();
+
+        Record(const Record&) = delete;
+        Record& operator=(const Record&) = delete;
+
+        template<typename T>
+        Record& operator<<(const T& value)
+        {
+            m_stream << value;
+            return *this;
+        }
+
+        Record& operator<<(OstreamManipulator manipulator)
+        {
+            manipulator(m_stream);
+            return *this;
+        }
+
+    private:
+        Log& m_log;
+        LogFormatStream& m_stream;
+        std::size_t m_streamOffset;
+        LogRecordHeader m_header;
+        LogCallSite* m_callSite = nullptr;
+    };
+
     static Log& getInstance()
     {
         static Log logSingltone;
@@ -39,49 +87,129 @@ public:
         return std::chrono::system_clock::now();
     }
 
+    void configure(const LogConfig& config);
+
+    // blocks until everything logged before the call is written by the sinks, reports of ENGINE_LOG_LIMITED included
+    void flush();
+
+    /*
+     * Crash handler only, async-signal-safe. flushSignalSafe() puts out the sink batches and the records
+     * left in the per-thread rings, writeSignalSafe() puts out one more message right away.
+     * Timestamps are omitted, the date formatting isn't safe to call there.
+     */
+    void flushSignalSafe();
+    void writeSignalSafe(LogLevel level, LogCategory category, std::string_view message);
+    // the frames of DebugUtils::captureCallstack, one line per frame
+    void writeCallstackSignalSafe(void* const* frames, int framesCount);
+    const LogConfig& getConfig() const
+    {
+        return m_config;
+    }
+
+    static constexpr bool isCompiledIn(LogLevel level)
+    {
+        return level >= compiledMinimumLogLevel;
+    }
+
+    bool isEnabled(LogLevel level, LogCategory category) const
+    {
+        return (m_enabledMask.load(std::memory_order_relaxed) >> getMaskBit(level, category)) & 1u;
+    }
+
+    // messages of the category below minimumLevel are skipped before their arguments are evaluated
+    void setLevel(LogCategory category, LogLevel minimumLevel);
+    void setLevel(LogLevel minimumLevel);
+
+    Record record()
+    {
+        return Record(*this);
+    }
+
+    // prefer ENGINE_LOG, it doesn't evaluate the arguments of filtered out messages
+    Record record(LogLevel level, LogCategory category)
+    {
+        return Record(*this, level, category);
+    }
+
+    // use ENGINE_LOG_LIMITED
+    Record record(LogCallSite& callSite)
+    {
+        return Record(*this, callSite);
+    }
+
+    // deferred formatting, only the arguments are stored here, use ENGINE_LOG_BINARY
+    template<typename... Args>
+    void binary(LogLevel level, LogCategory category, uint32_t formatId, const Args&... arguments)
+    {
+        std::vector<char>& buffer = getThreadBinaryBuffer();
+        buffer.clear();
+        (LogBinaryFormat::encodeArgument(buffer, arguments), ...);
+
+        LogRecordHeader header;
+        header.flags     = LogRecordTimestamped | LogRecordBinary | LogRecordLeveled;
+        header.timestamp = timeNow().time_since_epoch().count();
+        header.formatId  = formatId;
+        header.level     = level;
+        header.category  = category;
+        commit(header, std::string_view(buffer.data(), buffer.size()));
+    }
+
+    // use ENGINE_LOG_BINARY_LIMITED, duplicates are detected by the encoded arguments
+    template<typename... Args>
+    void binary(LogCallSite& callSite, uint32_t formatId, const Args&... arguments)
+    {
+        std::vector<char>& buffer = getThreadBinaryBuffer();
+        buffer.clear();
+        (LogBinaryFormat::encodeArgument(buffer, arguments), ...);
+
+        LogRecordHeader header;
+        header.flags     = LogRecordTimestamped | LogRecordBinary | LogRecordLeveled;
+        header.timestamp = timeNow().time_since_epoch().count();
+        header.formatId  = formatId;
+        header.level     = callSite.getLevel();
+        header.category  = callSite.getCategory();
+
+        const std::string_view message(buffer.data(), buffer.size());
+        if (isNewCallSiteMessage(callSite, header.timestamp, LogCallSite::hash(message)))
+        {
+            commit(header, message);
+        }
+    }
+
+    // legacy stream interface: tokens are collected per thread until std::endl or std::flush
     template<typename T>
     Log& operator<<(const T& value)
     {
-        std::lock_guard<std::mutex> scopeLock(m_mutex);
-        m_logFile << value << std::flush;
-#if defined(ENGINE_DEBUG)
-        std::cout << value << std::flush;
-#endif
+        getThreadStream() << value;
         return *this;
     }
 
     Log& operator<<(const DateTimeBlock_t& value);
-    Log& operator<<(OstreamManipulator pf)
-    {
-        return operator<<<OstreamManipulator>(pf);
-    }
+    Log& operator<<(OstreamManipulator manipulator);
 
     Log& operator<<(const Kompot::DateTimeFormat& dateTimeFormatter);
 
     Log& operator<<(const std::chrono::system_clock::time_point& time);
 
-    ~Log()
-    {
-        m_logFile.close();
-    }
+    ~Log();
 
     /* ostream-like part for templates*/
     char fill() const
     {
-        return m_logFile.fill();
+        return getThreadStream().fill();
     }
     char fill(char fillCharacter)
     {
-        return m_logFile.fill(fillCharacter);
+        return getThreadStream().fill(fillCharacter);
     }
 
     std::streamsize width() const
     {
-        return m_logFile.width();
+        return getThreadStream().width();
     }
     std::streamsize width(std::streamsize newWidthValue)
     {
-        return m_logFile.width(newWidthValue);
+        return getThreadStream().width(newWidthValue);
     }
 
     Log& write(const char* text, std::streamsize size);
@@ -91,8 +219,115 @@ public:
 private:
     Log();
 
+    static LogFormatStream& getThreadStream();
+    static LogFormatStream& getThreadRecordStream();
+    static LogFormatStream& getThreadReportStream();
+    static LogRecordHeader& getThreadStreamHeader();
+    static std::vector<char>& getThreadBinaryBuffer();
+    static uint16_t getThreadIndex();
+
+    void createSinks(bool keepFileSink, bool keepJsonSink);
+
+    static constexpr uint32_t getMaskBit(LogLevel level, LogCategory category)
+    {
+        return static_cast<uint32_t>(category) * static_cast<uint32_t>(LogLevel::Count) + static_cast<uint32_t>(level);
+    }
+
+    void commit(LogRecordHeader header, std::string_view message);
+    void commitThreadStream();
+
+    // commits the report of the skipped messages if it is due, false if the message is a duplicate
+    bool isNewCallSiteMessage(LogCallSite& callSite, int64_t timestamp, uint64_t messageHash);
+    // m_mutex must be held
+    void writeCallSiteReports(bool force);
+
     std::ofstream m_logFile;
-    std::mutex m_mutex;
+    LogSignalSafeFile m_logSignalSafeFile; // the same file for the crash handler
+    std::mutex m_mutex; // guards the sinks, the writer thread holds it while they write and flush
+
+    LogWriter::Sinks m_sinks;
+
+    LogConfig m_config;
+    std::atomic<LogMode> m_mode = LogMode::Synchronous;
 
+    // one bit per level of each category
+    std::atomic<uint64_t> m_enabledMask = 0;
+    static_assert(static_cast<uint32_t>(LogCategory::Count) * static_cast<uint32_t>(LogLevel::Count) <= 64);
+    LogWriter m_writer;
+
+    // separate from m_mutex, so a producer printing a time doesn't wait for the sinks' disk I/O
+    std::mutex m_dateTimeMutex;
     Kompot::DateTimeFormatter m_dateTimeFormatter;
 };
+
+/*
+ * Leveled message, filtered out at compile time by compiledMinimumLogLevel and at runtime by Log::setLevel,
+ * in both cases the arguments aren't evaluated:
+ *     ENGINE_LOG(Warning, Renderer) << "Swapchain is suboptimal, " << width << 'x' << height;
+ */
+#define ENGINE_LOG(level, category)                                                                                \
+    if constexpr (!Log::isCompiledIn(LogLevel::level))                                                             \
+    {                                                                                                              \
+    }                                                                                                              \
+    else if (!Log::getInstance().isEnabled(LogLevel::level, LogCategory::category))                                \
+    {                                                                                                              \
+    }                                                                                                              \
+    else                                                                                                           \
+        Log::getInstance().record(LogLevel::level, LogCategory::category)
+
+/*
+ * Same as ENGINE_LOG, but without formatting on the calling thread,
+ * the format must be a string literal with "{}" or "{name}" placeholders, the names key the JSON log fields:
+ *     ENGINE_LOG_BINARY(Warning, Renderer, "presentResult = {presentResult}", presentResult);
+ */
+#define ENGINE_LOG_BINARY(level, category, format, ...)                                                            \
+    do                                                                                                             \
+    {                                                                                                              \
+        if constexpr (Log::isCompiledIn(LogLevel::level))                                                          \
+        {                                                                                                          \
+            if (Log::getInstance().isEnabled(LogLevel::level, LogCategory::category))                              \
+            {                                                                                                      \
+                static const uint32_t logFormatId = LogBinaryFormat::FormatRegistry::get().registerFormat(format); \
+                Log::getInstance().binary(LogLevel::level, LogCategory::category, logFormatId, ##__VA_ARGS__);     \
+            }                                                                                                      \
+        }                                                                                                          \
+    } while (false)
+
+/*
+ * ENGINE_LOG for messages which may come every frame: at most maxMessagesPerSecond lines per second
+ * are formatted (0 means no limit), consecutive equal lines are collapsed, the skipped ones are
+ * reported as "previous message repeated 5312 times in 0.998s":
+ *     ENGINE_LOG_LIMITED(Warning, Renderer, 10) << "Validation: " << message;
+ */
+#define ENGINE_LOG_LIMITED(level, category, maxMessagesPerSecond)                                                  \
+    if constexpr (!Log::isCompiledIn(LogLevel::level))                                                             \
+    {                                                                                                              \
+    }                                                                                                              \
+    else if (!Log::getInstance().isEnabled(LogLevel::level, LogCategory::category))                                \
+    {                                                                                                              \
+    }                                                                                                              \
+    else if (static LogCallSite logCallSite(LogLevel::level, LogCategory::category, __FILE__, __LINE__,            \
+                                            maxMessagesPerSecond);                                                 \
+             !logCallSite.tryAcquire(Log::timeNow().time_since_epoch().count()))                                   \
+    {                                                                                                              \
+    }                                                                                                              \
+    else                                                                                                           \
+        Log::getInstance().record(logCallSite)
+
+#define ENGINE_LOG_BINARY_LIMITED(level, category, maxMessagesPerSecond, format, ...)                              \
+    do                                                                                                             \
+    {                                                                                                              \
+        if constexpr (Log::isCompiledIn(LogLevel::level))                                                          \
+        {                                                                                                          \
+            if (Log::getInstance().isEnabled(LogLevel::level, LogCategory::category))                              \
+            {                                                                                                      \
+                static LogCallSite logCallSite(LogLevel::level, LogCategory::category, __FILE__, __LINE__,         \
+                                               maxMessagesPerSecond);                                              \
+                static const uint32_t logFormatId = LogBinaryFormat::FormatRegistry::get().registerFormat(format); \
+                if (logCallSite.tryAcquire(Log::timeNow().time_since_epoch().count()))                             \
+                {                                                                                                  \
+                    Log::getInstance().binary(logCallSite, logFormatId, ##__VA_ARGS__);                            \
+                }                                                                                                  \
+            }                                                                                                      \
+        }                                                                                                          \
+    } while (false)
@@ -0,0 +1,265 @@
+/*
+ *  LogBinaryFormat.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogBinaryFormat.hpp"
+#include <algorithm>
+
+using namespace LogBinaryFormat;
+
+FormatRegistry& FormatRegistry::get()
+{
+    static FormatRegistry formatRegistrySingltone;
+    return formatRegistrySingltone;
+}
+
+uint32_t FormatRegistry::registerFormat(const char* format)
+{
+    const uint32_t formatId = m_formatsCount.fetch_add(1, std::memory_order_relaxed);
+    if (formatId >= maxFormatsCount)
+    {
+        return invalidFormatId;
+    }
+
+    m_formats[formatId].store(format, std::memory_order_release);
+    return formatId;
+}
+
+const char* FormatRegistry::getFormat(uint32_t formatId) const
+{
+    if (formatId == invalidFormatId || formatId >= maxFormatsCount)
+    {
+        return nullptr;
+    }
+    return m_formats[formatId].load(std::memory_order_acquire);
+}
+
+namespace
+{
+template<typename T>
+bool readRaw(std::string_view& arguments, T& value)
+{
+    if (arguments.size() < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, arguments.data(), sizeof(T));
+    arguments.remove_prefix(sizeof(T));
+    return true;
+}
+
+template<typename Stored, typename Value>
+bool readValue(std::string_view& arguments, Value& value)
+{
+    Stored storedValue{};
+    if (!readRaw(arguments, storedValue))
+    {
+        return false;
+    }
+    value = static_cast<Value>(storedValue);
+    return true;
+}
+
+bool isPlaceholderName(std::string_view name)
+{
+    return std::all_of(name.begin(), name.end(), [](char character) {
+        return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') || (character >= '0' && character <= '9') ||
+               character == '_';
+    });
+}
+
+void formatArgument(std::ostream& output, const Argument& argument)
+{
+    switch (argument.type)
+    {
+    case ArgumentType::Bool:
+        output << (argument.integer ? "true" : "false");
+        break;
+    case ArgumentType::Char:
+        output << static_cast<char>(argument.integer);
+        break;
+    case ArgumentType::Int64:
+        output << argument.integer;
+        break;
+    case ArgumentType::UInt64:
+        output << argument.unsignedInteger;
+        break;
+    case ArgumentType::Double:
+        output << argument.floating;
+        break;
+    case ArgumentType::String:
+        output.write(argument.text.data(), static_cast<std::streamsize>(argument.text.size()));
+        break;
+    case ArgumentType::Pointer:
+        output << reinterpret_cast<const void*>(argument.unsignedInteger);
+        break;
+    case ArgumentType::VulkanResult:
+        output << vk::to_string(static_cast<vk::Result>(argument.integer));
+        break;
+    }
+}
+
+void formatArgument(LogFixedBuffer& output, const Argument& argument)
+{
+    switch (argument.type)
+    {
+    case ArgumentType::Bool:
+        output.append(argument.integer ? "true" : "false");
+        break;
+    case ArgumentType::Char:
+        output.append(static_cast<char>(argument.integer));
+        break;
+    case ArgumentType::Int64:
+        output.appendInteger(argument.integer);
+        break;
+    case ArgumentType::UInt64:
+        output.appendInteger(argument.unsignedInteger);
+        break;
+    case ArgumentType::Double:
+    {
+        double value = argument.floating;
+        if (value != value)
+        {
+            output.append("nan");
+            break;
+        }
+        if (value < 0.0)
+        {
+            output.append('-');
+            value = -value;
+        }
+        if (value >= 1e19)
+        {
+            output.append("inf");
+            break;
+        }
+
+        const auto integerPart  = static_cast<uint64_t>(value);
+        const auto fractionPart = static_cast<uint64_t>((value - static_cast<double>(integerPart)) * 1000.0);
+        output.appendInteger(integerPart);
+        output.append('.');
+        output.append(static_cast<char>('0' + fractionPart / 100 % 10));
+        output.append(static_cast<char>('0' + fractionPart / 10 % 10));
+        output.append(static_cast<char>('0' + fractionPart % 10));
+        break;
+    }
+    case ArgumentType::String:
+        output.append(argument.text);
+        break;
+    case ArgumentType::Pointer:
+        output.appendHex(argument.unsignedInteger);
+        break;
+    case ArgumentType::VulkanResult:
+        output.append("VkResult(");
+        output.appendInteger(argument.integer);
+        output.append(')');
+        break;
+    }
+}
+
+template<typename Output>
+bool substituteArguments(Output& output, std::string_view format, std::string_view arguments)
+{
+    std::string_view text;
+    std::string_view name;
+    while (readPlaceholder(format, text, name))
+    {
+        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+        if (arguments.empty())
+        {
+            output.write(text.data() + text.size(), static_cast<std::streamsize>(name.size() + 2));
+            continue;
+        }
+
+        Argument argument;
+        if (!readArgument(arguments, argument))
+        {
+            output.write("<malformed arguments>", 21);
+            return false;
+        }
+        formatArgument(output, argument);
+    }
+    output.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return true;
+}
+
+} // namespace
+
+bool LogBinaryFormat::readArgument(std::string_view& arguments, Argument& argument)
+{
+    uint8_t type = 0;
+    if (!readRaw(arguments, type))
+    {
+        return false;
+    }
+
+    argument      = Argument{};
+    argument.type = static_cast<ArgumentType>(type);
+    switch (argument.type)
+    {
+    case ArgumentType::Bool:
+        return readValue<uint8_t>(arguments, argument.integer);
+    case ArgumentType::Char:
+        return readValue<char>(arguments, argument.integer);
+    case ArgumentType::Int64:
+        return readValue<int64_t>(arguments, argument.integer);
+    case ArgumentType::UInt64:
+    case ArgumentType::Pointer:
+        return readValue<uint64_t>(arguments, argument.unsignedInteger);
+    case ArgumentType::Double:
+        return readValue<double>(arguments, argument.floating);
+    case ArgumentType::String:
+    {
+        uint32_t length = 0;
+        if (!readRaw(arguments, length) || arguments.size() < length)
+        {
+            return false;
+        }
+        argument.text = arguments.substr(0, length);
+        arguments.remove_prefix(length);
+        return true;
+    }
+    case ArgumentType::VulkanResult:
+        return readValue<int32_t>(arguments, argument.integer);
+    default:
+        return false;
+    }
+}
+
+bool LogBinaryFormat::readPlaceholder(std::string_view& format, std::string_view& text, std::string_view& name)
+{
+    for (std::size_t opening = format.find('{'); opening != std::string_view::npos; opening = format.find('{', opening + 1))
+    {
+        const std::size_t closing = format.find('}', opening + 1);
+        if (closing == std::string_view::npos)
+        {
+            break;
+        }
+
+        name = format.substr(opening + 1, closing - opening - 1);
+        if (isPlaceholderName(name))
+        {
+            text = format.substr(0, opening);
+            format.remove_prefix(closing + 1);
+            return true;
+        }
+    }
+
+    text = format;
+    name = {};
+    format.remove_prefix(format.size());
+    return false;
+}
+
+bool LogBinaryFormat::formatMessage(std::ostream& output, std::string_view format, std::string_view arguments)
+{
+    return substituteArguments(output, format, arguments);
+}
+
+bool LogBinaryFormat::formatMessage(LogFixedBuffer& output, std::string_view format, std::string_view arguments)
+{
+    return substituteArguments(output, format, arguments);
+}
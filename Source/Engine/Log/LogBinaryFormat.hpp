@@ -0,0 +1,155 @@
+/*
+ *  LogBinaryFormat.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "LogFormatStream.hpp"
+#include <EngineTypes.hpp>
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Deferred formatting: a call site stores only the id of its static format string and the raw
+ * bytes of the arguments, the text is produced later by the writer thread or by KompotLogDecoder.
+ * Placeholders in the format are "{}" or "{name}", they are substituted in order,
+ * the names become the keys of the fields in the JSON log.
+ */
+namespace LogBinaryFormat
+{
+static constexpr std::array<char, 4> fileMagic = {'K', 'L', 'O', 'G'};
+static constexpr uint32_t fileVersion          = 1;
+
+enum class ArgumentType : uint8_t
+{
+    Bool,
+    Char,
+    Int64,
+    UInt64,
+    Double,
+    String, // uint32_t length, then the characters
+    Pointer,
+    VulkanResult
+};
+
+class FormatRegistry
+{
+public:
+    static FormatRegistry& get();
+
+    // called once per call site, the format must be a string literal
+    uint32_t registerFormat(const char* format);
+
+    // nullptr for unknown ids
+    const char* getFormat(uint32_t formatId) const;
+
+    static constexpr uint32_t invalidFormatId = 0;
+
+private:
+    static constexpr std::size_t maxFormatsCount = 4096;
+
+    std::atomic<uint32_t> m_formatsCount = 1; // 0 is reserved for invalidFormatId
+    std::array<std::atomic<const char*>, maxFormatsCount> m_formats{};
+};
+
+template<typename T>
+inline void appendRaw(std::vector<char>& output, const T& value)
+{
+    const auto offset = output.size();
+    output.resize(offset + sizeof(T));
+    std::memcpy(output.data() + offset, &value, sizeof(T));
+}
+
+template<typename>
+inline constexpr bool unsupportedArgument = false;
+
+template<typename T>
+void encodeArgument(std::vector<char>& output, const T& value)
+{
+    if constexpr (std::is_same_v<T, bool>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::Bool));
+        output.push_back(static_cast<char>(value));
+    }
+    else if constexpr (std::is_same_v<T, char>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::Char));
+        output.push_back(value);
+    }
+    else if constexpr (std::is_same_v<T, vk::Result>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::VulkanResult));
+        appendRaw(output, static_cast<int32_t>(value));
+    }
+    else if constexpr (std::is_enum_v<T>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::Int64));
+        appendRaw(output, static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::Int64));
+        appendRaw(output, static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<T>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::UInt64));
+        appendRaw(output, static_cast<uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::Double));
+        appendRaw(output, static_cast<double>(value));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+        const std::string_view text = value;
+        output.push_back(static_cast<char>(ArgumentType::String));
+        appendRaw(output, static_cast<uint32_t>(text.size()));
+        output.insert(output.end(), text.begin(), text.end());
+    }
+    else if constexpr (std::is_pointer_v<T>)
+    {
+        output.push_back(static_cast<char>(ArgumentType::Pointer));
+        appendRaw(output, reinterpret_cast<uint64_t>(value));
+    }
+    else
+    {
+        static_assert(unsupportedArgument<T>, "The type can't be stored in the binary log");
+    }
+}
+
+// one decoded argument, only the member of its type is set
+struct Argument
+{
+    ArgumentType type        = ArgumentType::Bool;
+    int64_t integer          = 0; // Bool, Char, Int64, VulkanResult
+    uint64_t unsignedInteger = 0; // UInt64, Pointer
+    double floating          = 0.0;
+    std::string_view text; // String, points into the encoded arguments
+};
+
+// takes the next argument off the encoded arguments, false at the end or if they are malformed
+bool readArgument(std::string_view& arguments, Argument& argument);
+
+/*
+ * Takes the text up to the next placeholder and the placeholder itself off the format, name is empty for "{}".
+ * Returns false if there are no placeholders left, then text is the rest of the format.
+ */
+bool readPlaceholder(std::string_view& format, std::string_view& text, std::string_view& name);
+
+// substitutes encoded arguments into the format, returns false for malformed arguments
+bool formatMessage(std::ostream& output, std::string_view format, std::string_view arguments);
+
+// async-signal-safe version for the crash handler, doubles are printed with 3 fractional digits, Vulkan results as numbers
+bool formatMessage(LogFixedBuffer& output, std::string_view format, std::string_view arguments);
+
+} // namespace LogBinaryFormat
@@ -0,0 +1,95 @@
+/*
+ *  LogBinarySink.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogBinarySink.hpp"
+#include "LogBinaryFormat.hpp"
+#include <cstring>
+
+LogBinarySink::LogBinarySink(const std::filesystem::path& path) : m_file(path, std::ios::binary | std::ios::trunc)
+{
+    m_file.write(LogBinaryFormat::fileMagic.data(), LogBinaryFormat::fileMagic.size());
+    m_file.write(reinterpret_cast<const char*>(&LogBinaryFormat::fileVersion), sizeof(LogBinaryFormat::fileVersion));
+    m_file.flush();
+
+    // appends, so the crash handler's records go after the flushed batches
+    m_signalSafeFile.open(path);
+}
+
+LogBinarySink::~LogBinarySink()
+{
+    flush();
+}
+
+void LogBinarySink::write(const LogRecordHeader& header, std::string_view message)
+{
+    if (header.flags & LogRecordBinary)
+    {
+        if (header.formatId >= m_writtenFormats.size())
+        {
+            m_writtenFormats.resize(header.formatId + 1, false);
+        }
+        if (!m_writtenFormats[header.formatId])
+        {
+            const char* format = LogBinaryFormat::FormatRegistry::get().getFormat(header.formatId);
+
+            LogRecordHeader definitionHeader{};
+            definitionHeader.flags    = LogRecordFormatDefinition;
+            definitionHeader.formatId = header.formatId;
+            append(definitionHeader, format ? format : "");
+            m_writtenFormats[header.formatId] = true;
+        }
+    }
+
+    append(header, message);
+
+    if (m_batch.size() > batchSizeLimit)
+    {
+        flush();
+    }
+}
+
+void LogBinarySink::flush()
+{
+    if (m_batch.empty())
+    {
+        return;
+    }
+
+    m_file.write(m_batch.data(), static_cast<std::streamsize>(m_batch.size()));
+    m_file.flush();
+    m_batch.clear();
+}
+
+void LogBinarySink::flushSignalSafe()
+{
+    LogSignalSafeFile::write(m_signalSafeFile.getDescriptor(), std::string_view(m_batch.data(), m_batch.size()));
+    m_batch.clear();
+}
+
+void LogBinarySink::writeSignalSafe(std::string_view line)
+{
+    // the line is formatted already, the decoder prints a record without flags as is
+    LogRecordHeader header{};
+    header.size = static_cast<uint32_t>(line.size());
+
+    const int descriptor = m_signalSafeFile.getDescriptor();
+    LogSignalSafeFile::write(descriptor, std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)));
+    LogSignalSafeFile::write(descriptor, line);
+}
+
+void LogBinarySink::append(const LogRecordHeader& header, std::string_view message)
+{
+    LogRecordHeader storedHeader = header;
+    storedHeader.size            = static_cast<uint32_t>(message.size());
+
+    const auto offset = m_batch.size();
+    m_batch.resize(offset + sizeof(storedHeader) + message.size());
+    std::memcpy(m_batch.data() + offset, &storedHeader, sizeof(storedHeader));
+    if (!message.empty())
+    {
+        std::memcpy(m_batch.data() + offset + sizeof(storedHeader), message.data(), message.size());
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ *  LogBinarySink.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ILogSink.hpp"
+#include "LogSignalSafeFile.hpp"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+/*
+ * Stores the records as is (see Docs/KLOG format.md), the text of a format is written once,
+ * right before its first use. Use KompotLogDecoder to get the text log.
+ */
+class LogBinarySink : public ILogSink
+{
+public:
+    explicit LogBinarySink(const std::filesystem::path& path);
+    ~LogBinarySink();
+
+    void write(const LogRecordHeader& header, std::string_view message) override;
+    void flush() override;
+
+    // the batch goes out as raw records, a crash line as a record of plain text
+    void flushSignalSafe() override;
+    void writeSignalSafe(std::string_view line) override;
+
+private:
+    void append(const LogRecordHeader& header, std::string_view message);
+
+    std::ofstream m_file;
+    LogSignalSafeFile m_signalSafeFile;
+    std::vector<char> m_batch;
+    std::vector<bool> m_writtenFormats;
+
+    static constexpr std::size_t batchSizeLimit = 1024 * 1024;
+};
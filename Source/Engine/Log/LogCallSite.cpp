@@ -0,0 +1,72 @@
+/*
+ *  LogCallSite.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogCallSite.hpp"
+#include <algorithm>
+#include <iomanip>
+
+std::atomic<LogCallSite*> LogCallSite::s_first           = nullptr;
+std::atomic<uint32_t> LogCallSite::s_pendingReportsCount = 0;
+
+namespace
+{
+std::string_view getFileName(std::string_view path)
+{
+    const std::size_t separator = path.find_last_of("/\\");
+    return separator == std::string_view::npos ? path : path.substr(separator + 1);
+}
+
+} // namespace
+
+LogCallSite::LogCallSite(LogLevel level, LogCategory category, const char* file, uint32_t line, uint32_t maxMessagesPerSecond) :
+    m_level(level), m_category(category), m_fileName(getFileName(file)), m_line(line), m_maxMessagesPerSecond(maxMessagesPerSecond)
+{
+    m_next = s_first.load(std::memory_order_relaxed);
+    while (!s_first.compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+bool LogCallSite::takeReport(int64_t timestamp, bool force, std::ostream& output)
+{
+    int64_t suppressedSince = m_suppressedSince.load(std::memory_order_relaxed);
+    if (suppressedSince == 0 || (!force && timestamp - suppressedSince < windowLength))
+    {
+        return false;
+    }
+
+    // the writer thread and the producers may get here at once, only one of them reports
+    if (!m_suppressedSince.compare_exchange_strong(suppressedSince, 0, std::memory_order_relaxed))
+    {
+        return false;
+    }
+    s_pendingReportsCount.fetch_sub(1, std::memory_order_relaxed);
+    const uint64_t repeatedCount   = m_repeatedCount.exchange(0, std::memory_order_relaxed);
+    const uint64_t suppressedCount = m_suppressedCount.exchange(0, std::memory_order_relaxed);
+    if (repeatedCount == 0 && suppressedCount == 0)
+    {
+        return false;
+    }
+
+    // milliseconds from the first skipped message to the last one
+    const int64_t lastSuppressed = m_lastSuppressed.load(std::memory_order_relaxed);
+    const int64_t period         = std::max<int64_t>(lastSuppressed - suppressedSince, 0) * 1000 / windowLength;
+
+    output << " [Log] " << m_fileName << ':' << m_line << ':';
+    if (repeatedCount > 0)
+    {
+        output << " previous message repeated " << repeatedCount << " times";
+    }
+    if (suppressedCount > 0)
+    {
+        output << (repeatedCount > 0 ? "," : "") << ' ' << suppressedCount << " messages over the limit of " << m_maxMessagesPerSecond
+               << " per second skipped";
+    }
+    const char fill = output.fill('0');
+    output << " in " << period / 1000 << '.' << std::setw(3) << period % 1000 << "s\n";
+    output.fill(fill);
+    return true;
+}
@@ -0,0 +1,141 @@
+/*
+ *  LogCallSite.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "LogTypes.hpp"
+#include <atomic>
+#include <ostream>
+#include <string_view>
+
+/*
+ * State of one ENGINE_LOG_LIMITED statement, lives in a static at the call site.
+ * Over maxMessagesPerSecond messages are skipped before formatting, a message equal to the previous one
+ * of the same call site is skipped after formatting. Both are counted and reported once per second
+ * at most, e.g. "previous message repeated 5312 times in 0.998s".
+ * All the call sites are linked into a list, so the counts left after a storm has ended are reported too:
+ * by the writer thread in the asynchronous mode, by the next line or Log::flush() in the synchronous one.
+ */
+class LogCallSite
+{
+public:
+    LogCallSite(LogLevel level, LogCategory category, const char* file, uint32_t line, uint32_t maxMessagesPerSecond);
+
+    // before formatting, false if the limit of the current second is used up
+    bool tryAcquire(int64_t timestamp)
+    {
+        if (m_maxMessagesPerSecond == 0)
+        {
+            return true;
+        }
+
+        int64_t windowStart = m_windowStart.load(std::memory_order_relaxed);
+        if (timestamp - windowStart >= windowLength && m_windowStart.compare_exchange_strong(windowStart, timestamp, std::memory_order_relaxed))
+        {
+            m_windowCount.store(0, std::memory_order_relaxed);
+        }
+
+        if (m_windowCount.fetch_add(1, std::memory_order_relaxed) < m_maxMessagesPerSecond)
+        {
+            return true;
+        }
+        countSuppressed(m_suppressedCount, timestamp);
+        return false;
+    }
+
+    // after formatting, false if the message is the same as the previous one of this call site
+    bool isNewMessage(uint64_t messageHash, int64_t timestamp)
+    {
+        if (m_lastMessageHash.exchange(messageHash, std::memory_order_relaxed) != messageHash)
+        {
+            return true;
+        }
+        countSuppressed(m_repeatedCount, timestamp);
+        return false;
+    }
+
+    bool hasRepeats() const
+    {
+        return m_repeatedCount.load(std::memory_order_relaxed) != 0;
+    }
+
+    /*
+     * Writes " [Log] ..." line about skipped messages and resets the counts. Without force only counts
+     * older than a second are reported. Returns false if there was nothing to report or another thread
+     * has taken the report first.
+     */
+    bool takeReport(int64_t timestamp, bool force, std::ostream& output);
+
+    // true if any call site has skipped messages not reported yet
+    static bool hasPendingReports()
+    {
+        return s_pendingReportsCount.load(std::memory_order_relaxed) != 0;
+    }
+
+    LogLevel getLevel() const
+    {
+        return m_level;
+    }
+
+    LogCategory getCategory() const
+    {
+        return m_category;
+    }
+
+    static LogCallSite* getFirst()
+    {
+        return s_first.load(std::memory_order_acquire);
+    }
+
+    LogCallSite* getNext() const
+    {
+        return m_next;
+    }
+
+    // FNV-1a, for comparing messages only
+    static uint64_t hash(std::string_view data, uint64_t seed = 14695981039346656037ull)
+    {
+        for (const char character : data)
+        {
+            seed = (seed ^ static_cast<uint8_t>(character)) * 1099511628211ull;
+        }
+        return seed;
+    }
+
+    static constexpr int64_t windowLength = std::chrono::duration_cast<std::chrono::system_clock::duration>(1s).count();
+
+private:
+    void countSuppressed(std::atomic<uint64_t>& counter, int64_t timestamp)
+    {
+        if (counter.fetch_add(1, std::memory_order_relaxed) == 0)
+        {
+            int64_t noTimestamp = 0;
+            if (m_suppressedSince.compare_exchange_strong(noTimestamp, timestamp, std::memory_order_relaxed))
+            {
+                s_pendingReportsCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        m_lastSuppressed.store(timestamp, std::memory_order_relaxed);
+    }
+
+    const LogLevel m_level;
+    const LogCategory m_category;
+    const std::string_view m_fileName;
+    const uint32_t m_line;
+    const uint32_t m_maxMessagesPerSecond; // 0 means no limit, only the duplicates are collapsed
+
+    std::atomic<int64_t> m_windowStart      = 0;
+    std::atomic<uint32_t> m_windowCount     = 0;
+    std::atomic<uint64_t> m_lastMessageHash = 0;
+    std::atomic<uint64_t> m_suppressedCount = 0;
+    std::atomic<uint64_t> m_repeatedCount   = 0;
+    std::atomic<int64_t> m_suppressedSince  = 0;
+    std::atomic<int64_t> m_lastSuppressed   = 0;
+
+    LogCallSite* m_next = nullptr;
+    static std::atomic<LogCallSite*> s_first;
+    static std::atomic<uint32_t> s_pendingReportsCount;
+};
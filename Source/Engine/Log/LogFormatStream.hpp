@@ -0,0 +1,198 @@
+/*
+ *  LogFormatStream.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <EngineTypes.hpp>
+#include <algorithm>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+/*
+ * Growable in-memory streambuf, keeps its storage between clear() calls,
+ * so after warm-up formatting a message doesn't allocate.
+ */
+class LogFormatBuffer : public std::streambuf
+{
+public:
+    LogFormatBuffer()
+    {
+        m_buffer.resize(256);
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+    std::string_view view() const
+    {
+        return {pbase(), static_cast<std::size_t>(pptr() - pbase())};
+    }
+
+    std::size_t size() const
+    {
+        return static_cast<std::size_t>(pptr() - pbase());
+    }
+
+    void clear()
+    {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+    void truncate(std::size_t newSize)
+    {
+        clear();
+        pbump(static_cast<int>(newSize));
+    }
+
+protected:
+    int_type overflow(int_type character) override
+    {
+        const auto usedSize = size();
+        m_buffer.resize(std::max<std::size_t>(m_buffer.size() * 2, 256));
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        pbump(static_cast<int>(usedSize));
+
+        if (!traits_type::eq_int_type(character, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(character);
+            pbump(1);
+        }
+        return traits_type::not_eof(character);
+    }
+
+    std::streamsize xsputn(const char* text, std::streamsize count) override
+    {
+        const auto requiredSize = size() + static_cast<std::size_t>(count);
+        if (requiredSize > m_buffer.size())
+        {
+            const auto usedSize = size();
+            m_buffer.resize(std::max(requiredSize, m_buffer.size() * 2));
+            setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+            pbump(static_cast<int>(usedSize));
+        }
+        std::copy_n(text, count, pptr());
+        pbump(static_cast<int>(count));
+        return count;
+    }
+
+private:
+    std::vector<char> m_buffer;
+};
+
+class LogFormatStream : public std::ostream
+{
+public:
+    LogFormatStream() : std::ostream(&m_buffer)
+    {
+    }
+
+    std::string_view view() const
+    {
+        return m_buffer.view();
+    }
+
+    std::size_t size() const
+    {
+        return m_buffer.size();
+    }
+
+    void clear()
+    {
+        m_buffer.clear();
+    }
+
+    void truncate(std::size_t newSize)
+    {
+        m_buffer.truncate(newSize);
+    }
+
+private:
+    LogFormatBuffer m_buffer;
+};
+
+/*
+ * Fixed capacity writer for the crash handler: doesn't allocate and doesn't touch the locale,
+ * so it can be used from a signal handler. What doesn't fit is cut off.
+ */
+class LogFixedBuffer
+{
+public:
+    LogFixedBuffer(char* data, std::size_t capacity) : m_data(data), m_capacity(capacity)
+    {
+    }
+
+    std::string_view view() const
+    {
+        return {m_data, m_size};
+    }
+
+    void clear()
+    {
+        m_size = 0;
+    }
+
+    void append(char character)
+    {
+        if (m_size < m_capacity)
+        {
+            m_data[m_size++] = character;
+        }
+    }
+
+    void append(std::string_view text)
+    {
+        const std::size_t size = std::min(text.size(), m_capacity - m_size);
+        std::copy_n(text.data(), size, m_data + m_size);
+        m_size += size;
+    }
+
+    void appendInteger(uint64_t value)
+    {
+        char digits[20];
+        std::size_t digitsCount = 0;
+        do
+        {
+            digits[digitsCount++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+
+        while (digitsCount > 0)
+        {
+            append(digits[--digitsCount]);
+        }
+    }
+
+    void appendInteger(int64_t value)
+    {
+        if (value < 0)
+        {
+            append('-');
+            appendInteger(0 - static_cast<uint64_t>(value));
+            return;
+        }
+        appendInteger(static_cast<uint64_t>(value));
+    }
+
+    // same signature as std::ostream::write
+    void write(const char* text, std::streamsize size)
+    {
+        append(std::string_view(text, static_cast<std::size_t>(size)));
+    }
+
+    void appendHex(uint64_t value)
+    {
+        append("0x");
+        for (int shift = 60; shift >= 0; shift -= 4)
+        {
+            append("0123456789abcdef"[(value >> shift) & 0xF]);
+        }
+    }
+
+private:
+    char* m_data;
+    std::size_t m_capacity;
+    std::size_t m_size = 0;
+};
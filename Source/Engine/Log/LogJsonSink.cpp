@@ -0,0 +1,263 @@
+/*
+ *  LogJsonSink.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogJsonSink.hpp"
+#include "LogBinaryFormat.hpp"
+#include <charconv>
+#include <chrono>
+
+namespace
+{
+// names is a sequence of '\0' terminated names
+bool containsName(std::string_view names, std::string_view name)
+{
+    while (!names.empty())
+    {
+        const std::size_t end = names.find('\0');
+        if (names.substr(0, end) == name)
+        {
+            return true;
+        }
+        names.remove_prefix(end + 1);
+    }
+    return false;
+}
+
+} // namespace
+
+LogJsonSink::LogJsonSink(const std::filesystem::path& path) : m_file(path, std::ios::binary | std::ios::trunc)
+{
+}
+
+LogJsonSink::~LogJsonSink()
+{
+    flush();
+}
+
+void LogJsonSink::write(const LogRecordHeader& header, std::string_view message)
+{
+    if (header.flags & LogRecordFormatDefinition)
+    {
+        return;
+    }
+
+    m_batch.put('{');
+    if (header.flags & LogRecordTimestamped)
+    {
+        using Clock = std::chrono::system_clock;
+        m_batch.write("\"timestamp\":", 12);
+        appendNumber(std::chrono::duration_cast<std::chrono::microseconds>(Clock::duration(header.timestamp)).count());
+        m_batch.put(',');
+    }
+
+    m_batch.write("\"thread\":", 9);
+    appendNumber(header.threadIndex);
+
+    if (header.flags & LogRecordLeveled)
+    {
+        const std::string_view level    = logLevelNames[static_cast<std::size_t>(header.level)];
+        const std::string_view category = logCategoryNames[static_cast<std::size_t>(header.category)];
+        m_batch.write(",\"level\":\"", 10);
+        m_batch.write(level.data(), static_cast<std::streamsize>(level.size()));
+        m_batch.write("\",\"category\":\"", 14);
+        m_batch.write(category.data(), static_cast<std::streamsize>(category.size()));
+        m_batch.put('"');
+    }
+
+    m_batch.write(",\"message\":\"", 12);
+    if (header.flags & LogRecordBinary)
+    {
+        const char* format = LogBinaryFormat::FormatRegistry::get().getFormat(header.formatId);
+        m_message.clear();
+        LogBinaryFormat::formatMessage(m_message, format ? format : "<unknown format>", message);
+        appendEscaped(m_message.view());
+        m_batch.put('"');
+        if (format)
+        {
+            appendFields(format, message);
+        }
+    }
+    else
+    {
+        // text records are " message\n", the same as the text sinks get
+        if (!message.empty() && message.front() == ' ')
+        {
+            message.remove_prefix(1);
+        }
+        if (!message.empty() && message.back() == '\n')
+        {
+            message.remove_suffix(1);
+        }
+        appendEscaped(message);
+        m_batch.put('"');
+    }
+    m_batch.write("}\n", 2);
+
+    if (m_batch.size() > batchSizeLimit)
+    {
+        flush();
+    }
+}
+
+void LogJsonSink::flush()
+{
+    const auto batch = m_batch.view();
+    if (batch.empty())
+    {
+        return;
+    }
+
+    m_file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    m_file.flush();
+    m_batch.clear();
+}
+
+void LogJsonSink::appendEscaped(std::string_view text)
+{
+    std::size_t plainBegin = 0;
+    for (std::size_t position = 0; position < text.size(); ++position)
+    {
+        const auto character = static_cast<unsigned char>(text[position]);
+        if (character >= 0x20 && character != '"' && character != '\\')
+        {
+            continue;
+        }
+
+        m_batch.write(text.data() + plainBegin, static_cast<std::streamsize>(position - plainBegin));
+        plainBegin = position + 1;
+        switch (character)
+        {
+        case '"':
+            m_batch.write("\\\"", 2);
+            break;
+        case '\\':
+            m_batch.write("\\\\", 2);
+            break;
+        case '\n':
+            m_batch.write("\\n", 2);
+            break;
+        case '\r':
+            m_batch.write("\\r", 2);
+            break;
+        case '\t':
+            m_batch.write("\\t", 2);
+            break;
+        default:
+            m_batch.write("\\u00", 4);
+            m_batch.put("0123456789abcdef"[character >> 4]);
+            m_batch.put("0123456789abcdef"[character & 0xF]);
+            break;
+        }
+    }
+    m_batch.write(text.data() + plainBegin, static_cast<std::streamsize>(text.size() - plainBegin));
+}
+
+void LogJsonSink::appendFields(std::string_view format, std::string_view arguments)
+{
+    using LogBinaryFormat::ArgumentType;
+
+    std::string_view text;
+    std::string_view name;
+    uint32_t argumentIndex = 0;
+    m_fieldNames.clear();
+    for (; !arguments.empty() && LogBinaryFormat::readPlaceholder(format, text, name); ++argumentIndex)
+    {
+        LogBinaryFormat::Argument argument;
+        if (!LogBinaryFormat::readArgument(arguments, argument))
+        {
+            break;
+        }
+
+        char digits[16];
+        const std::string_view index(digits, std::to_chars(digits, digits + sizeof(digits), argumentIndex).ptr - digits);
+        if (name.empty())
+        {
+            m_fieldName.assign("arg").append(index);
+        }
+        else
+        {
+            m_fieldName.assign(name);
+        }
+        // JSON consumers keep only the last of equal keys
+        while (containsName(m_fieldNames, m_fieldName))
+        {
+            m_fieldName.append(1, '_').append(index);
+        }
+        m_fieldNames.append(m_fieldName).append(1, '\0');
+
+        m_batch.write(argumentIndex == 0 ? ",\"fields\":{\"" : ",\"", argumentIndex == 0 ? 12 : 2);
+        m_batch.write(m_fieldName.data(), static_cast<std::streamsize>(m_fieldName.size()));
+        m_batch.write("\":", 2);
+
+        switch (argument.type)
+        {
+        case ArgumentType::Bool:
+            m_batch << (argument.integer ? "true" : "false");
+            break;
+        case ArgumentType::Char:
+        {
+            const char character = static_cast<char>(argument.integer);
+            m_batch.put('"');
+            appendEscaped(std::string_view(&character, 1));
+            m_batch.put('"');
+            break;
+        }
+        case ArgumentType::Int64:
+            appendNumber(argument.integer);
+            break;
+        case ArgumentType::UInt64:
+            appendNumber(argument.unsignedInteger);
+            break;
+        case ArgumentType::Double:
+            // JSON has no NaN and infinities
+            if (argument.floating - argument.floating == 0.0)
+            {
+                appendNumber(argument.floating);
+            }
+            else
+            {
+                m_batch.write("null", 4);
+            }
+            break;
+        case ArgumentType::String:
+            m_batch.put('"');
+            appendEscaped(argument.text);
+            m_batch.put('"');
+            break;
+        case ArgumentType::Pointer:
+        {
+            char hexDigits[16];
+            for (int digit = 0; digit < 16; ++digit)
+            {
+                hexDigits[digit] = "0123456789abcdef"[(argument.unsignedInteger >> (60 - digit * 4)) & 0xF];
+            }
+            m_batch.write("\"0x", 3);
+            m_batch.write(hexDigits, sizeof(hexDigits));
+            m_batch.put('"');
+            break;
+        }
+        case ArgumentType::VulkanResult:
+        {
+            // the message has the name already, vk::to_string would allocate
+            appendNumber(argument.integer);
+            break;
+        }
+        }
+    }
+
+    if (argumentIndex > 0)
+    {
+        m_batch.put('}');
+    }
+}
+
+template<typename T>
+void LogJsonSink::appendNumber(T value)
+{
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_batch.write(digits, result.ptr - digits);
+}
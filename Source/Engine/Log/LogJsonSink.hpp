@@ -0,0 +1,48 @@
+/*
+ *  LogJsonSink.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ILogSink.hpp"
+#include "LogFormatStream.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+/*
+ * JSON lines for log shippers, one object per record:
+ *     {"timestamp":1634476296123456,"thread":1,"level":"Warning","category":"Renderer",
+ *      "message":"presentResult = SuboptimalKHR","fields":{"presentResult":1000001003}}
+ * timestamp is in microseconds since the Unix epoch, fields are the arguments of binary records
+ * keyed by the names of their placeholders ("{name}", or "argN" for "{}"). A key used already in the record
+ * gets the index of the argument as a suffix, "{size}{size}" becomes "size" and "size_1".
+ * Vulkan results are numbers in the fields, their names are in the message.
+ * Records are encoded into reused buffers, so after warm-up only vk::to_string in messages allocates.
+ */
+class LogJsonSink : public ILogSink
+{
+public:
+    explicit LogJsonSink(const std::filesystem::path& path);
+    ~LogJsonSink();
+
+    void write(const LogRecordHeader& header, std::string_view message) override;
+    void flush() override;
+
+private:
+    void appendEscaped(std::string_view text);
+    void appendFields(std::string_view format, std::string_view arguments);
+
+    template<typename T>
+    void appendNumber(T value);
+
+    std::ofstream m_file;
+    LogFormatStream m_batch;
+    LogFormatStream m_message; // text of a binary record before escaping
+    std::string m_fieldName;
+    std::string m_fieldNames; // the keys of the record so far, each one followed by '\0'
+
+    static constexpr std::size_t batchSizeLimit = 1024 * 1024;
+};
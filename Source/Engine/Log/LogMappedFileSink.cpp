@@ -0,0 +1,118 @@
+/*
+ *  LogMappedFileSink.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogMappedFileSink.hpp"
+#include <Engine/DebugUtils/DebugUtils.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if !defined(ENGINE_OS_WINDOWS)
+    #include <unistd.h>
+#endif
+
+LogMappedFileSink::LogMappedFileSink(const std::filesystem::path& path, std::size_t fileSize, uint32_t filesCount) :
+    m_directory(path.parent_path()),
+    m_name(path.stem().string()),
+    m_extension(path.extension().string()),
+    m_fileSize(std::max<std::size_t>(fileSize, 4096)),
+    m_filesCount(std::max(filesCount, 1u))
+{
+    openNextFile();
+}
+
+LogMappedFileSink::~LogMappedFileSink()
+{
+    m_file.close(m_offset);
+}
+
+void LogMappedFileSink::write(const LogRecordHeader& header, std::string_view message)
+{
+    m_record.clear();
+    m_formatter.format(m_record, header, message);
+
+    std::string_view line = m_record.view();
+    if (m_offset + line.size() > m_file.size() && line.size() <= m_file.size() && !openNextFile())
+    {
+        return;
+    }
+
+    // only a line longer than the whole file is continued in the next one
+    while (!line.empty() && m_file.isOpen())
+    {
+        if (m_offset == m_file.size() && !openNextFile())
+        {
+            return;
+        }
+
+        const std::size_t chunkSize = std::min(line.size(), m_file.size() - m_offset);
+        std::memcpy(m_file.data() + m_offset, line.data(), chunkSize);
+        m_offset += chunkSize;
+        line.remove_prefix(chunkSize);
+    }
+}
+
+void LogMappedFileSink::flush()
+{
+    // nothing to do, the written pages already belong to the kernel
+}
+
+void LogMappedFileSink::setDateTimeFormat(const Kompot::DateTimeFormat& format)
+{
+    m_formatter.setDateTimeFormat(format);
+}
+
+void LogMappedFileSink::writeSignalSafe(std::string_view line)
+{
+    // no rotation here, mapping a new file isn't async-signal-safe
+    if (m_file.isOpen())
+    {
+        const std::size_t size = std::min(line.size(), m_file.size() - m_offset);
+        std::memcpy(m_file.data() + m_offset, line.data(), size);
+        m_offset += size;
+    }
+}
+
+void LogMappedFileSink::writeCallstackSignalSafe(void* const* frames, int framesCount)
+{
+#if defined(ENGINE_OS_WINDOWS)
+    ILogSink::writeCallstackSignalSafe(frames, framesCount);
+#else
+    // the symbolizer writes to a descriptor only, the file one puts the lines to the pages the mapping shows
+    const int descriptor = m_file.getDescriptor();
+    if (!m_file.isOpen() || ::lseek(descriptor, static_cast<off_t>(m_offset), SEEK_SET) < 0)
+    {
+        return;
+    }
+    DebugUtils::writeCallstack(frames, framesCount, descriptor);
+
+    // a stack longer than the rest of the mapping grows the file, the process dies right after anyway
+    const off_t end = ::lseek(descriptor, 0, SEEK_CUR);
+    if (end > static_cast<off_t>(m_offset))
+    {
+        m_offset = std::min(static_cast<std::size_t>(end), m_file.size());
+    }
+#endif
+}
+
+bool LogMappedFileSink::openNextFile()
+{
+    m_file.close(m_offset);
+    m_offset = 0;
+
+    std::error_code error;
+    std::filesystem::remove(getFilePath(m_filesCount - 1), error);
+    for (uint32_t index = m_filesCount - 1; index > 0; --index)
+    {
+        std::filesystem::rename(getFilePath(index - 1), getFilePath(index), error);
+    }
+
+    return m_file.open(getFilePath(0), m_fileSize);
+}
+
+std::filesystem::path LogMappedFileSink::getFilePath(uint32_t index) const
+{
+    return m_directory / (m_name + '.' + std::to_string(index) + m_extension);
+}
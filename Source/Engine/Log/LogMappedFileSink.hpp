@@ -0,0 +1,57 @@
+/*
+ *  LogMappedFileSink.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ILogSink.hpp"
+#include "LogFormatStream.hpp"
+#include "LogTextFormatter.hpp"
+#include <Engine/Platform/MappedFile.hpp>
+#include <filesystem>
+#include <string>
+
+/*
+ * Text lines copied into a pre-sized memory-mapped file, writing a line doesn't make a syscall
+ * and the lines survive a crash of the process. For the path "log.txt" the current file is log.0.txt,
+ * when it is full it becomes log.1.txt and so on, the oldest of filesCount files is removed.
+ * Files of the previous run are rotated the same way on start.
+ */
+class LogMappedFileSink : public ILogSink
+{
+public:
+    LogMappedFileSink(const std::filesystem::path& path, std::size_t fileSize, uint32_t filesCount);
+    ~LogMappedFileSink();
+
+    void write(const LogRecordHeader& header, std::string_view message) override;
+    void flush() override;
+
+    void setDateTimeFormat(const Kompot::DateTimeFormat& format) override;
+
+    void writeSignalSafe(std::string_view line) override;
+    void writeCallstackSignalSafe(void* const* frames, int framesCount) override;
+
+    // false if the file couldn't be mapped, the sink drops everything then
+    bool isOpen() const
+    {
+        return m_file.isOpen();
+    }
+
+private:
+    bool openNextFile();
+    std::filesystem::path getFilePath(uint32_t index) const;
+
+    Kompot::Platform::MappedFile m_file;
+    std::size_t m_offset = 0;
+
+    std::filesystem::path m_directory;
+    std::string m_name;
+    std::string m_extension;
+    std::size_t m_fileSize;
+    uint32_t m_filesCount;
+
+    LogFormatStream m_record;
+    LogTextFormatter m_formatter;
+};
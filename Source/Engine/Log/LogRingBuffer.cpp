@@ -0,0 +1,44 @@
+/*
+ *  LogRingBuffer.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogRingBuffer.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+LogRingBuffer::LogRingBuffer(std::size_t capacity) : m_capacity(std::bit_ceil(std::max<std::size_t>(capacity, 64))), m_data(new char[m_capacity])
+{
+}
+
+bool LogRingBuffer::tryWrite(const void* header, std::size_t headerSize, const void* data, std::size_t size)
+{
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    const uint64_t tail = m_tail.load(std::memory_order_acquire);
+    if (m_capacity - static_cast<std::size_t>(head - tail) < headerSize + size)
+    {
+        return false;
+    }
+
+    copyIn(head, header, headerSize);
+    copyIn(head + headerSize, data, size);
+
+    m_head.store(head + headerSize + size, std::memory_order_release);
+    return true;
+}
+
+void LogRingBuffer::copyIn(uint64_t position, const void* data, std::size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    const auto* bytes            = static_cast<const char*>(data);
+    const std::size_t offset     = static_cast<std::size_t>(position) & (m_capacity - 1);
+    const std::size_t firstChunk = std::min(size, m_capacity - offset);
+    std::memcpy(m_data.get() + offset, bytes, firstChunk);
+    std::memcpy(m_data.get(), bytes + firstChunk, size - firstChunk);
+}
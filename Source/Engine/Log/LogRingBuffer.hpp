@@ -0,0 +1,84 @@
+/*
+ *  LogRingBuffer.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <EngineTypes.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/*
+ * Single producer / single consumer byte ring. The owning thread is the only producer,
+ * the log writer thread is the only consumer, so both sides work without locks.
+ * Writes are all-or-nothing: the consumer never sees a half written chunk.
+ */
+class LogRingBuffer
+{
+public:
+    explicit LogRingBuffer(std::size_t capacity);
+
+    LogRingBuffer(const LogRingBuffer&) = delete;
+    LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+    std::size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    // producer side, puts both parts as one chunk
+    bool tryWrite(const void* header, std::size_t headerSize, const void* data, std::size_t size);
+
+    // consumer side, calls consumer(const char* data, std::size_t size) for up to two contiguous spans
+    template<typename Consumer>
+    std::size_t consume(Consumer&& consumer)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        const auto available = static_cast<std::size_t>(head - tail);
+        if (available == 0)
+        {
+            return 0;
+        }
+
+        const std::size_t offset     = static_cast<std::size_t>(tail) & (m_capacity - 1);
+        const std::size_t firstChunk = std::min(available, m_capacity - offset);
+        consumer(m_data.get() + offset, firstChunk);
+        if (firstChunk < available)
+        {
+            consumer(m_data.get(), available - firstChunk);
+        }
+
+        m_tail.store(tail + available, std::memory_order_release);
+        return available;
+    }
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t usedSize() const
+    {
+        return static_cast<std::size_t>(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+
+    // set by the producer when it moves to a bigger ring (LogOverflowPolicy::Grow),
+    // after that this ring never receives new data
+    std::atomic<LogRingBuffer*> next = nullptr;
+
+private:
+    void copyIn(uint64_t position, const void* data, std::size_t size);
+
+    static constexpr std::size_t cacheLineSize = 64;
+
+    std::size_t m_capacity;
+    std::unique_ptr<char[]> m_data;
+
+    alignas(cacheLineSize) std::atomic<uint64_t> m_head = 0; // written by the producer
+    alignas(cacheLineSize) std::atomic<uint64_t> m_tail = 0; // written by the consumer
+};
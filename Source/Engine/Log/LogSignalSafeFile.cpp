@@ -0,0 +1,64 @@
+/*
+ *  LogSignalSafeFile.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogSignalSafeFile.hpp"
+
+#if defined(ENGINE_OS_WINDOWS)
+    #include <fcntl.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+LogSignalSafeFile::~LogSignalSafeFile()
+{
+    close();
+}
+
+bool LogSignalSafeFile::open(const std::filesystem::path& path)
+{
+    close();
+
+#if defined(ENGINE_OS_WINDOWS)
+    m_descriptor = ::_wopen(path.c_str(), _O_WRONLY | _O_APPEND | _O_BINARY);
+#else
+    m_descriptor = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+#endif
+    return m_descriptor >= 0;
+}
+
+void LogSignalSafeFile::close()
+{
+    if (m_descriptor < 0)
+    {
+        return;
+    }
+
+#if defined(ENGINE_OS_WINDOWS)
+    ::_close(m_descriptor);
+#else
+    ::close(m_descriptor);
+#endif
+    m_descriptor = -1;
+}
+
+void LogSignalSafeFile::write(int descriptor, std::string_view data)
+{
+    while (descriptor >= 0 && !data.empty())
+    {
+#if defined(ENGINE_OS_WINDOWS)
+        const auto written = ::_write(descriptor, data.data(), static_cast<unsigned int>(data.size()));
+#else
+        const auto written = ::write(descriptor, data.data(), data.size());
+#endif
+        if (written <= 0)
+        {
+            return;
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+}
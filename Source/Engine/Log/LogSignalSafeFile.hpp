@@ -0,0 +1,41 @@
+/*
+ *  LogSignalSafeFile.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <EngineDefines.hpp>
+#include <filesystem>
+#include <string_view>
+
+/*
+ * A second descriptor of a log file the sink writes through a stream, for the crash handler only.
+ * It's opened in the append mode, so the lines written on a crash go after everything the stream has flushed.
+ */
+class LogSignalSafeFile
+{
+public:
+    LogSignalSafeFile() = default;
+    ~LogSignalSafeFile();
+
+    LogSignalSafeFile(const LogSignalSafeFile&) = delete;
+    LogSignalSafeFile& operator=(const LogSignalSafeFile&) = delete;
+
+    // the file must exist already, returns false on failure
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    // -1 if the file isn't open
+    int getDescriptor() const
+    {
+        return m_descriptor;
+    }
+
+    // async-signal-safe, retries partial writes, gives up on errors
+    static void write(int descriptor, std::string_view data);
+
+private:
+    int m_descriptor = -1;
+};
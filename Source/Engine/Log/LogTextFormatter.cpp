@@ -0,0 +1,64 @@
+/*
+ *  LogTextFormatter.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogTextFormatter.hpp"
+#include "LogBinaryFormat.hpp"
+#include <chrono>
+
+void LogTextFormatter::format(LogFormatStream& output, const LogRecordHeader& header, std::string_view message) const
+{
+    if (header.flags & LogRecordTimestamped)
+    {
+        using Clock          = std::chrono::system_clock;
+        const auto timePoint = Clock::time_point(Clock::duration(header.timestamp));
+
+        output << '[';
+        m_dateTimeFormatter.printTime(output, timePoint);
+        output << ']';
+    }
+
+    if (header.flags & LogRecordLeveled)
+    {
+        output << '[' << logLevelNames[static_cast<std::size_t>(header.level)] << "][" << logCategoryNames[static_cast<std::size_t>(header.category)]
+               << ']';
+    }
+
+    if (header.flags & LogRecordBinary)
+    {
+        const char* format = LogBinaryFormat::FormatRegistry::get().getFormat(header.formatId);
+        output << ' ';
+        LogBinaryFormat::formatMessage(output, format ? format : "<unknown format>", message);
+        output << '\n';
+    }
+    else
+    {
+        output.write(message.data(), static_cast<std::streamsize>(message.size()));
+    }
+}
+
+void LogTextFormatter::formatSignalSafe(LogFixedBuffer& output, const LogRecordHeader& header, std::string_view message)
+{
+    if (header.flags & LogRecordLeveled)
+    {
+        output.append('[');
+        output.append(logLevelNames[static_cast<std::size_t>(header.level)]);
+        output.append("][");
+        output.append(logCategoryNames[static_cast<std::size_t>(header.category)]);
+        output.append(']');
+    }
+
+    if (header.flags & LogRecordBinary)
+    {
+        const char* format = LogBinaryFormat::FormatRegistry::get().getFormat(header.formatId);
+        output.append(' ');
+        LogBinaryFormat::formatMessage(output, format ? format : "<unknown format>", message);
+        output.append('\n');
+    }
+    else
+    {
+        output.append(message);
+    }
+}
@@ -0,0 +1,30 @@
+/*
+ *  LogTextFormatter.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "LogFormatStream.hpp"
+#include "LogTypes.hpp"
+#include <Misc/DateTimeFormatter.hpp>
+#include <string_view>
+
+// turns a record into a "[time][Level][Category] message" line, shared by the text sinks
+class LogTextFormatter
+{
+public:
+    void format(LogFormatStream& output, const LogRecordHeader& header, std::string_view message) const;
+
+    // async-signal-safe: the same line without the timestamp, localtime isn't safe to call
+    static void formatSignalSafe(LogFixedBuffer& output, const LogRecordHeader& header, std::string_view message);
+
+    void setDateTimeFormat(const Kompot::DateTimeFormat& format)
+    {
+        m_dateTimeFormatter.setFormat(format);
+    }
+
+private:
+    Kompot::DateTimeFormatter m_dateTimeFormatter;
+};
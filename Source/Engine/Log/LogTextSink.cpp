@@ -0,0 +1,63 @@
+/*
+ *  LogTextSink.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogTextSink.hpp"
+#include "LogSignalSafeFile.hpp"
+#include <Engine/DebugUtils/DebugUtils.hpp>
+
+LogTextSink::LogTextSink(std::ostream& output, int signalSafeDescriptor) : m_output(output), m_signalSafeDescriptor(signalSafeDescriptor)
+{
+}
+
+void LogTextSink::write(const LogRecordHeader& header, std::string_view message)
+{
+    m_formatter.format(m_batch, header, message);
+
+    if (m_batch.view().size() > batchSizeLimit)
+    {
+        flush();
+    }
+}
+
+void LogTextSink::flush()
+{
+    const auto batch = m_batch.view();
+    if (batch.empty())
+    {
+        return;
+    }
+
+    m_output.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    m_output.flush();
+    m_batch.clear();
+}
+
+void LogTextSink::setDateTimeFormat(const Kompot::DateTimeFormat& format)
+{
+    m_formatter.setDateTimeFormat(format);
+}
+
+void LogTextSink::flushSignalSafe()
+{
+    if (m_signalSafeDescriptor >= 0)
+    {
+        LogSignalSafeFile::write(m_signalSafeDescriptor, m_batch.view());
+        m_batch.clear();
+    }
+}
+
+void LogTextSink::writeSignalSafe(std::string_view line)
+{
+    LogSignalSafeFile::write(m_signalSafeDescriptor, line);
+}
+
+void LogTextSink::writeCallstackSignalSafe(void* const* frames, int framesCount)
+{
+    if (m_signalSafeDescriptor >= 0)
+    {
+        DebugUtils::writeCallstack(frames, framesCount, m_signalSafeDescriptor);
+    }
+}
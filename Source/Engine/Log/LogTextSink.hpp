@@ -0,0 +1,37 @@
+/*
+ *  LogTextSink.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ILogSink.hpp"
+#include "LogFormatStream.hpp"
+#include "LogTextFormatter.hpp"
+#include <ostream>
+
+// human readable "[time] message" lines, collected into a batch and put to the stream on flush()
+class LogTextSink : public ILogSink
+{
+public:
+    // signalSafeDescriptor is a file descriptor of the same output for the crash handler, -1 if there is none
+    explicit LogTextSink(std::ostream& output, int signalSafeDescriptor = -1);
+
+    void write(const LogRecordHeader& header, std::string_view message) override;
+    void flush() override;
+
+    void setDateTimeFormat(const Kompot::DateTimeFormat& format) override;
+
+    void flushSignalSafe() override;
+    void writeSignalSafe(std::string_view line) override;
+    void writeCallstackSignalSafe(void* const* frames, int framesCount) override;
+
+private:
+    std::ostream& m_output;
+    int m_signalSafeDescriptor;
+    LogFormatStream m_batch;
+    LogTextFormatter m_formatter;
+
+    static constexpr std::size_t batchSizeLimit = 1024 * 1024;
+};
@@ -0,0 +1,115 @@
+/*
+ *  LogTypes.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <EngineDefines.hpp>
+#include <EngineTypes.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+
+enum class LogLevel : uint8_t
+{
+    Verbose,
+    Info,
+    Warning,
+    Error,
+    Fatal,
+
+    Count
+};
+
+enum class LogCategory : uint8_t
+{
+    General,
+    Renderer,
+    Shader,
+    Window,
+    Config,
+
+    Count
+};
+
+constexpr std::array<std::string_view, static_cast<std::size_t>(LogLevel::Count)> logLevelNames = {"Verbose", "Info", "Warning", "Error", "Fatal"};
+
+constexpr std::array<std::string_view, static_cast<std::size_t>(LogCategory::Count)> logCategoryNames =
+    {"General", "Renderer", "Shader", "Window", "Config"};
+
+// messages below this level are removed at compile time, override with -DENGINE_LOG_MIN_LEVEL=<LogLevel value>
+#if defined(ENGINE_LOG_MIN_LEVEL)
+constexpr LogLevel compiledMinimumLogLevel = static_cast<LogLevel>(ENGINE_LOG_MIN_LEVEL);
+#elif defined(ENGINE_DEBUG)
+constexpr LogLevel compiledMinimumLogLevel = LogLevel::Verbose;
+#else
+constexpr LogLevel compiledMinimumLogLevel = LogLevel::Info;
+#endif
+
+enum class LogMode : uint8_t
+{
+    Synchronous, // every write goes to the file under the lock, flushed immediately
+    Asynchronous // producers write into per-thread rings, the writer thread drains them
+};
+
+enum class LogOverflowPolicy : uint8_t
+{
+    Drop,  // the message is discarded and counted, the writer reports the count later
+    Block, // the producer waits until the writer frees enough space
+    Grow   // the producer allocates a bigger ring and keeps going
+};
+
+enum class LogOutputFormat : uint8_t
+{
+    Text,       // log.txt, binary records are formatted by the writer thread
+    Binary,     // log.bin, binary records are stored as is and formatted offline by KompotLogDecoder
+    MappedText  // log.0.txt, log.1.txt, ..., same lines as Text copied into memory-mapped files rotated by size
+};
+
+struct LogConfig
+{
+    LogMode mode                     = LogMode::Synchronous;
+    LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Grow;
+    LogOutputFormat outputFormat     = LogOutputFormat::MappedText;
+
+    // initial size of each per-thread ring, rounded up to a power of two
+    std::size_t threadBufferSize = 64 * 1024;
+
+    // MappedText: size of each file and how many of them are kept, the current one included
+    std::size_t logFileSize = 16 * 1024 * 1024;
+    uint32_t logFilesCount  = 4;
+
+    // also write log.jsonl, one JSON object per record, for log shippers
+    bool writeJsonLines = false;
+
+    // how often the writer thread wakes up if nobody pokes it
+    std::chrono::milliseconds flushInterval = 20ms;
+
+    // runtime filter for all categories, see also Log::setLevel
+    LogLevel minimumLevel = LogLevel::Info;
+};
+
+enum LogRecordFlags : uint32_t
+{
+    LogRecordNoFlags          = 0,
+    LogRecordTimestamped      = 1 << 0, // sinks put the formatted timestamp in front of the message
+    LogRecordBinary           = 1 << 1, // the message is encoded arguments of the format formatId
+    LogRecordFormatDefinition = 1 << 2, // only in log.bin: the message is the text of the format formatId
+    LogRecordLeveled          = 1 << 3  // level and category are set, sinks print them after the timestamp
+};
+
+// precedes every message in the rings and in log.bin, the message follows right after it
+struct LogRecordHeader
+{
+    uint32_t size        = 0;
+    uint32_t flags       = LogRecordNoFlags;
+    int64_t timestamp    = 0; // std::chrono::system_clock ticks since epoch
+    uint32_t formatId    = 0;
+    LogLevel level       = LogLevel::Info;
+    LogCategory category = LogCategory::General;
+    uint16_t threadIndex = 0; // 1, 2, ... in the order the threads logged first, 0 for the log's own records
+};
+static_assert(sizeof(LogRecordHeader) == 24, "LogRecordHeader is a part of the log.bin format");
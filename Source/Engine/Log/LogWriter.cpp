@@ -0,0 +1,426 @@
+/*
+ *  LogWriter.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "LogWriter.hpp"
+#include "LogCallSite.hpp"
+#include "LogTextFormatter.hpp"
+#include <EngineDefines.hpp>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace
+{
+struct ThreadBufferHandle
+{
+    std::shared_ptr<LogThreadBuffer> buffer;
+
+    ~ThreadBufferHandle()
+    {
+        if (buffer)
+        {
+            // the writer drains what is left and releases the buffer
+            buffer->isOrphaned.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadBufferHandle threadBufferHandle;
+
+// reassembles records from the ring spans into fixed storage, longer messages are cut
+class SignalSafeRecordParser
+{
+public:
+    explicit SignalSafeRecordParser(LogWriter::Sinks& sinks) : m_sinks(sinks)
+    {
+    }
+
+    void parse(const char* data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            std::size_t consumedSize = 0;
+            if (m_headerSize < sizeof(LogRecordHeader))
+            {
+                consumedSize = std::min(size, sizeof(LogRecordHeader) - m_headerSize);
+                std::memcpy(reinterpret_cast<char*>(&m_header) + m_headerSize, data, consumedSize);
+                m_headerSize += consumedSize;
+            }
+            else
+            {
+                consumedSize = std::min<std::size_t>(size, m_header.size - m_messageSize);
+                if (m_messageSize < messageCapacity)
+                {
+                    std::memcpy(m_message + m_messageSize, data, std::min(consumedSize, messageCapacity - m_messageSize));
+                }
+                m_messageSize += consumedSize;
+            }
+            data += consumedSize;
+            size -= consumedSize;
+
+            if (m_headerSize == sizeof(LogRecordHeader) && m_messageSize == m_header.size)
+            {
+                dispatch();
+            }
+        }
+    }
+
+private:
+    void dispatch()
+    {
+        const std::string_view message(m_message, std::min<std::size_t>(m_messageSize, messageCapacity));
+
+        // the last character is kept for the line end
+        LogFixedBuffer line(m_line, lineCapacity - 1);
+        LogTextFormatter::formatSignalSafe(line, m_header, message);
+        std::size_t lineSize = line.view().size();
+        if (lineSize == 0 || m_line[lineSize - 1] != '\n')
+        {
+            m_line[lineSize++] = '\n';
+        }
+
+        for (auto& sink : m_sinks)
+        {
+            sink->writeSignalSafe(std::string_view(m_line, lineSize));
+        }
+        m_headerSize  = 0;
+        m_messageSize = 0;
+    }
+
+    static constexpr std::size_t messageCapacity = 4096;
+    static constexpr std::size_t lineCapacity    = 8192;
+
+    LogWriter::Sinks& m_sinks;
+    LogRecordHeader m_header;
+    std::size_t m_headerSize  = 0;
+    std::size_t m_messageSize = 0;
+    char m_message[messageCapacity];
+    char m_line[lineCapacity];
+};
+
+} // namespace
+
+LogThreadBuffer::LogThreadBuffer(std::size_t capacity) : producerRing(new LogRingBuffer(capacity)), consumerRing(producerRing)
+{
+}
+
+LogThreadBuffer::~LogThreadBuffer()
+{
+    while (consumerRing)
+    {
+        LogRingBuffer* next = consumerRing->next.load(std::memory_order_acquire);
+        delete consumerRing;
+        consumerRing = next;
+    }
+}
+
+LogWriter::LogWriter(Sinks& sinks, std::mutex& sinksMutex) : m_sinks(sinks), m_sinksMutex(sinksMutex)
+{
+}
+
+LogWriter::~LogWriter()
+{
+    stop();
+}
+
+void LogWriter::start(const LogConfig& config)
+{
+    if (isRunning())
+    {
+        return;
+    }
+
+    m_config = config;
+    m_isRunning.store(true, std::memory_order_release);
+    m_thread = std::thread(&LogWriter::run, this);
+}
+
+void LogWriter::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+
+    m_isRunning.store(false, std::memory_order_release);
+    wake();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void LogWriter::wake()
+{
+    m_wakeRequested.store(true, std::memory_order_release);
+    m_wakeCondition.notify_one();
+}
+
+void LogWriter::flush()
+{
+    if (!isRunning() || std::this_thread::get_id() == m_thread.get_id())
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> wakeLock(m_wakeMutex);
+    const uint64_t awaitedDrain = m_startedDrainsCount + 1;
+    m_wakeRequested.store(true, std::memory_order_release);
+    m_wakeCondition.notify_one();
+    m_drainCondition.wait(wakeLock, [this, awaitedDrain]() {
+        return m_completedDrainsCount >= awaitedDrain || !isRunning();
+    });
+}
+
+void LogWriter::drainSignalSafe()
+{
+    // static, the alternate signal stack is small
+    static SignalSafeRecordParser parser(m_sinks);
+    const auto consumer = [](const char* data, std::size_t size) {
+        parser.parse(data, size);
+    };
+
+    const auto drainThreadBuffers = [&consumer](std::vector<std::shared_ptr<LogThreadBuffer>>& threadBuffers) {
+        for (auto& threadBuffer : threadBuffers)
+        {
+            for (LogRingBuffer* ring = threadBuffer->consumerRing; ring; ring = ring->next.load(std::memory_order_acquire))
+            {
+                ring->consume(consumer);
+            }
+        }
+    };
+    drainThreadBuffers(m_threadBuffers);
+    drainThreadBuffers(m_pendingThreadBuffers);
+}
+
+LogThreadBuffer& LogWriter::getThreadBuffer()
+{
+    if (!threadBufferHandle.buffer)
+    {
+        threadBufferHandle.buffer = std::make_shared<LogThreadBuffer>(m_config.threadBufferSize);
+
+        std::lock_guard<std::mutex> scopeLock(m_registrationMutex);
+        m_pendingThreadBuffers.push_back(threadBufferHandle.buffer);
+    }
+    return *threadBufferHandle.buffer;
+}
+
+void LogWriter::write(const LogRecordHeader& header, std::string_view message)
+{
+    LogThreadBuffer& threadBuffer = getThreadBuffer();
+    LogRingBuffer* ring           = threadBuffer.producerRing;
+    const std::size_t size        = sizeof(LogRecordHeader) + message.size();
+
+    if (!ring->tryWrite(&header, sizeof(header), message.data(), message.size()))
+    {
+        switch (m_config.overflowPolicy)
+        {
+        case LogOverflowPolicy::Drop:
+        {
+            threadBuffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+            wake();
+            return;
+        }
+        case LogOverflowPolicy::Block:
+        {
+            if (size > ring->capacity())
+            {
+                // would never fit, waiting is pointless
+                threadBuffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            while (!ring->tryWrite(&header, sizeof(header), message.data(), message.size()))
+            {
+                wake();
+                std::this_thread::yield();
+            }
+            break;
+        }
+        case LogOverflowPolicy::Grow:
+        {
+            if (!writeGrowing(threadBuffer, header, message))
+            {
+                threadBuffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            break;
+        }
+        default:
+            breakPoint("Unknown enum value");
+            break;
+        }
+    }
+
+    // the writer sleeps most of the time, poke it only when the ring is getting full
+    if (threadBuffer.producerRing->usedSize() > threadBuffer.producerRing->capacity() / 2)
+    {
+        wake();
+    }
+}
+
+bool LogWriter::writeGrowing(LogThreadBuffer& threadBuffer, const LogRecordHeader& header, std::string_view message)
+{
+    LogRingBuffer* currentRing = threadBuffer.producerRing;
+    auto* grownRing            = new LogRingBuffer(std::max(currentRing->capacity() * 2, sizeof(header) + message.size()));
+
+    const bool result = grownRing->tryWrite(&header, sizeof(header), message.data(), message.size());
+
+    // since this moment the writer drains the old ring to the end and then switches to the new one
+    currentRing->next.store(grownRing, std::memory_order_release);
+    threadBuffer.producerRing = grownRing;
+    wake();
+
+    return result;
+}
+
+void LogWriter::run()
+{
+    std::unique_lock<std::mutex> wakeLock(m_wakeMutex);
+    while (isRunning())
+    {
+        m_wakeCondition.wait_for(wakeLock, m_config.flushInterval, [this]() {
+            return m_wakeRequested.load(std::memory_order_acquire);
+        });
+        m_wakeRequested.store(false, std::memory_order_release);
+        const uint64_t drainNumber = ++m_startedDrainsCount;
+
+        wakeLock.unlock();
+        drain();
+        wakeLock.lock();
+
+        m_completedDrainsCount = drainNumber;
+        m_drainCondition.notify_all();
+    }
+    wakeLock.unlock();
+
+    // whatever was written before stop()
+    drain();
+
+    // under the lock, so a flush() which has just seen isRunning() doesn't miss the notification
+    wakeLock.lock();
+    m_drainCondition.notify_all();
+}
+
+void LogWriter::drain()
+{
+    {
+        std::lock_guard<std::mutex> scopeLock(m_registrationMutex);
+        m_threadBuffers.insert(m_threadBuffers.end(), m_pendingThreadBuffers.begin(), m_pendingThreadBuffers.end());
+        m_pendingThreadBuffers.clear();
+    }
+
+    std::lock_guard<std::mutex> sinksLock(m_sinksMutex);
+
+    for (auto iterator = m_threadBuffers.begin(); iterator != m_threadBuffers.end();)
+    {
+        LogThreadBuffer& threadBuffer = **iterator;
+
+        // must be read before draining, so nothing written before the thread's exit is lost
+        const bool isOrphaned = threadBuffer.isOrphaned.load(std::memory_order_acquire);
+
+        drainThreadBuffer(threadBuffer);
+        m_droppedCount += threadBuffer.droppedCount.exchange(0, std::memory_order_relaxed);
+
+        iterator = isOrphaned ? m_threadBuffers.erase(iterator) : std::next(iterator);
+    }
+
+    if (m_droppedCount > 0)
+    {
+        const std::string droppedMessage = " [Log] " + std::to_string(m_droppedCount) + " messages dropped, the log buffer was full\n";
+
+        LogRecordHeader header{};
+        header.size      = static_cast<uint32_t>(droppedMessage.size());
+        header.flags     = LogRecordTimestamped;
+        header.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+        for (auto& sink : m_sinks)
+        {
+            sink->write(header, droppedMessage);
+        }
+        m_droppedCount = 0;
+    }
+    writeCallSiteReports(false);
+
+    for (auto& sink : m_sinks)
+    {
+        sink->flush();
+    }
+}
+
+void LogWriter::writeCallSiteReports(bool force)
+{
+    // counts left after a storm has ended, while it goes on the call sites commit the reports themselves
+    if (!LogCallSite::hasPendingReports())
+    {
+        return;
+    }
+
+    const int64_t timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+    for (LogCallSite* callSite = LogCallSite::getFirst(); callSite; callSite = callSite->getNext())
+    {
+        if (!callSite->takeReport(timestamp, force, m_reportStream))
+        {
+            continue;
+        }
+
+        LogRecordHeader header{};
+        header.size      = static_cast<uint32_t>(m_reportStream.size());
+        header.flags     = LogRecordTimestamped | LogRecordLeveled;
+        header.timestamp = timestamp;
+        header.level     = callSite->getLevel();
+        header.category  = callSite->getCategory();
+        for (auto& sink : m_sinks)
+        {
+            sink->write(header, m_reportStream.view());
+        }
+        m_reportStream.clear();
+    }
+}
+
+void LogWriter::drainThreadBuffer(LogThreadBuffer& threadBuffer)
+{
+    const auto consumer = [this](const char* data, std::size_t size) {
+        m_records.insert(m_records.end(), data, data + size);
+    };
+
+    for (;;)
+    {
+        LogRingBuffer* ring = threadBuffer.consumerRing;
+        ring->consume(consumer);
+
+        LogRingBuffer* nextRing = ring->next.load(std::memory_order_acquire);
+        if (!nextRing)
+        {
+            break;
+        }
+
+        // the producer has switched to a bigger ring, take the rest of this one and release it
+        ring->consume(consumer);
+        threadBuffer.consumerRing = nextRing;
+        delete ring;
+    }
+
+    dispatchRecords();
+}
+
+void LogWriter::dispatchRecords()
+{
+    // producers write whole records only, so the buffer always ends on a record boundary
+    std::size_t offset = 0;
+    while (offset + sizeof(LogRecordHeader) <= m_records.size())
+    {
+        LogRecordHeader header;
+        std::memcpy(&header, m_records.data() + offset, sizeof(header));
+        offset += sizeof(header);
+
+        const std::string_view message(m_records.data() + offset, header.size);
+        offset += header.size;
+
+        for (auto& sink : m_sinks)
+        {
+            sink->write(header, message);
+        }
+    }
+    m_records.clear();
+}
@@ -0,0 +1,102 @@
+/*
+ *  LogWriter.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include "ILogSink.hpp"
+#include "LogFormatStream.hpp"
+#include "LogRingBuffer.hpp"
+#include "LogTypes.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct LogThreadBuffer
+{
+    explicit LogThreadBuffer(std::size_t capacity);
+    ~LogThreadBuffer();
+
+    LogRingBuffer* producerRing; // touched only by the owning thread
+    LogRingBuffer* consumerRing; // touched only by the writer thread
+
+    std::atomic_bool isOrphaned        = false; // the owning thread has exited
+    std::atomic<uint64_t> droppedCount = 0;
+};
+
+/*
+ * Background writer of the asynchronous log mode. Every producing thread gets its own
+ * LogThreadBuffer on the first write, the writer thread periodically drains all of them
+ * and hands the records to the sinks, which put the whole batch out with a single write.
+ */
+class LogWriter
+{
+public:
+    using Sinks = std::vector<std::unique_ptr<ILogSink>>;
+
+    LogWriter(Sinks& sinks, std::mutex& sinksMutex);
+    ~LogWriter();
+
+    void start(const LogConfig& config);
+    void stop();
+
+    bool isRunning() const
+    {
+        return m_isRunning.load(std::memory_order_acquire);
+    }
+
+    // called by producers, never touches the sinks
+    void write(const LogRecordHeader& header, std::string_view message);
+
+    void wake();
+
+    // blocks until everything written before the call reaches the sinks
+    void flush();
+
+    // crash handler only: hands the records left in the rings to ILogSink::writeSignalSafe,
+    // doesn't lock, so it races with the writer thread if that one is still alive
+    void drainSignalSafe();
+
+    // the counts of LogCallSite, under the sinks lock from the writer thread or while it isn't running,
+    // without force only the ones older than a second
+    void writeCallSiteReports(bool force);
+
+private:
+    LogThreadBuffer& getThreadBuffer();
+    bool writeGrowing(LogThreadBuffer& threadBuffer, const LogRecordHeader& header, std::string_view message);
+
+    void run();
+    void drain();
+    void drainThreadBuffer(LogThreadBuffer& threadBuffer);
+    void dispatchRecords();
+
+    Sinks& m_sinks;
+    std::mutex& m_sinksMutex;
+    LogConfig m_config;
+
+    std::thread m_thread;
+    std::atomic_bool m_isRunning     = false;
+    std::atomic_bool m_wakeRequested = false;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+
+    // guarded by m_wakeMutex, flush() waits for a drain which started after it was called
+    uint64_t m_startedDrainsCount   = 0;
+    uint64_t m_completedDrainsCount = 0;
+    std::condition_variable m_drainCondition;
+
+    // new threads register here, the writer moves them into m_threadBuffers
+    std::mutex m_registrationMutex;
+    std::vector<std::shared_ptr<LogThreadBuffer>> m_pendingThreadBuffers;
+
+    std::vector<std::shared_ptr<LogThreadBuffer>> m_threadBuffers;
+    std::vector<char> m_records; // raw content of one thread buffer
+    uint64_t m_droppedCount = 0;
+    LogFormatStream m_reportStream;
+};
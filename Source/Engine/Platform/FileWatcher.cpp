@@ -0,0 +1,156 @@
+/*
+ *  FileWatcher.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "FileWatcher.hpp"
+
+#if defined(ENGINE_OS_LINUX)
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+using namespace Kompot::Platform;
+
+namespace fs = std::filesystem;
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+#if defined(ENGINE_OS_LINUX)
+
+bool FileWatcher::start(const fs::path& directory, Callback callback)
+{
+    stop();
+
+    if (std::error_code error; !fs::is_directory(directory, error))
+    {
+        return false;
+    }
+
+    mInotifyDescriptor = ::inotify_init1(IN_CLOEXEC);
+    mStopDescriptor    = ::eventfd(0, EFD_CLOEXEC);
+    if (mInotifyDescriptor < 0 || mStopDescriptor < 0)
+    {
+        stop();
+        return false;
+    }
+
+    addWatch(directory);
+    for (std::error_code error; const auto& entry : fs::recursive_directory_iterator(directory, error))
+    {
+        if (entry.is_directory(error))
+        {
+            addWatch(entry.path());
+        }
+    }
+    if (mWatchedDirectories.empty())
+    {
+        stop();
+        return false;
+    }
+
+    mCallback = std::move(callback);
+    mThread   = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (mThread.joinable())
+    {
+        const uint64_t stopValue = 1;
+        [[maybe_unused]] const auto result = ::write(mStopDescriptor, &stopValue, sizeof(stopValue));
+        mThread.join();
+    }
+
+    if (mInotifyDescriptor >= 0)
+    {
+        ::close(mInotifyDescriptor);
+        mInotifyDescriptor = -1;
+    }
+    if (mStopDescriptor >= 0)
+    {
+        ::close(mStopDescriptor);
+        mStopDescriptor = -1;
+    }
+    mWatchedDirectories.clear();
+    mCallback = nullptr;
+}
+
+void FileWatcher::addWatch(const fs::path& directory)
+{
+    // editors either rewrite the file or write a new one and move it over the old
+    constexpr uint32_t eventsMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+    if (const int watchDescriptor = ::inotify_add_watch(mInotifyDescriptor, directory.c_str(), eventsMask); watchDescriptor >= 0)
+    {
+        mWatchedDirectories[watchDescriptor] = directory;
+    }
+}
+
+void FileWatcher::run()
+{
+    alignas(inotify_event) char buffer[4096];
+
+    pollfd descriptors[2] = {{mInotifyDescriptor, POLLIN, 0}, {mStopDescriptor, POLLIN, 0}};
+    for (;;)
+    {
+        if (::poll(descriptors, 2, -1) < 0 || (descriptors[1].revents & POLLIN))
+        {
+            break;
+        }
+
+        const auto readSize = ::read(mInotifyDescriptor, buffer, sizeof(buffer));
+        if (readSize <= 0)
+        {
+            continue;
+        }
+
+        for (ssize_t offset = 0; offset < readSize;)
+        {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            const auto directory = mWatchedDirectories.find(event->wd);
+            if (event->len == 0 || directory == mWatchedDirectories.end())
+            {
+                continue;
+            }
+
+            const auto path = directory->second / event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    addWatch(path);
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                mCallback(path);
+            }
+        }
+    }
+}
+
+#else
+
+bool FileWatcher::start(const fs::path&, Callback)
+{
+    return false;
+}
+
+void FileWatcher::stop()
+{
+}
+
+void FileWatcher::run()
+{
+}
+
+#endif
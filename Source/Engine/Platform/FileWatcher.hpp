@@ -0,0 +1,57 @@
+/*
+ *  FileWatcher.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <EngineTypes.hpp>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+namespace Kompot::Platform
+{
+/*
+ * Watches a directory and its subdirectories on a background thread and reports every file
+ * written or moved into them. Implemented with inotify, on other platforms start() fails.
+ */
+class FileWatcher
+{
+public:
+    using Callback = std::function<void(const std::filesystem::path&)>;
+
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // the callback is called on the watcher thread, returns false if the directory can't be watched
+    bool start(const std::filesystem::path& directory, Callback callback);
+
+    void stop();
+
+    bool isRunning() const
+    {
+        return mThread.joinable();
+    }
+
+private:
+    void run();
+
+    Callback mCallback;
+    std::thread mThread;
+
+#if defined(ENGINE_OS_LINUX)
+    void addWatch(const std::filesystem::path& directory);
+
+    int mInotifyDescriptor = -1;
+    int mStopDescriptor    = -1; // eventfd, wakes the thread up to exit
+    std::unordered_map<int, std::filesystem::path> mWatchedDirectories;
+#endif
+};
+
+} // namespace Kompot::Platform
@@ -0,0 +1,210 @@
+/*
+ *  MappedFile.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include "MappedFile.hpp"
+
+#if defined(ENGINE_OS_WINDOWS)
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace Kompot::Platform;
+
+MappedFile::~MappedFile()
+{
+    close(mSize);
+}
+
+#if defined(ENGINE_OS_WINDOWS)
+
+bool MappedFile::open(const std::filesystem::path& path, std::size_t size)
+{
+    close(mSize);
+
+    const HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER mappingSize;
+    mappingSize.QuadPart = static_cast<LONGLONG>(size);
+    const HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+    if (!mapping)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    void* data = ::MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!data)
+    {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    mFileHandle    = file;
+    mMappingHandle = mapping;
+    mData          = static_cast<char*>(data);
+    mSize          = size;
+    mIsReadOnly    = false;
+    return true;
+}
+
+bool MappedFile::openForReading(const std::filesystem::path& path)
+{
+    close(mSize);
+
+    const HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    const HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    mFileHandle    = file;
+    mMappingHandle = mapping;
+    mData          = static_cast<char*>(data);
+    mSize          = static_cast<std::size_t>(fileSize.QuadPart);
+    mIsReadOnly    = true;
+    return true;
+}
+
+void MappedFile::close(std::size_t usedSize)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    ::UnmapViewOfFile(mData);
+    ::CloseHandle(mMappingHandle);
+
+    if (!mIsReadOnly)
+    {
+        LARGE_INTEGER fileSize;
+        fileSize.QuadPart = static_cast<LONGLONG>(usedSize);
+        ::SetFilePointerEx(mFileHandle, fileSize, nullptr, FILE_BEGIN);
+        ::SetEndOfFile(mFileHandle);
+    }
+    ::CloseHandle(mFileHandle);
+
+    mFileHandle    = nullptr;
+    mMappingHandle = nullptr;
+    mData          = nullptr;
+    mSize          = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path, std::size_t size)
+{
+    close(mSize);
+
+    const int fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    if (::ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    mFileDescriptor = fileDescriptor;
+    mData           = static_cast<char*>(data);
+    mSize           = size;
+    mIsReadOnly     = false;
+    return true;
+}
+
+bool MappedFile::openForReading(const std::filesystem::path& path)
+{
+    close(mSize);
+
+    const int fileDescriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStatus;
+    if (::fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    const auto size = static_cast<std::size_t>(fileStatus.st_size);
+    void* data      = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        ::close(fileDescriptor);
+        return false;
+    }
+
+    mFileDescriptor = fileDescriptor;
+    mData           = static_cast<char*>(data);
+    mSize           = size;
+    mIsReadOnly     = true;
+    return true;
+}
+
+void MappedFile::close(std::size_t usedSize)
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    ::munmap(mData, mSize);
+    if (!mIsReadOnly)
+    {
+        [[maybe_unused]] const int result = ::ftruncate(mFileDescriptor, static_cast<off_t>(usedSize));
+    }
+    ::close(mFileDescriptor);
+
+    mFileDescriptor = -1;
+    mData           = nullptr;
+    mSize           = 0;
+}
+
+#endif
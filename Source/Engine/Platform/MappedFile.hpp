@@ -0,0 +1,79 @@
+/*
+ *  MappedFile.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <EngineTypes.hpp>
+#include <filesystem>
+
+namespace Kompot::Platform
+{
+/*
+ * A file mapped into memory for writing. Pages belong to the kernel, so everything memcpy'ed
+ * into data() reaches the file even if the process crashes right after.
+ * openForReading() maps an existing file read-only instead, writing to data() then crashes.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // creates or truncates the file and maps it with the size, returns false on failure
+    bool open(const std::filesystem::path& path, std::size_t size);
+
+    // maps the whole existing file, returns false on failure or if the file is empty
+    bool openForReading(const std::filesystem::path& path);
+
+    // unmaps the file and cuts it to usedSize, so the unused tail of zeros doesn't stay on disk,
+    // files opened for reading are left as they are
+    void close(std::size_t usedSize);
+
+    void close()
+    {
+        close(mSize);
+    }
+
+    bool isOpen() const
+    {
+        return mData != nullptr;
+    }
+
+    char* data() const
+    {
+        return mData;
+    }
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+#if !defined(ENGINE_OS_WINDOWS)
+    // what is written through it shows up in the mapping, for the APIs which put their output to a descriptor only
+    int getDescriptor() const
+    {
+        return mFileDescriptor;
+    }
+#endif
+
+private:
+    char* mData       = nullptr;
+    std::size_t mSize = 0;
+    bool mIsReadOnly  = false;
+
+#if defined(ENGINE_OS_WINDOWS)
+    void* mFileHandle    = nullptr;
+    void* mMappingHandle = nullptr;
+#else
+    int mFileDescriptor = -1;
+#endif
+};
+
+} // namespace Kompot::Platform
@@ -36,7 +36,7 @@ static const char* ENGINE_NAME           = "KompotEngine";
 #define checkVulkanSuccess(expression) \
     if (const auto result = ((expression)); result != vk::Result::eSuccess)  \
     {                     \
-        Log::getInstance() << "Expression \""#expression"\" returns " << vk::to_string(result) << std::endl; \
+        ENGINE_LOG(Error, Renderer) << "Expression \""#expression"\" returns " << vk::to_string(result); \
         debugBreak();     \
     }
 #define checkNotNull(expression) check(((expression)) != nullptr)
@@ -13,10 +13,32 @@
 #include <iomanip>
 #include <ostream>
 #include <vector>
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <limits>
 
 namespace Kompot
 {
+// the text of a format up to seconds, the milliseconds are written into it at subsecondFields
+struct DateTimeCache
+{
+    struct SubsecondField
+    {
+        uint16_t offset; // in text
+        uint8_t width;   // zero padding of the milliseconds
+    };
+
+    static constexpr std::size_t capacity                = 128;
+    static constexpr std::size_t maxSubsecondFieldsCount = 4;
+
+    std::array<char, capacity> text;
+    std::size_t textSize = 0;
+    std::array<SubsecondField, maxSubsecondFieldsCount> subsecondFields;
+    std::size_t subsecondFieldsCount = 0;
+    bool isUsable                    = false; // false for formats which don't fit
+};
+
 struct DateTimeFormat
 {
     enum FormatSpecifier // also  check ISO 8601
@@ -55,6 +77,10 @@ struct DateTimeFormat
     };
     std::vector<FormatSpecifier> data;
 
+    // set only for formats made from CompiledDateTimeFormat, renders the cache without looking at data
+    using CompiledRenderFunction = void (*)(DateTimeCache& cache, const std::tm& parsedTime);
+    CompiledRenderFunction compiledRender = nullptr;
+
     template<std::size_t N>
     DateTimeFormat(const std::array<FormatSpecifier, N>& format)
     {
@@ -65,6 +91,7 @@ struct DateTimeFormat
     DateTimeFormat& operator+(const FormatSpecifier& format)
     {
         data.push_back(format);
+        compiledRender = nullptr;
         return *this;
     }
 };
@@ -79,236 +106,442 @@ inline constexpr auto operator+(const Kompot::DateTimeFormat::FormatSpecifier va
 inline auto operator+(const Kompot::DateTimeFormat::FormatSpecifier& formatSpecifier, Kompot::DateTimeFormat& dateTimeFormat)
 {
     dateTimeFormat.data.insert(dateTimeFormat.data.begin(), formatSpecifier);
+    dateTimeFormat.compiledRender = nullptr;
     return dateTimeFormat;
 }
 
-namespace Kompot
+namespace Kompot::DateTimeFormatting
 {
-class DateTimeFormatter
+static constexpr std::array<const char*, 7> daysNames = {
+    "Sunday", // tm::tm_wday with value 0 means Sunday. Fuck the Bible for this
+    "Monday",
+    "Tuesday",
+    "Wednesday",
+    "Thursday",
+    "Friday",
+    "Saturday"};
+
+static constexpr std::array<const char*, 12> monthsNames =
+    {"January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"};
+
+static constexpr std::size_t maxNumberLength = 11; // "-2147483648"
+
+inline int getWeekNumber(const std::tm& parsedTime)
 {
-public:
-    template<class T>
-    void printTime(T& stream, const std::chrono::system_clock::time_point& timePoint) const
+    constexpr int daysPerWeek = 7;
+
+    const int wday  = parsedTime.tm_wday;
+    const int delta = wday ? wday - 1 : daysPerWeek - 1;
+    return ((parsedTime.tm_yday + daysPerWeek - delta) / daysPerWeek) + 1;
+}
+
+inline int getHoursInFormat12(const std::tm& parsedTime)
+{
+    if (parsedTime.tm_hour == 0)
     {
-        using Ms    = std::chrono::milliseconds;
-        using Sec   = std::chrono::seconds;
-        using Clock = std::chrono::system_clock;
+        return 12;
+    }
+    if (parsedTime.tm_hour > 12)
+    {
+        return parsedTime.tm_hour - 12;
+    }
+    return parsedTime.tm_hour;
+}
 
-        const auto timeValue    = Clock::to_time_t(timePoint);
-        const auto timeValueMs  = std::chrono::duration_cast<Ms>(timePoint.time_since_epoch());
-        const auto timeValueSec = Sec(timeValue);
-        m_parsedMilliseconds    = timeValueMs - std::chrono::duration_cast<Ms>(timeValueSec);
-#if defined(ENGINE_OS_WINDOWS)
-        localtime_s(&m_parsedTime, &timeValue); // MSVS version
-#elif defined(ENGINE_OS_LINUX)
-        localtime_r(&timeValue, &m_parsedTime);
-        // gmtime_r(&timeValue, &m_parsedTime);
-#endif
-        printTime(stream);
+// writes value padded with zeros up to width, returns the end of the written characters
+inline char* printNumber(char* output, int value, int width)
+{
+    if (value < 0)
+    {
+        *output++ = '-';
+        value     = -value;
     }
 
-    void setFormat(const DateTimeFormat& format)
+    std::array<char, 10> digits;
+    int digitsCount = 0;
+    do
+    {
+        digits[digitsCount++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    for (; width > digitsCount; --width)
     {
-        m_dateTimeFormat = format;
+        *output++ = '0';
     }
-    const DateTimeFormat& getFormat() const
+    while (digitsCount > 0)
     {
-        return m_dateTimeFormat;
+        *output++ = digits[--digitsCount];
     }
+    return output;
+}
 
-private:
-    DateTimeFormat m_dateTimeFormat = DateTimeFormat(std::to_array(
-        {DateTimeFormat::Year,
-         DateTimeFormat::Dot,
-         DateTimeFormat::Month,
-         DateTimeFormat::Dot,
-         DateTimeFormat::Day,
-         DateTimeFormat::Space,
-         DateTimeFormat::Hours24,
-         DateTimeFormat::Colon,
-         DateTimeFormat::Minutes,
-         DateTimeFormat::Colon,
-         DateTimeFormat::Seconds,
-         DateTimeFormat::Dot,
-         DateTimeFormat::Milliseconds}));
+inline char* printText(char* output, const char* text, std::size_t length)
+{
+    return std::copy(text, text + length, output);
+}
 
-    mutable std::tm m_parsedTime;
-    mutable std::chrono::milliseconds m_parsedMilliseconds;
+// the upper bound of the specifier's output, Year is the only field which isn't limited by the calendar
+constexpr std::size_t getMaxLength(DateTimeFormat::FormatSpecifier formatSpecifier)
+{
+    switch (formatSpecifier)
+    {
+    case DateTimeFormat::Year:
+        return maxNumberLength;
+    case DateTimeFormat::DayOfYear:
+    case DateTimeFormat::DayOfYearShort:
+    case DateTimeFormat::Milliseconds:
+    case DateTimeFormat::MillisecondsShort:
+        return 3;
+    case DateTimeFormat::WeeklyName:
+    case DateTimeFormat::MonthName:
+        return 9; // "Wednesday", "September"
+    case DateTimeFormat::WeeklyNameShort:
+    case DateTimeFormat::MonthNameShort:
+        return 3;
+    case DateTimeFormat::DayOfWeek:
+    case DateTimeFormat::DayOfWeekFromNull:
+        return 2; // "-1" for sundays in DayOfWeekFromNull
+    case DateTimeFormat::Dot:
+    case DateTimeFormat::Comma:
+    case DateTimeFormat::Colon:
+    case DateTimeFormat::Space:
+        return 1;
+    default:
+        return 2;
+    }
+}
 
-    static constexpr std::array<const char*, 7> m_daysNames = {
-        "Sunday", // tm::tm_wday with value 0 means Sunday. Fuck the Bible for this
-        "Monday",
-        "Tuesday",
-        "Wednesday",
-        "Thursday",
-        "Friday",
-        "Saturday"};
-
-    static constexpr std::array<const char*, 12> m_monthsNames =
-        {"January", "February", "March", "April", "May", "June", "July", "August", "September", "October", "November", "December"};
-    template<class T>
-    void printTime(T& stream) const
+template<DateTimeFormat::FormatSpecifier Specifier>
+char* printSpecifier(char* output, const std::tm& parsedTime, int milliseconds)
+{
+    if constexpr (Specifier == DateTimeFormat::Year)
+        return printNumber(output, parsedTime.tm_year + 1900, 0);
+    else if constexpr (Specifier == DateTimeFormat::Month)
+        return printNumber(output, parsedTime.tm_mon + 1, 2);
+    else if constexpr (Specifier == DateTimeFormat::MonthShort)
+        return printNumber(output, parsedTime.tm_mon + 1, 0);
+    else if constexpr (Specifier == DateTimeFormat::Day)
+        return printNumber(output, parsedTime.tm_mday, 2);
+    else if constexpr (Specifier == DateTimeFormat::DayShort)
+        return printNumber(output, parsedTime.tm_mday, 0);
+    else if constexpr (Specifier == DateTimeFormat::Hours24)
+        return printNumber(output, parsedTime.tm_hour, 2);
+    else if constexpr (Specifier == DateTimeFormat::Hours24Short)
+        return printNumber(output, parsedTime.tm_hour, 0);
+    else if constexpr (Specifier == DateTimeFormat::Hours12)
+        return printNumber(output, getHoursInFormat12(parsedTime), 2);
+    else if constexpr (Specifier == DateTimeFormat::Hours12Short)
+        return printNumber(output, getHoursInFormat12(parsedTime), 0);
+    else if constexpr (Specifier == DateTimeFormat::Minutes)
+        return printNumber(output, parsedTime.tm_min, 2);
+    else if constexpr (Specifier == DateTimeFormat::MinutesShort)
+        return printNumber(output, parsedTime.tm_min, 0);
+    else if constexpr (Specifier == DateTimeFormat::Seconds)
+        return printNumber(output, parsedTime.tm_sec, 2);
+    else if constexpr (Specifier == DateTimeFormat::SecondsShort)
+        return printNumber(output, parsedTime.tm_sec, 0);
+    else if constexpr (Specifier == DateTimeFormat::Milliseconds)
+        return printNumber(output, milliseconds, 3);
+    else if constexpr (Specifier == DateTimeFormat::MillisecondsShort)
+        return printNumber(output, milliseconds, 0);
+    else if constexpr (Specifier == DateTimeFormat::WeeklyName)
+        return printText(output, daysNames[parsedTime.tm_wday], std::strlen(daysNames[parsedTime.tm_wday]));
+    else if constexpr (Specifier == DateTimeFormat::WeeklyNameShort)
+        return printText(output, daysNames[parsedTime.tm_wday], 3);
+    else if constexpr (Specifier == DateTimeFormat::MonthName)
+        return printText(output, monthsNames[parsedTime.tm_mon], std::strlen(monthsNames[parsedTime.tm_mon]));
+    else if constexpr (Specifier == DateTimeFormat::MonthNameShort)
+        return printText(output, monthsNames[parsedTime.tm_mon], 3);
+    else if constexpr (Specifier == DateTimeFormat::DayOfYear)
+        return printNumber(output, parsedTime.tm_yday + 1, 3);
+    else if constexpr (Specifier == DateTimeFormat::DayOfYearShort)
+        return printNumber(output, parsedTime.tm_yday + 1, 0);
+    else if constexpr (Specifier == DateTimeFormat::DayOfWeek)
+        return printNumber(output, parsedTime.tm_yday != 0 ? parsedTime.tm_wday : 7, 0);
+    else if constexpr (Specifier == DateTimeFormat::DayOfWeekFromNull)
+        return printNumber(output, parsedTime.tm_yday != 0 ? parsedTime.tm_wday - 1 : 6, 0);
+    else if constexpr (Specifier == DateTimeFormat::DayPartName)
+        return printText(output, parsedTime.tm_hour < 12 ? "AM" : "PM", 2);
+    else if constexpr (Specifier == DateTimeFormat::WeekNumber)
+        return printNumber(output, getWeekNumber(parsedTime), 2);
+    else if constexpr (Specifier == DateTimeFormat::WeekNumberShort)
+        return printNumber(output, getWeekNumber(parsedTime), 0);
+    else
     {
-        const char previousCharacter = stream.fill();
-        stream.fill('0');
-        std::streamsize previousWidth = stream.width();
-        for (const DateTimeFormat::FormatSpecifier& formatSpecifier : m_dateTimeFormat.data)
-        {
-            switch (formatSpecifier)
-            {
-            case DateTimeFormat::Year:
-            {
-                stream << m_parsedTime.tm_year + 1900;
-                stream.width(previousWidth);
-                break;
-            }
+        constexpr char separators[] = {'.', ',', ':', ' '};
+        static_assert(Specifier >= DateTimeFormat::Dot && Specifier <= DateTimeFormat::Space, "Unknown enum value");
+        *output = separators[Specifier - DateTimeFormat::Dot];
+        return output + 1;
+    }
+}
 
-            case DateTimeFormat::Month:
-                stream.width(2);
-            case DateTimeFormat::MonthShort:
-            {
-                stream << m_parsedTime.tm_mon + 1;
-                stream.width(previousWidth);
-                break;
-            }
+// runtime dispatch for formats built from DateTimeFormat::data, writes at most getMaxLength(formatSpecifier) characters
+inline char* printSpecifier(char* output, DateTimeFormat::FormatSpecifier formatSpecifier, const std::tm& parsedTime, int milliseconds)
+{
+    switch (formatSpecifier)
+    {
+#define DATE_TIME_FORMAT_CASE(specifier) \
+    case DateTimeFormat::specifier:      \
+        return printSpecifier<DateTimeFormat::specifier>(output, parsedTime, milliseconds);
+
+        DATE_TIME_FORMAT_CASE(Year)
+        DATE_TIME_FORMAT_CASE(Month)
+        DATE_TIME_FORMAT_CASE(MonthShort)
+        DATE_TIME_FORMAT_CASE(Day)
+        DATE_TIME_FORMAT_CASE(DayShort)
+        DATE_TIME_FORMAT_CASE(Hours24)
+        DATE_TIME_FORMAT_CASE(Hours24Short)
+        DATE_TIME_FORMAT_CASE(Hours12)
+        DATE_TIME_FORMAT_CASE(Hours12Short)
+        DATE_TIME_FORMAT_CASE(Minutes)
+        DATE_TIME_FORMAT_CASE(MinutesShort)
+        DATE_TIME_FORMAT_CASE(Seconds)
+        DATE_TIME_FORMAT_CASE(SecondsShort)
+        DATE_TIME_FORMAT_CASE(Milliseconds)
+        DATE_TIME_FORMAT_CASE(MillisecondsShort)
+        DATE_TIME_FORMAT_CASE(WeeklyName)
+        DATE_TIME_FORMAT_CASE(WeeklyNameShort)
+        DATE_TIME_FORMAT_CASE(MonthName)
+        DATE_TIME_FORMAT_CASE(MonthNameShort)
+        DATE_TIME_FORMAT_CASE(DayOfYear)
+        DATE_TIME_FORMAT_CASE(DayOfYearShort)
+        DATE_TIME_FORMAT_CASE(DayOfWeek)
+        DATE_TIME_FORMAT_CASE(DayOfWeekFromNull)
+        DATE_TIME_FORMAT_CASE(DayPartName)
+        DATE_TIME_FORMAT_CASE(WeekNumber)
+        DATE_TIME_FORMAT_CASE(WeekNumberShort)
+        DATE_TIME_FORMAT_CASE(Dot)
+        DATE_TIME_FORMAT_CASE(Comma)
+        DATE_TIME_FORMAT_CASE(Colon)
+        DATE_TIME_FORMAT_CASE(Space)
+
+#undef DATE_TIME_FORMAT_CASE
+    default:
+        breakPoint("Unknown enum value");
+        return output;
+    }
+}
 
-            case DateTimeFormat::Day:
-                stream.width(2);
-            case DateTimeFormat::DayShort:
-            {
-                stream << m_parsedTime.tm_mday;
-                stream.width(previousWidth);
-                break;
-            }
+template<DateTimeFormat::FormatSpecifier Specifier>
+void renderSpecifier(DateTimeCache& cache, const std::tm& parsedTime)
+{
+    if constexpr (Specifier == DateTimeFormat::Milliseconds || Specifier == DateTimeFormat::MillisecondsShort)
+    {
+        const uint8_t width = Specifier == DateTimeFormat::Milliseconds ? 3 : 0;
+        cache.subsecondFields[cache.subsecondFieldsCount++] = {static_cast<uint16_t>(cache.textSize), width};
+    }
+    else
+    {
+        char* textEnd = cache.text.data() + cache.textSize;
+        cache.textSize += printSpecifier<Specifier>(textEnd, parsedTime, 0) - textEnd;
+    }
+}
 
-            case DateTimeFormat::Hours24:
-                stream.width(2);
-            case DateTimeFormat::Hours24Short:
+inline void renderSpecifiers(DateTimeCache& cache, const std::vector<DateTimeFormat::FormatSpecifier>& specifiers, const std::tm& parsedTime)
+{
+    cache.textSize             = 0;
+    cache.subsecondFieldsCount = 0;
+    cache.isUsable             = false;
+    for (const DateTimeFormat::FormatSpecifier& formatSpecifier : specifiers)
+    {
+        if (formatSpecifier == DateTimeFormat::Milliseconds || formatSpecifier == DateTimeFormat::MillisecondsShort)
+        {
+            if (cache.subsecondFieldsCount == DateTimeCache::maxSubsecondFieldsCount)
             {
-                stream << m_parsedTime.tm_hour;
-                stream.width(previousWidth);
-                break;
+                return;
             }
+            const uint8_t width = formatSpecifier == DateTimeFormat::Milliseconds ? 3 : 0;
+            cache.subsecondFields[cache.subsecondFieldsCount++] = {static_cast<uint16_t>(cache.textSize), width};
+            continue;
+        }
 
-            case DateTimeFormat::Hours12:
-                stream.width(2);
-            case DateTimeFormat::Hours12Short:
-            {
-                stream << getHoursInFormat12();
-                stream.width(previousWidth);
-                break;
-            }
+        if (cache.textSize + getMaxLength(formatSpecifier) > DateTimeCache::capacity)
+        {
+            return;
+        }
+        char* textEnd = cache.text.data() + cache.textSize;
+        cache.textSize += printSpecifier(textEnd, formatSpecifier, parsedTime, 0) - textEnd;
+    }
+    cache.isUsable = true;
+}
 
-            case DateTimeFormat::Minutes:
-                stream.width(2);
-            case DateTimeFormat::MinutesShort:
-            {
-                stream << m_parsedTime.tm_min;
-                stream.width(previousWidth);
-                break;
-            }
+} // namespace Kompot::DateTimeFormatting
 
-            case DateTimeFormat::Seconds:
-                stream.width(2);
-            case DateTimeFormat::SecondsShort:
-            {
-                stream << m_parsedTime.tm_sec;
-                stream.width(previousWidth);
-                break;
-            }
+namespace Kompot
+{
+/*
+ * A format fixed at compile time:
+ *     CompiledDateTimeFormat<DateTimeFormat::Hours24, DateTimeFormat::Colon, DateTimeFormat::Minutes>
+ * print() and render() are unrolled for the specifiers, maxLength is enough for a stack buffer.
+ * Converts to DateTimeFormat, so it can be passed everywhere a runtime format is expected.
+ */
+template<DateTimeFormat::FormatSpecifier... Specifiers>
+struct CompiledDateTimeFormat
+{
+    static constexpr std::size_t maxLength = (DateTimeFormatting::getMaxLength(Specifiers) + ... + 0);
+    static_assert(maxLength <= DateTimeCache::capacity, "The format is too long");
+    static_assert(
+        ((Specifiers == DateTimeFormat::Milliseconds || Specifiers == DateTimeFormat::MillisecondsShort) + ... + 0) <=
+            DateTimeCache::maxSubsecondFieldsCount,
+        "Too many milliseconds in the format");
+
+    static char* print(char* output, const std::tm& parsedTime, int milliseconds)
+    {
+        ((output = DateTimeFormatting::printSpecifier<Specifiers>(output, parsedTime, milliseconds)), ...);
+        return output;
+    }
 
-            case DateTimeFormat::Milliseconds:
-                stream.width(3);
-            case DateTimeFormat::MillisecondsShort:
-            {
-                stream << m_parsedMilliseconds.count();
-                stream.width(previousWidth);
-                break;
-            }
+    static void render(DateTimeCache& cache, const std::tm& parsedTime)
+    {
+        cache.textSize             = 0;
+        cache.subsecondFieldsCount = 0;
+        (DateTimeFormatting::renderSpecifier<Specifiers>(cache, parsedTime), ...);
+        cache.isUsable = true;
+    }
 
-            case DateTimeFormat::WeeklyName:
-                stream << m_daysNames[m_parsedTime.tm_wday];
-                break;
-            case DateTimeFormat::WeeklyNameShort:
-                stream.write(m_daysNames[m_parsedTime.tm_wday], 3);
-                break;
-
-            case DateTimeFormat::MonthName:
-                stream << m_monthsNames[m_parsedTime.tm_mon];
-                break;
-            case DateTimeFormat::MonthNameShort:
-                stream.write(m_monthsNames[m_parsedTime.tm_mon], 3);
-                break;
-
-            case DateTimeFormat::DayOfYear:
-                stream.width(3);
-            case DateTimeFormat::DayOfYearShort:
-            {
-                stream << m_parsedTime.tm_yday + 1;
-                stream.width(previousWidth);
-                break;
-            }
+    operator DateTimeFormat() const
+    {
+        DateTimeFormat format(std::array<DateTimeFormat::FormatSpecifier, sizeof...(Specifiers)>{Specifiers...});
+        format.compiledRender = &render;
+        return format;
+    }
+};
 
-            case DateTimeFormat::DayOfWeek:
-                stream << (m_parsedTime.tm_yday != 0 ? m_parsedTime.tm_wday : 7);
-                break;
-            case DateTimeFormat::DayOfWeekFromNull:
-                stream << (m_parsedTime.tm_yday != 0 ? m_parsedTime.tm_wday - 1 : 6);
-                break;
+using DefaultDateTimeFormat = CompiledDateTimeFormat<
+    DateTimeFormat::Year,
+    DateTimeFormat::Dot,
+    DateTimeFormat::Month,
+    DateTimeFormat::Dot,
+    DateTimeFormat::Day,
+    DateTimeFormat::Space,
+    DateTimeFormat::Hours24,
+    DateTimeFormat::Colon,
+    DateTimeFormat::Minutes,
+    DateTimeFormat::Colon,
+    DateTimeFormat::Seconds,
+    DateTimeFormat::Dot,
+    DateTimeFormat::Milliseconds>;
 
-            case DateTimeFormat::DayPartName:
-                stream << (m_parsedTime.tm_hour < 12 ? "AM" : "PM");
-                break;
+/*
+ * localtime is called and the date and the time up to seconds are rendered once per second into m_cache,
+ * the following calls in the same second only copy it and write the milliseconds in.
+ * Compiled formats render the cache by their own function, without the per-specifier switch.
+ */
+class DateTimeFormatter
+{
+public:
+    template<class T>
+    void printTime(T& stream, const std::chrono::system_clock::time_point& timePoint) const
+    {
+        const auto timeValue = parseMilliseconds(timePoint);
+        if (timeValue != m_cachedTimeValue)
+        {
+            parseTime(timeValue);
+            updateCache();
+            m_cachedTimeValue = timeValue;
+        }
 
-            case DateTimeFormat::WeekNumber:
-                stream.width(2);
-            case DateTimeFormat::WeekNumberShort:
-            {
-                stream << getWeekNumber();
-                stream.width(previousWidth);
-                break;
-            }
+        if (!m_cache.isUsable)
+        {
+            printSpecifiers(stream);
+            return;
+        }
 
-            case DateTimeFormat::Dot:
-                stream << '.';
-                break;
-            case DateTimeFormat::Comma:
-                stream << ',';
-                break;
-            case DateTimeFormat::Colon:
-                stream << ':';
-                break;
-            case DateTimeFormat::Space:
-                stream << ' ';
-                break;
-            default:
-                breakPoint("Unknown enum value");
-                break;
-            }
+        std::array<char, DateTimeCache::capacity + DateTimeCache::maxSubsecondFieldsCount * DateTimeFormatting::maxNumberLength> buffer;
+        const char* cachedText = m_cache.text.data();
+        char* output           = buffer.data();
+        std::size_t offset     = 0;
+        for (std::size_t i = 0; i < m_cache.subsecondFieldsCount; ++i)
+        {
+            const DateTimeCache::SubsecondField& field = m_cache.subsecondFields[i];
+            output                                     = std::copy(cachedText + offset, cachedText + field.offset, output);
+            output                                     = DateTimeFormatting::printNumber(output, getMilliseconds(), field.width);
+            offset                                     = field.offset;
         }
-        stream.fill(previousCharacter);
+        output = std::copy(cachedText + offset, cachedText + m_cache.textSize, output);
+        stream.write(buffer.data(), output - buffer.data());
+    }
+
+    // same output as printTime, but calls localtime and interprets every specifier each time
+    template<class T>
+    void printTimeUncached(T& stream, const std::chrono::system_clock::time_point& timePoint) const
+    {
+        parseTime(parseMilliseconds(timePoint));
+        m_cachedTimeValue = m_invalidTimeValue;
+        printSpecifiers(stream);
+    }
+
+    void setFormat(const DateTimeFormat& format)
+    {
+        m_dateTimeFormat  = format;
+        m_cachedTimeValue = m_invalidTimeValue;
+    }
+    const DateTimeFormat& getFormat() const
+    {
+        return m_dateTimeFormat;
+    }
+
+private:
+    DateTimeFormat m_dateTimeFormat = DefaultDateTimeFormat{};
+
+    mutable std::tm m_parsedTime;
+    mutable std::chrono::milliseconds m_parsedMilliseconds;
+
+    static constexpr std::time_t m_invalidTimeValue = std::numeric_limits<std::time_t>::min();
+
+    mutable std::time_t m_cachedTimeValue = m_invalidTimeValue;
+    mutable DateTimeCache m_cache;
+
+    std::time_t parseMilliseconds(const std::chrono::system_clock::time_point& timePoint) const
+    {
+        using Ms    = std::chrono::milliseconds;
+        using Sec   = std::chrono::seconds;
+        using Clock = std::chrono::system_clock;
+
+        const auto timeValue    = Clock::to_time_t(timePoint);
+        const auto timeValueMs  = std::chrono::duration_cast<Ms>(timePoint.time_since_epoch());
+        const auto timeValueSec = Sec(timeValue);
+        m_parsedMilliseconds    = timeValueMs - std::chrono::duration_cast<Ms>(timeValueSec);
+        return timeValue;
     }
 
-    int getWeekNumber() const
+    int getMilliseconds() const
     {
-        constexpr int daysPerWeek = 7;
+        return static_cast<int>(m_parsedMilliseconds.count());
+    }
 
-        const int wday  = m_parsedTime.tm_wday;
-        const int delta = wday ? wday - 1 : daysPerWeek - 1;
-        return ((m_parsedTime.tm_yday + daysPerWeek - delta) / daysPerWeek) + 1;
+    void parseTime(std::time_t timeValue) const
+    {
+#if defined(ENGINE_OS_WINDOWS)
+        localtime_s(&m_parsedTime, &timeValue); // MSVS version
+#elif defined(ENGINE_OS_LINUX)
+        localtime_r(&timeValue, &m_parsedTime);
+        // gmtime_r(&timeValue, &m_parsedTime);
+#endif
     }
 
-    int getHoursInFormat12() const
+    void updateCache() const
     {
-        if (m_parsedTime.tm_hour == 0)
+        if (m_dateTimeFormat.compiledRender)
+        {
+            m_dateTimeFormat.compiledRender(m_cache, m_parsedTime);
+        }
+        else
         {
-            return 12;
+            DateTimeFormatting::renderSpecifiers(m_cache, m_dateTimeFormat.data, m_parsedTime);
         }
-        if (m_parsedTime.tm_hour > 12)
+    }
+
+    template<class T>
+    void printSpecifiers(T& stream) const
+    {
+        std::array<char, DateTimeFormatting::maxNumberLength> buffer;
+        for (const DateTimeFormat::FormatSpecifier& formatSpecifier : m_dateTimeFormat.data)
         {
-            return m_parsedTime.tm_hour - 12;
+            const char* end = DateTimeFormatting::printSpecifier(buffer.data(), formatSpecifier, m_parsedTime, getMilliseconds());
+            stream.write(buffer.data(), end - buffer.data());
         }
-        return m_parsedTime.tm_hour;
     }
 };
 
@@ -0,0 +1,132 @@
+/*
+ *  Hash.hpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace Kompot::Hash
+{
+namespace Detail
+{
+constexpr uint64_t xxPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t xxPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t xxPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t xxPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t xxPrime5 = 0x27D4EB2F165667C5ull;
+
+constexpr uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// the engine targets little-endian platforms only, like the binary formats in Docs/
+inline uint64_t read64(const unsigned char* data)
+{
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint32_t read32(const unsigned char* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+constexpr uint64_t round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * xxPrime2;
+    accumulator = rotateLeft(accumulator, 31);
+    return accumulator * xxPrime1;
+}
+
+constexpr uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= round(0, value);
+    return accumulator * xxPrime1 + xxPrime4;
+}
+} // namespace Detail
+
+/*
+ * XXH64 by Yann Collet, produces the same values as the reference implementation.
+ * Fast, but not cryptographic: good for cache keys and change detection.
+ */
+inline uint64_t xxHash64(const void* data, std::size_t size, uint64_t seed = 0)
+{
+    using namespace Detail;
+
+    const auto* position  = static_cast<const unsigned char*>(data);
+    const auto* const end = position + size;
+
+    uint64_t hash;
+    if (size >= 32)
+    {
+        uint64_t accumulator1 = seed + xxPrime1 + xxPrime2;
+        uint64_t accumulator2 = seed + xxPrime2;
+        uint64_t accumulator3 = seed;
+        uint64_t accumulator4 = seed - xxPrime1;
+        for (; end - position >= 32; position += 32)
+        {
+            accumulator1 = round(accumulator1, read64(position));
+            accumulator2 = round(accumulator2, read64(position + 8));
+            accumulator3 = round(accumulator3, read64(position + 16));
+            accumulator4 = round(accumulator4, read64(position + 24));
+        }
+
+        hash = rotateLeft(accumulator1, 1) + rotateLeft(accumulator2, 7) + rotateLeft(accumulator3, 12) + rotateLeft(accumulator4, 18);
+        hash = mergeRound(hash, accumulator1);
+        hash = mergeRound(hash, accumulator2);
+        hash = mergeRound(hash, accumulator3);
+        hash = mergeRound(hash, accumulator4);
+    }
+    else
+    {
+        hash = seed + xxPrime5;
+    }
+
+    hash += static_cast<uint64_t>(size);
+
+    for (; end - position >= 8; position += 8)
+    {
+        hash ^= round(0, read64(position));
+        hash = rotateLeft(hash, 27) * xxPrime1 + xxPrime4;
+    }
+    if (end - position >= 4)
+    {
+        hash ^= static_cast<uint64_t>(read32(position)) * xxPrime1;
+        hash = rotateLeft(hash, 23) * xxPrime2 + xxPrime3;
+        position += 4;
+    }
+    for (; position < end; ++position)
+    {
+        hash ^= static_cast<uint64_t>(*position) * xxPrime5;
+        hash = rotateLeft(hash, 11) * xxPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= xxPrime2;
+    hash ^= hash >> 29;
+    hash *= xxPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+inline uint64_t xxHash64(std::string_view text, uint64_t seed = 0)
+{
+    return xxHash64(text.data(), text.size(), seed);
+}
+
+// otherwise xxHash64("text", seed) would take the seed for the size
+inline uint64_t xxHash64(const char* text, uint64_t seed = 0)
+{
+    return xxHash64(std::string_view(text), seed);
+}
+
+} // namespace Kompot::Hash
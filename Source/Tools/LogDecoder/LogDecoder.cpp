@@ -0,0 +1,95 @@
+/*
+ *  LogDecoder.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/Log/LogBinaryFormat.hpp>
+#include <Engine/Log/LogFormatStream.hpp>
+#include <Engine/Log/LogTextSink.hpp>
+#include <Engine/Log/LogTypes.hpp>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Turns log.bin written in LogOutputFormat::Binary mode back into the text log:
+ *     KompotLogDecoder log.bin [log.txt]
+ */
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <log.bin> [output.txt]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input.is_open())
+    {
+        std::cerr << "Failed to open \"" << argv[1] << '"' << std::endl;
+        return 1;
+    }
+
+    std::array<char, 4> magic{};
+    uint32_t version = 0;
+    input.read(magic.data(), magic.size());
+    input.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!input || magic != LogBinaryFormat::fileMagic || version != LogBinaryFormat::fileVersion)
+    {
+        std::cerr << '"' << argv[1] << "\" is not a binary log of version " << LogBinaryFormat::fileVersion << std::endl;
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (argc > 2)
+    {
+        outputFile.open(argv[2]);
+    }
+    LogTextSink textSink(outputFile.is_open() ? static_cast<std::ostream&>(outputFile) : std::cout);
+
+    std::unordered_map<uint32_t, std::string> formats;
+    std::vector<char> message;
+    LogFormatStream formattedMessage;
+
+    LogRecordHeader header;
+    while (input.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        message.resize(header.size);
+        if (!input.read(message.data(), header.size))
+        {
+            std::cerr << "The log is truncated" << std::endl;
+            break;
+        }
+        const std::string_view messageView(message.data(), message.size());
+
+        if (header.flags & LogRecordFormatDefinition)
+        {
+            formats[header.formatId] = messageView;
+            continue;
+        }
+
+        if (header.flags & LogRecordBinary)
+        {
+            const auto format = formats.find(header.formatId);
+
+            formattedMessage.clear();
+            formattedMessage << ' ';
+            LogBinaryFormat::formatMessage(formattedMessage, format != formats.end() ? format->second : "<unknown format>", messageView);
+            formattedMessage << '\n';
+
+            header.flags &= ~LogRecordBinary;
+            textSink.write(header, formattedMessage.view());
+        }
+        else
+        {
+            textSink.write(header, messageView);
+        }
+    }
+    textSink.flush();
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ *  ShaderCompiler.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderCompiler.hpp>
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderManager.hpp>
+#include <Engine/Log/Log.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace Kompot::Rendering;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+std::optional<ShaderOptimization> parseOptimization(std::string_view name)
+{
+    if (name == "None")
+    {
+        return ShaderOptimization::None;
+    }
+    if (name == "Performance")
+    {
+        return ShaderOptimization::Performance;
+    }
+    if (name == "Size")
+    {
+        return ShaderOptimization::Size;
+    }
+    return std::nullopt;
+}
+
+int printUsage(const char* programName)
+{
+    std::cerr << "Usage: " << programName << " [--optimization None|Performance|Size] [--directory <working directory>] [shaders directory]"
+              << std::endl;
+    return 1;
+}
+} // namespace
+
+/*
+ * Compiles every shader of the shaders directory (Shaders by default) into the cache archive the engine maps at startup:
+ *     KompotShaderCompiler --directory <project directory> Shaders
+ * The shaders and the archive are relative to the working directory, like in the engine. Shaders up to date in the archive
+ * aren't compiled again, the rest are compiled in parallel. Exits with 1 if any shader fails to compile.
+ */
+int main(int argc, char** argv)
+{
+    std::optional<ShaderOptimization> optimization;
+    fs::path workingDirectory;
+    fs::path shadersDirectory = "Shaders";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--optimization" && i + 1 < argc)
+        {
+            optimization = parseOptimization(argv[++i]);
+            if (!optimization)
+            {
+                return printUsage(argv[0]);
+            }
+        }
+        else if (argument == "--directory" && i + 1 < argc)
+        {
+            workingDirectory = argv[++i];
+        }
+        else if (!argument.starts_with("--"))
+        {
+            shadersDirectory = argument;
+        }
+        else
+        {
+            return printUsage(argv[0]);
+        }
+    }
+
+    // the log files stay in the directory the tool was started from, e.g. the build directory
+    Log::getInstance().configure(LogConfig{});
+    if (std::error_code error; !workingDirectory.empty() && (fs::current_path(workingDirectory, error), error))
+    {
+        std::cerr << "Failed to enter " << workingDirectory << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    if (shadersDirectory.is_absolute() || !fs::is_directory(shadersDirectory))
+    {
+        std::cerr << shadersDirectory << " is not a relative path of a directory" << std::endl;
+        return 1;
+    }
+
+    // the manager picks the archive by the optimization, so it's set first
+    if (optimization)
+    {
+        ShaderCompiler::get().setOptimization(*optimization);
+    }
+
+    std::vector<fs::path> shaderPaths;
+    for (const auto& entry : fs::recursive_directory_iterator(shadersDirectory))
+    {
+        // headers are compiled as a part of the shaders including them
+        if (entry.is_regular_file() && ShaderCompiler::isShaderSource(entry.path()))
+        {
+            shaderPaths.push_back(entry.path().lexically_normal());
+        }
+    }
+    std::sort(shaderPaths.begin(), shaderPaths.end());
+
+    auto& shaderManager    = ShaderManager::get();
+    const auto binaries    = shaderManager.loadAll(shaderPaths);
+    const auto failedCount = std::count_if(binaries.begin(), binaries.end(), [](const ShaderBinary& binary) { return binary.empty(); });
+
+    // the shaders compiled successfully are kept even if others failed, the next build compiles only the failed ones
+    const auto statistics = shaderManager.getStatistics();
+    if (!shaderManager.saveArchive())
+    {
+        std::cerr << "Failed to save the shader cache archive" << std::endl;
+        return 1;
+    }
+
+    std::cout << shaderPaths.size() << " shaders, " << statistics.compiledCount << " compiled";
+    if (failedCount > 0)
+    {
+        std::cout << ", " << failedCount << " failed, see the log above";
+    }
+    std::cout << std::endl;
+    return failedCount > 0 ? 1 : 0;
+}
@@ -6,11 +6,18 @@
 
 #include <Engine/Config/ConfigManager.hpp>
 #include <Engine/Engine.hpp>
+#include <Engine/ErrorHandling.hpp>
+#include <Engine/Log/Log.hpp>
 
 int main(int argc, char** argv)
 {
     std::ios::sync_with_stdio(false);
 
+    LogConfig logConfig;
+    logConfig.mode = LogMode::Asynchronous;
+    Log::getInstance().configure(logConfig);
+    Kompot::ErrorHandling::installCrashHandler();
+
     using Kompot::ConfigManager;
     ConfigManager& configManager = ConfigManager::getInstance();
     configManager.loadCommandLineArguments(argc, argv);
@@ -0,0 +1,100 @@
+/*
+ *  LogCallSite_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/Log/LogCallSite.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+// the call sites are static, like in ENGINE_LOG_LIMITED, they stay linked into the list of all call sites
+namespace
+{
+constexpr int64_t second = LogCallSite::windowLength;
+constexpr int64_t start  = 1000 * second;
+} // namespace
+
+TEST(LogCallSite, limitsMessagesPerSecond)
+{
+    static LogCallSite callSite(LogLevel::Warning, LogCategory::Renderer, "Source/Renderer.cpp", 10, 2);
+
+    EXPECT_TRUE(callSite.tryAcquire(start));
+    EXPECT_TRUE(callSite.tryAcquire(start + 1));
+    EXPECT_FALSE(callSite.tryAcquire(start + 2));
+    EXPECT_FALSE(callSite.tryAcquire(start + second - 1));
+
+    // the next window
+    EXPECT_TRUE(callSite.tryAcquire(start + second));
+    EXPECT_TRUE(callSite.tryAcquire(start + second + 1));
+    EXPECT_FALSE(callSite.tryAcquire(start + second + 2));
+}
+
+TEST(LogCallSite, unlimitedWithoutMaximum)
+{
+    static LogCallSite callSite(LogLevel::Warning, LogCategory::Renderer, "Renderer.cpp", 10, 0);
+
+    for (int64_t index = 0; index < 1000; ++index)
+    {
+        EXPECT_TRUE(callSite.tryAcquire(start + index));
+    }
+}
+
+TEST(LogCallSite, collapsesRepeats)
+{
+    static LogCallSite callSite(LogLevel::Warning, LogCategory::Renderer, "Renderer.cpp", 10, 0);
+
+    const uint64_t firstMessage  = LogCallSite::hash("first");
+    const uint64_t secondMessage = LogCallSite::hash("second");
+    EXPECT_NE(firstMessage, secondMessage);
+
+    EXPECT_TRUE(callSite.isNewMessage(firstMessage, start));
+    EXPECT_FALSE(callSite.isNewMessage(firstMessage, start + 1));
+    EXPECT_FALSE(callSite.isNewMessage(firstMessage, start + 2));
+    EXPECT_TRUE(callSite.hasRepeats());
+    EXPECT_TRUE(callSite.isNewMessage(secondMessage, start + 3));
+    EXPECT_TRUE(callSite.isNewMessage(firstMessage, start + 4));
+}
+
+TEST(LogCallSite, reportsOnceASecond)
+{
+    static LogCallSite callSite(LogLevel::Warning, LogCategory::Renderer, "Source/Engine/Renderer.cpp", 42, 1);
+    std::ostringstream report;
+
+    EXPECT_FALSE(callSite.takeReport(start, true, report));
+
+    EXPECT_TRUE(callSite.tryAcquire(start));
+    EXPECT_FALSE(callSite.tryAcquire(start + second / 2));
+    EXPECT_FALSE(callSite.tryAcquire(start + second / 2 + second / 4));
+    EXPECT_TRUE(LogCallSite::hasPendingReports());
+
+    // the storm is younger than a second
+    EXPECT_FALSE(callSite.takeReport(start + second / 2 + second / 4, false, report));
+    EXPECT_TRUE(report.str().empty());
+
+    EXPECT_TRUE(callSite.takeReport(start + second + second / 2, false, report));
+    EXPECT_EQ(report.str(), " [Log] Renderer.cpp:42: 2 messages over the limit of 1 per second skipped in 0.250s\n");
+
+    // taken already
+    report.str({});
+    EXPECT_FALSE(callSite.takeReport(start + 2 * second, true, report));
+    EXPECT_TRUE(report.str().empty());
+}
+
+TEST(LogCallSite, forcedReportOfRepeats)
+{
+    static LogCallSite callSite(LogLevel::Error, LogCategory::Shader, "Shader.cpp", 7, 0);
+    std::ostringstream report;
+
+    const uint64_t message = LogCallSite::hash("message");
+    EXPECT_TRUE(callSite.isNewMessage(message, start));
+    for (int64_t index = 1; index <= 5; ++index)
+    {
+        EXPECT_FALSE(callSite.isNewMessage(message, start + index * second / 100));
+    }
+
+    // a different message ends the run, its repeats go out right away
+    EXPECT_TRUE(callSite.takeReport(start + second / 10, true, report));
+    EXPECT_EQ(report.str(), " [Log] Shader.cpp:7: previous message repeated 5 times in 0.040s\n");
+    EXPECT_FALSE(callSite.hasRepeats());
+}
@@ -0,0 +1,159 @@
+/*
+ *  LogRingBuffer_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/Log/LogRingBuffer.hpp>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// a record like the log writes: the size, then the message
+bool writeRecord(LogRingBuffer& ring, const std::string& message)
+{
+    const auto size = static_cast<uint32_t>(message.size());
+    return ring.tryWrite(&size, sizeof(size), message.data(), message.size());
+}
+
+std::vector<std::string> parseRecords(const std::vector<char>& bytes)
+{
+    std::vector<std::string> records;
+    std::size_t offset = 0;
+    while (offset + sizeof(uint32_t) <= bytes.size())
+    {
+        uint32_t size = 0;
+        std::memcpy(&size, bytes.data() + offset, sizeof(size));
+        offset += sizeof(size);
+        records.emplace_back(bytes.data() + offset, size);
+        offset += size;
+    }
+    EXPECT_EQ(offset, bytes.size());
+    return records;
+}
+
+std::size_t consumeAll(LogRingBuffer& ring, std::vector<char>& bytes)
+{
+    return ring.consume([&bytes](const char* data, std::size_t size) {
+        bytes.insert(bytes.end(), data, data + size);
+    });
+}
+} // namespace
+
+TEST(LogRingBuffer, roundsCapacityUp)
+{
+    EXPECT_EQ(LogRingBuffer(1).capacity(), 64u);
+    EXPECT_EQ(LogRingBuffer(100).capacity(), 128u);
+    EXPECT_EQ(LogRingBuffer(256).capacity(), 256u);
+}
+
+TEST(LogRingBuffer, wrapsAround)
+{
+    LogRingBuffer ring(64);
+    std::vector<char> bytes;
+
+    // 40 bytes each, the records which cross the end of the storage come in two spans
+    for (std::size_t index = 0; index < 10; ++index)
+    {
+        const std::string message(36, static_cast<char>('a' + index));
+        ASSERT_TRUE(writeRecord(ring, message));
+        EXPECT_EQ(ring.usedSize(), 40u);
+
+        std::size_t spansCount = 0;
+        const auto consumer    = [&bytes, &spansCount](const char* data, std::size_t size) {
+            bytes.insert(bytes.end(), data, data + size);
+            ++spansCount;
+        };
+        bytes.clear();
+        EXPECT_EQ(ring.consume(consumer), 40u);
+        EXPECT_EQ(spansCount, index * 40 % 64 + 40 > 64 ? 2u : 1u);
+        EXPECT_EQ(parseRecords(bytes), std::vector<std::string>{message});
+        EXPECT_TRUE(ring.isEmpty());
+    }
+}
+
+TEST(LogRingBuffer, rejectsWholeRecordWhenFull)
+{
+    LogRingBuffer ring(64);
+    std::vector<char> bytes;
+
+    ASSERT_TRUE(writeRecord(ring, std::string(28, 'a')));
+    ASSERT_TRUE(writeRecord(ring, std::string(20, 'b')));
+
+    // LogOverflowPolicy::Drop: the message doesn't fit and nothing of it gets in
+    EXPECT_FALSE(writeRecord(ring, std::string(16, 'c')));
+    EXPECT_EQ(ring.usedSize(), 56u);
+    EXPECT_TRUE(writeRecord(ring, std::string(4, 'd')));
+    EXPECT_FALSE(writeRecord(ring, ""));
+
+    consumeAll(ring, bytes);
+    EXPECT_EQ(parseRecords(bytes), (std::vector<std::string>{std::string(28, 'a'), std::string(20, 'b'), std::string(4, 'd')}));
+    EXPECT_EQ(consumeAll(ring, bytes), 0u);
+}
+
+TEST(LogRingBuffer, blockedProducerResumesAfterConsume)
+{
+    LogRingBuffer ring(64);
+    constexpr int recordsCount = 1000;
+
+    // LogOverflowPolicy::Block: the producer retries until the consumer frees enough space
+    std::thread producer([&ring]() {
+        for (int index = 0; index < recordsCount; ++index)
+        {
+            const std::string message = std::to_string(index);
+            while (!writeRecord(ring, message))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::vector<char> bytes;
+    std::size_t recordsBytes = 0;
+    for (int index = 0; index < recordsCount; ++index)
+    {
+        recordsBytes += sizeof(uint32_t) + std::to_string(index).size();
+    }
+    while (bytes.size() < recordsBytes)
+    {
+        if (consumeAll(ring, bytes) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    const auto records = parseRecords(bytes);
+    ASSERT_EQ(records.size(), static_cast<std::size_t>(recordsCount));
+    for (int index = 0; index < recordsCount; ++index)
+    {
+        EXPECT_EQ(records[index], std::to_string(index));
+    }
+}
+
+TEST(LogRingBuffer, grownRingIsConsumedAfterOldOne)
+{
+    // LogOverflowPolicy::Grow: the producer links a bigger ring and moves to it, the consumer finishes the old one first
+    LogRingBuffer ring(64);
+    ASSERT_TRUE(writeRecord(ring, std::string(40, 'a')));
+    ASSERT_FALSE(writeRecord(ring, std::string(40, 'b')));
+
+    LogRingBuffer grownRing(ring.capacity() * 2);
+    ASSERT_TRUE(writeRecord(grownRing, std::string(40, 'b')));
+    ring.next.store(&grownRing, std::memory_order_release);
+    ASSERT_TRUE(writeRecord(grownRing, std::string(40, 'c')));
+
+    std::vector<char> bytes;
+    LogRingBuffer* consumerRing = &ring;
+    while (consumerRing)
+    {
+        consumeAll(*consumerRing, bytes);
+        consumerRing = consumerRing->next.load(std::memory_order_acquire);
+    }
+    EXPECT_EQ(grownRing.capacity(), 128u);
+    EXPECT_EQ(parseRecords(bytes), (std::vector<std::string>{std::string(40, 'a'), std::string(40, 'b'), std::string(40, 'c')}));
+}
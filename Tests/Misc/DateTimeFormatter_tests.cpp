@@ -0,0 +1,106 @@
+/*
+ *  DateTimeFormatter_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Misc/DateTimeFormatter.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace
+{
+std::string printCached(const Kompot::DateTimeFormatter& formatter, std::chrono::system_clock::time_point timePoint)
+{
+    std::ostringstream stream;
+    formatter.printTime(stream, timePoint);
+    return stream.str();
+}
+
+std::string printUncached(const Kompot::DateTimeFormatter& formatter, std::chrono::system_clock::time_point timePoint)
+{
+    std::ostringstream stream;
+    formatter.printTimeUncached(stream, timePoint);
+    return stream.str();
+}
+
+} // namespace
+
+TEST(DateTimeFormatter, cachedEqualsUncached)
+{
+    Kompot::DateTimeFormatter formatter;
+    const auto start = std::chrono::system_clock::time_point(1'600'000'000'000ms);
+
+    // crosses several seconds, also the cached second is reused
+    for (auto offset = 0ms; offset < 3000ms; offset += 7ms)
+    {
+        const auto cached = printCached(formatter, start + offset);
+        EXPECT_EQ(cached, printUncached(formatter, start + offset));
+        EXPECT_EQ(cached, printCached(formatter, start + offset));
+    }
+}
+
+TEST(DateTimeFormatter, millisecondsArePadded)
+{
+    Kompot::DateTimeFormatter formatter;
+    const auto result = printCached(formatter, std::chrono::system_clock::time_point(1'600'000'000'007ms));
+    ASSERT_GE(result.size(), 4u);
+    EXPECT_EQ(result.substr(result.size() - 4), ".007");
+}
+
+TEST(DateTimeFormatter, formatChangeResetsCache)
+{
+    using Format = Kompot::DateTimeFormat;
+
+    Kompot::DateTimeFormatter formatter;
+    const auto timePoint = std::chrono::system_clock::time_point(1'600'000'000'042ms);
+    printCached(formatter, timePoint);
+
+    formatter.setFormat(Format(std::to_array({Format::MillisecondsShort, Format::Space, Format::MillisecondsShort, Format::Dot})));
+    EXPECT_EQ(printCached(formatter, timePoint), "42 42.");
+}
+
+TEST(DateTimeFormatter, compiledEqualsRuntime)
+{
+    using Format = Kompot::DateTimeFormat;
+    using CompiledFormat =
+        Kompot::CompiledDateTimeFormat<Format::WeeklyNameShort, Format::Comma, Format::Space, Format::Hours12, Format::DayPartName, Format::Dot, Format::MillisecondsShort>;
+    static_assert(CompiledFormat::maxLength == 3 + 1 + 1 + 2 + 2 + 1 + 3);
+
+    Kompot::DateTimeFormatter compiledFormatter;
+    compiledFormatter.setFormat(CompiledFormat{});
+    ASSERT_NE(compiledFormatter.getFormat().compiledRender, nullptr);
+
+    // print() formats without the formatter
+    std::tm parsedTime{};
+    parsedTime.tm_wday = 3;
+    parsedTime.tm_hour = 15;
+    std::array<char, CompiledFormat::maxLength> buffer;
+    const char* end = CompiledFormat::print(buffer.data(), parsedTime, 42);
+    EXPECT_EQ(std::string_view(buffer.data(), end - buffer.data()), "Wed, 03PM.42");
+
+    Kompot::DateTimeFormatter runtimeFormatter;
+    runtimeFormatter.setFormat(Format(std::to_array(
+        {Format::WeeklyNameShort, Format::Comma, Format::Space, Format::Hours12, Format::DayPartName, Format::Dot, Format::MillisecondsShort})));
+
+    const auto start = std::chrono::system_clock::time_point(1'600'000'000'000ms);
+    for (auto offset = 0h; offset < 48h; offset += 1h)
+    {
+        EXPECT_EQ(printCached(compiledFormatter, start + offset + 5ms), printCached(runtimeFormatter, start + offset + 5ms));
+    }
+}
+
+TEST(DateTimeFormatter, longFormat)
+{
+    using Format = Kompot::DateTimeFormat;
+
+    // doesn't fit into the cache, the formatter falls back to rendering every specifier
+    std::array<Format::FormatSpecifier, 64> longFormat;
+    longFormat.fill(Format::MonthName);
+    longFormat.back() = Format::Milliseconds;
+
+    Kompot::DateTimeFormatter formatter;
+    formatter.setFormat(Format(longFormat));
+    const auto timePoint = std::chrono::system_clock::time_point(1'600'000'000'042ms);
+    EXPECT_EQ(printCached(formatter, timePoint), printUncached(formatter, timePoint));
+}
@@ -0,0 +1,40 @@
+/*
+ *  Hash_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Misc/Hash.hpp>
+#include <gtest/gtest.h>
+#include <array>
+
+// reference values are from the xxHash library
+TEST(xxHash64, empty)
+{
+    EXPECT_EQ(Kompot::Hash::xxHash64(""), 0xEF46DB3751D8E999ull);
+}
+
+TEST(xxHash64, shortInputs)
+{
+    EXPECT_EQ(Kompot::Hash::xxHash64("a"), 0xD24EC4F1A98C6E5Bull);
+    EXPECT_EQ(Kompot::Hash::xxHash64("abc"), 0x44BC2CF5AD770999ull);
+}
+
+TEST(xxHash64, longInput)
+{
+    // goes through the 32 bytes stripes and all the tails
+    EXPECT_EQ(Kompot::Hash::xxHash64("Nobody inspects the spammish repetition"), 0xFBCEA83C8A378BF1ull);
+
+    std::array<unsigned char, 100> bytes{};
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+    {
+        bytes[i] = static_cast<unsigned char>(i);
+    }
+    EXPECT_EQ(Kompot::Hash::xxHash64(bytes.data(), bytes.size()), 0x6AC1E58032166597ull);
+}
+
+TEST(xxHash64, seed)
+{
+    EXPECT_EQ(Kompot::Hash::xxHash64("abc", 1), 0xBEA9CA8199328908ull);
+    EXPECT_NE(Kompot::Hash::xxHash64("abc", 1), Kompot::Hash::xxHash64("abc"));
+}
@@ -0,0 +1,84 @@
+/*
+ *  GpuTimings_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/ClientSubsystem/Renderer/GpuTimings.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+using namespace Kompot::Rendering;
+
+TEST(GpuTimings, convertsTicksByPeriod)
+{
+    // "Frame" around a nested "Draw", the queries are reserved in pairs as VulkanGpuProfiler does
+    const std::vector<GpuTimestampScope> scopes = {{"Frame", 0, 0, 1}, {"Draw", 1, 2, 3}};
+    const std::vector<uint64_t> timestamps      = {1000, 5000, 2000, 3000};
+
+    const auto frame = getGpuFrameTimings(7, scopes, timestamps, 2.5, 64);
+
+    EXPECT_EQ(frame.frameNumber, 7u);
+    EXPECT_DOUBLE_EQ(frame.beginUs, 2.5);
+    EXPECT_DOUBLE_EQ(frame.durationMs, 0.01);
+    ASSERT_EQ(frame.scopes.size(), 2u);
+
+    EXPECT_EQ(frame.scopes[0].name, "Frame");
+    EXPECT_EQ(frame.scopes[0].depth, 0u);
+    EXPECT_DOUBLE_EQ(frame.scopes[0].beginMs, 0.0);
+    EXPECT_DOUBLE_EQ(frame.scopes[0].durationMs, 0.01);
+
+    EXPECT_EQ(frame.scopes[1].name, "Draw");
+    EXPECT_EQ(frame.scopes[1].depth, 1u);
+    EXPECT_DOUBLE_EQ(frame.scopes[1].beginMs, 0.0025);
+    EXPECT_DOUBLE_EQ(frame.scopes[1].durationMs, 0.0025);
+}
+
+TEST(GpuTimings, handlesCounterWraparound)
+{
+    // 36 valid bits, the counter wraps between the begin and the end, the upper bits are garbage
+    constexpr uint64_t wrap                     = uint64_t(1) << 36;
+    const std::vector<GpuTimestampScope> scopes = {{"Frame", 0, 0, 1}};
+    const std::vector<uint64_t> timestamps      = {wrap - 100, (uint64_t(0xABC) << 36) | 300};
+
+    const auto frame = getGpuFrameTimings(0, scopes, timestamps, 1.0, 36);
+
+    ASSERT_EQ(frame.scopes.size(), 1u);
+    EXPECT_DOUBLE_EQ(frame.scopes[0].durationMs, 400.0 / 1'000'000.0);
+    EXPECT_DOUBLE_EQ(frame.durationMs, frame.scopes[0].durationMs);
+}
+
+TEST(GpuTimings, skipsUnsupportedTimestamps)
+{
+    const std::vector<GpuTimestampScope> scopes = {{"Frame", 0, 0, 1}};
+    const std::vector<uint64_t> timestamps      = {10, 20};
+
+    EXPECT_TRUE(getGpuFrameTimings(1, scopes, timestamps, 1.0, 0).scopes.empty());
+    EXPECT_TRUE(getGpuFrameTimings(1, scopes, {}, 1.0, 64).scopes.empty());
+}
+
+TEST(GpuTimings, writesChromeTrace)
+{
+    GpuFrameTimings frame;
+    frame.frameNumber = 3;
+    frame.beginUs     = 100.0;
+    frame.durationMs  = 0.5;
+    frame.scopes.push_back(GpuScopeTiming{"Pass \"main\"", 0, 0.25, 0.5});
+
+    std::ostringstream output;
+    writeChromeTrace(output, std::span(&frame, 1));
+
+    const std::string trace = output.str();
+    EXPECT_EQ(trace.find("{\"traceEvents\":["), 0u);
+    EXPECT_NE(trace.find("\"name\":\"Pass \\\"main\\\"\""), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\":\"X\",\"ts\":350.000,\"dur\":500.000"), std::string::npos);
+    EXPECT_NE(trace.find("\"args\":{\"frame\":3,\"depth\":0}"), std::string::npos);
+}
+
+TEST(GpuTimings, writesEmptyChromeTrace)
+{
+    std::ostringstream output;
+    writeChromeTrace(output, {});
+    EXPECT_EQ(output.str(), "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n");
+}
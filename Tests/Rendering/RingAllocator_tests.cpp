@@ -0,0 +1,83 @@
+/*
+ *  RingAllocator_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/ClientSubsystem/Renderer/RingAllocator.hpp>
+#include <gtest/gtest.h>
+
+using namespace Kompot::Rendering;
+
+TEST(RingAllocator, allocatesAligned)
+{
+    RingAllocator allocator(256);
+
+    EXPECT_EQ(allocator.allocate(10, 16), 0u);
+    EXPECT_EQ(allocator.allocate(10, 16), 16u);
+    EXPECT_EQ(allocator.allocate(4, 12), 36u);
+    EXPECT_EQ(allocator.allocate(1, 1), 40u);
+    EXPECT_FALSE(allocator.isEmpty());
+}
+
+TEST(RingAllocator, rejectsWhatNeverFits)
+{
+    RingAllocator allocator(64);
+
+    EXPECT_FALSE(allocator.allocate(65, 1));
+    EXPECT_FALSE(allocator.allocate(0, 1));
+    EXPECT_EQ(allocator.allocate(64, 1), 0u);
+    EXPECT_FALSE(allocator.allocate(1, 1));
+}
+
+TEST(RingAllocator, wrapsAfterRelease)
+{
+    RingAllocator allocator(100);
+
+    EXPECT_EQ(allocator.allocate(40, 1), 0u);
+    const auto firstBatch = allocator.getMarker();
+    EXPECT_EQ(allocator.allocate(40, 1), 40u);
+    const auto secondBatch = allocator.getMarker();
+
+    // the end has 20 bytes only and the beginning is still in use
+    EXPECT_FALSE(allocator.allocate(30, 1));
+
+    allocator.release(firstBatch);
+    EXPECT_EQ(allocator.allocate(30, 1), 0u);
+    // between the wrapped head and the second batch
+    EXPECT_EQ(allocator.allocate(10, 1), 30u);
+    EXPECT_FALSE(allocator.allocate(1, 1));
+
+    // the 20 bytes skipped at the end are reused once the wrapped allocations are released
+    allocator.release(secondBatch);
+    EXPECT_EQ(allocator.allocate(40, 1), 40u);
+    EXPECT_FALSE(allocator.allocate(1, 1));
+}
+
+TEST(RingAllocator, restartsWhenEmpty)
+{
+    RingAllocator allocator(100);
+
+    EXPECT_EQ(allocator.allocate(70, 1), 0u);
+    allocator.release(allocator.getMarker());
+    EXPECT_TRUE(allocator.isEmpty());
+
+    // would neither fit after the previous allocation nor before it
+    EXPECT_EQ(allocator.allocate(80, 1), 0u);
+}
+
+TEST(RingAllocator, ignoresStaleMarkers)
+{
+    RingAllocator allocator(100);
+
+    const auto emptyMarker = allocator.getMarker();
+    EXPECT_EQ(allocator.allocate(50, 1), 0u);
+    const auto marker = allocator.getMarker();
+    EXPECT_EQ(allocator.allocate(50, 1), 50u);
+
+    allocator.release(emptyMarker);
+    allocator.release(marker);
+    allocator.release(emptyMarker);
+    EXPECT_FALSE(allocator.isEmpty());
+    EXPECT_EQ(allocator.allocate(50, 1), 0u);
+}
@@ -0,0 +1,263 @@
+/*
+ *  ShaderReflection_tests.cpp
+ *  Copyright (C) 2021 by Maxim Stoianov
+ *  Licensed under the MIT license.
+ */
+
+#include <Engine/ClientSubsystem/Renderer/Shaders/ShaderReflection.hpp>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+
+using namespace Kompot::Rendering;
+
+namespace
+{
+// assembles SPIR-V by hand, the ids are fixed so the expectations are easy to follow
+class SpirvBuilder
+{
+public:
+    explicit SpirvBuilder(uint32_t idsBound) : mCode{0x07230203, 0x00010500, 0, idsBound, 0}
+    {
+    }
+
+    SpirvBuilder& add(uint32_t opcode, std::initializer_list<uint32_t> operands)
+    {
+        mCode.push_back(static_cast<uint32_t>(operands.size() + 1) << 16 | opcode);
+        mCode.insert(mCode.end(), operands);
+        return *this;
+    }
+
+    SpirvBuilder& addEntryPoint(uint32_t executionModel, uint32_t functionId, std::string_view name)
+    {
+        std::vector<uint32_t> nameWords((name.size() + 4) / 4, 0);
+        std::memcpy(nameWords.data(), name.data(), name.size());
+
+        mCode.push_back(static_cast<uint32_t>(nameWords.size() + 3) << 16 | 15);
+        mCode.push_back(executionModel);
+        mCode.push_back(functionId);
+        mCode.insert(mCode.end(), nameWords.begin(), nameWords.end());
+        return *this;
+    }
+
+    const std::vector<uint32_t>& getCode() const
+    {
+        return mCode;
+    }
+
+private:
+    std::vector<uint32_t> mCode;
+};
+
+// opcodes, decorations and storage classes of the SPIR-V specification
+enum : uint32_t
+{
+    OpTypeVoid          = 19,
+    OpTypeBool          = 20,
+    OpTypeInt           = 21,
+    OpTypeFloat         = 22,
+    OpTypeVector        = 23,
+    OpTypeMatrix        = 24,
+    OpTypeImage         = 25,
+    OpTypeSampledImage  = 27,
+    OpTypeArray         = 28,
+    OpTypeRuntimeArray  = 29,
+    OpTypeStruct        = 30,
+    OpTypePointer       = 32,
+    OpTypeFunction      = 33,
+    OpConstant          = 43,
+    OpSpecConstantTrue  = 48,
+    OpSpecConstant      = 50,
+    OpFunction          = 54,
+    OpVariable          = 59,
+    OpDecorate          = 71,
+    OpMemberDecorate    = 72,
+
+    SpecId        = 1,
+    Block         = 2,
+    BufferBlock   = 3,
+    ArrayStride   = 6,
+    MatrixStride  = 7,
+    BuiltIn       = 11,
+    Location      = 30,
+    Binding       = 33,
+    DescriptorSet = 34,
+    Offset        = 35,
+
+    UniformConstant = 0,
+    Input           = 1,
+    Uniform         = 2,
+    PushConstant    = 9
+};
+
+std::vector<uint32_t> makeVertexShader()
+{
+    SpirvBuilder builder(45);
+    builder.addEntryPoint(0, 1, "main")
+            .add(OpDecorate, {11, Binding, 0})
+            .add(OpDecorate, {11, DescriptorSet, 1})
+            .add(OpDecorate, {9, Block})
+            .add(OpMemberDecorate, {9, 0, Offset, 0})
+            .add(OpMemberDecorate, {9, 0, MatrixStride, 16})
+            .add(OpDecorate, {18, Binding, 1})
+            .add(OpDecorate, {21, Binding, 2})
+            .add(OpDecorate, {22, Block})
+            .add(OpMemberDecorate, {22, 0, Offset, 0})
+            .add(OpMemberDecorate, {22, 0, MatrixStride, 16})
+            .add(OpMemberDecorate, {22, 1, Offset, 64})
+            .add(OpDecorate, {26, Location, 0})
+            .add(OpDecorate, {28, Location, 1})
+            .add(OpDecorate, {30, Location, 2})
+            .add(OpDecorate, {32, BuiltIn, 42})
+            .add(OpDecorate, {33, SpecId, 7})
+            .add(OpDecorate, {35, SpecId, 3})
+            .add(OpDecorate, {36, ArrayStride, 4})
+            .add(OpDecorate, {37, BufferBlock})
+            .add(OpMemberDecorate, {37, 0, Offset, 0})
+            .add(OpDecorate, {39, Binding, 1})
+            .add(OpDecorate, {39, DescriptorSet, 1})
+            .add(OpTypeVoid, {2})
+            .add(OpTypeFloat, {3, 32})
+            .add(OpTypeVector, {4, 3, 4})
+            .add(OpTypeMatrix, {5, 4, 4})
+            .add(OpTypeVector, {6, 3, 3})
+            .add(OpTypeInt, {7, 32, 1})
+            .add(OpTypeVector, {8, 7, 2})
+            .add(OpTypeStruct, {9, 5})
+            .add(OpTypePointer, {10, Uniform, 9})
+            .add(OpVariable, {10, 11, Uniform})
+            .add(OpTypeImage, {12, 3, 1, 0, 0, 0, 1, 0})
+            .add(OpTypeSampledImage, {13, 12})
+            .add(OpTypeInt, {14, 32, 0})
+            .add(OpConstant, {14, 15, 4})
+            .add(OpTypeArray, {16, 13, 15})
+            .add(OpTypePointer, {17, UniformConstant, 16})
+            .add(OpVariable, {17, 18, UniformConstant})
+            .add(OpTypeImage, {19, 3, 1, 0, 0, 0, 2, 4})
+            .add(OpTypePointer, {20, UniformConstant, 19})
+            .add(OpVariable, {20, 21, UniformConstant})
+            .add(OpTypeStruct, {22, 5, 4})
+            .add(OpTypePointer, {23, PushConstant, 22})
+            .add(OpVariable, {23, 24, PushConstant})
+            .add(OpTypePointer, {25, Input, 6})
+            .add(OpVariable, {25, 26, Input})
+            .add(OpTypePointer, {27, Input, 8})
+            .add(OpVariable, {27, 28, Input})
+            .add(OpTypePointer, {29, Input, 5})
+            .add(OpVariable, {29, 30, Input})
+            .add(OpTypePointer, {31, Input, 7})
+            .add(OpVariable, {31, 32, Input})
+            .add(OpSpecConstant, {7, 33, 42})
+            .add(OpTypeBool, {34})
+            .add(OpSpecConstantTrue, {34, 35})
+            .add(OpTypeRuntimeArray, {36, 3})
+            .add(OpTypeStruct, {37, 36})
+            .add(OpTypePointer, {38, Uniform, 37})
+            .add(OpVariable, {38, 39, Uniform})
+            .add(OpTypeFunction, {40, 2})
+            .add(OpFunction, {2, 1, 0, 40});
+    return builder.getCode();
+}
+} // namespace
+
+TEST(ShaderReflection, stage)
+{
+    const auto reflection = ShaderReflection::reflect(makeVertexShader());
+    ASSERT_TRUE(reflection);
+    EXPECT_EQ(reflection->stage, ShaderStage::Vertex);
+}
+
+TEST(ShaderReflection, resourceBindings)
+{
+    const auto reflection = ShaderReflection::reflect(makeVertexShader());
+    ASSERT_TRUE(reflection);
+    ASSERT_EQ(reflection->resourceBindings.size(), 4u);
+
+    const auto& bindings = reflection->resourceBindings;
+    EXPECT_EQ(bindings[0].set, 0u);
+    EXPECT_EQ(bindings[0].binding, 1u);
+    EXPECT_EQ(bindings[0].type, ShaderResourceType::CombinedImageSampler);
+    EXPECT_EQ(bindings[0].count, 4u);
+
+    EXPECT_EQ(bindings[1].set, 0u);
+    EXPECT_EQ(bindings[1].binding, 2u);
+    EXPECT_EQ(bindings[1].type, ShaderResourceType::StorageImage);
+
+    EXPECT_EQ(bindings[2].set, 1u);
+    EXPECT_EQ(bindings[2].binding, 0u);
+    EXPECT_EQ(bindings[2].type, ShaderResourceType::UniformBuffer);
+    EXPECT_EQ(bindings[2].count, 1u);
+
+    EXPECT_EQ(bindings[3].set, 1u);
+    EXPECT_EQ(bindings[3].binding, 1u);
+    EXPECT_EQ(bindings[3].type, ShaderResourceType::StorageBuffer);
+}
+
+TEST(ShaderReflection, pushConstants)
+{
+    const auto reflection = ShaderReflection::reflect(makeVertexShader());
+    ASSERT_TRUE(reflection);
+    ASSERT_TRUE(reflection->pushConstants);
+
+    // mat4 with the matrix stride of 16 and vec4 at 64
+    EXPECT_EQ(reflection->pushConstants->offset, 0u);
+    EXPECT_EQ(reflection->pushConstants->size, 80u);
+}
+
+TEST(ShaderReflection, vertexInputs)
+{
+    const auto reflection = ShaderReflection::reflect(makeVertexShader());
+    ASSERT_TRUE(reflection);
+
+    // vec3, ivec2 and a mat4 taking a location per column, the built-in gl_VertexIndex isn't an input
+    const auto& inputs = reflection->vertexInputs;
+    ASSERT_EQ(inputs.size(), 6u);
+    EXPECT_EQ(inputs[0].location, 0u);
+    EXPECT_EQ(inputs[0].scalarType, ShaderScalarType::Float);
+    EXPECT_EQ(inputs[0].componentsCount, 3u);
+    EXPECT_EQ(inputs[1].location, 1u);
+    EXPECT_EQ(inputs[1].scalarType, ShaderScalarType::Int);
+    EXPECT_EQ(inputs[1].componentsCount, 2u);
+    for (uint32_t i = 2; i < 6; ++i)
+    {
+        EXPECT_EQ(inputs[i].location, i);
+        EXPECT_EQ(inputs[i].scalarType, ShaderScalarType::Float);
+        EXPECT_EQ(inputs[i].bitWidth, 32u);
+        EXPECT_EQ(inputs[i].componentsCount, 4u);
+    }
+}
+
+TEST(ShaderReflection, specializationConstants)
+{
+    const auto reflection = ShaderReflection::reflect(makeVertexShader());
+    ASSERT_TRUE(reflection);
+
+    const auto& constants = reflection->specializationConstants;
+    ASSERT_EQ(constants.size(), 2u);
+    EXPECT_EQ(constants[0].id, 3u);
+    EXPECT_EQ(constants[0].scalarType, ShaderScalarType::Bool);
+    EXPECT_EQ(constants[0].defaultValue, 1u);
+    EXPECT_EQ(constants[1].id, 7u);
+    EXPECT_EQ(constants[1].scalarType, ShaderScalarType::Int);
+    EXPECT_EQ(constants[1].defaultValue, 42u);
+}
+
+TEST(ShaderReflection, malformed)
+{
+    EXPECT_FALSE(ShaderReflection::reflect({}));
+
+    auto code = makeVertexShader();
+    code[0]   = 0x12345678;
+    EXPECT_FALSE(ShaderReflection::reflect(code));
+
+    // the last instruction runs past the end
+    code = makeVertexShader();
+    code.pop_back();
+    EXPECT_FALSE(ShaderReflection::reflect(code));
+
+    // more ids than words
+    code    = makeVertexShader();
+    code[3] = static_cast<uint32_t>(code.size() + 1);
+    EXPECT_FALSE(ShaderReflection::reflect(code));
+}